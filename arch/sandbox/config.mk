@@ -18,4 +18,4 @@
 # MA 02111-1307 USA
 
 PLATFORM_CPPFLAGS += -DCONFIG_SANDBOX -D__SANDBOX__ -U_FORTIFY_SOURCE
-PLATFORM_LIBS += -lrt
+PLATFORM_LIBS += -lrt -lpthread
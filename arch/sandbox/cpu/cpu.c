@@ -60,3 +60,29 @@ void *map_physmem(phys_addr_t paddr, unsigned long len, unsigned long flags)
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 }
+
+#ifdef CONFIG_FIT_PARALLEL_VERIFY
+/* Secondary cores are emulated with host threads */
+int cpu_job_cores(void)
+{
+	return CONFIG_SANDBOX_JOB_CORES;
+}
+
+int cpu_start_job(int nr, void (*fn)(void *arg), void *arg)
+{
+	return os_thread_start(nr, fn, arg);
+}
+
+void cpu_wait_job(int nr)
+{
+	os_thread_join(nr);
+}
+
+int cpu_job_current(void)
+{
+	int slot = os_thread_current();
+
+	/* core nr runs in thread slot nr, the boot CPU is the main thread */
+	return slot ? slot - 1 : 0;
+}
+#endif
@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <termios.h>
 #include <time.h>
@@ -160,6 +161,50 @@ u64 os_get_nsec(void)
 #endif
 }
 
+/* Host threads standing in for secondary CPUs */
+#define OS_MAX_THREADS	8
+
+static struct {
+	pthread_t thread;
+	void (*fn)(void *arg);
+	void *arg;
+} os_threads[OS_MAX_THREADS];
+
+/* slot plus one of the thread running, 0 in the main thread */
+static __thread int os_thread_self;
+
+static void *os_thread_entry(void *arg)
+{
+	int id = (long)arg;
+
+	os_thread_self = id + 1;
+	os_threads[id].fn(os_threads[id].arg);
+
+	return NULL;
+}
+
+int os_thread_start(int id, void (*fn)(void *arg), void *arg)
+{
+	if (id < 0 || id >= OS_MAX_THREADS)
+		return -1;
+
+	os_threads[id].fn = fn;
+	os_threads[id].arg = arg;
+
+	return pthread_create(&os_threads[id].thread, NULL, os_thread_entry,
+			      (void *)(long)id) ? -1 : 0;
+}
+
+void os_thread_join(int id)
+{
+	pthread_join(os_threads[id].thread, NULL);
+}
+
+int os_thread_current(void)
+{
+	return os_thread_self;
+}
+
 static char *short_opts;
 static struct option *long_opts;
 
@@ -32,6 +32,17 @@
 
 void *map_physmem(phys_addr_t paddr, unsigned long len, unsigned long flags);
 
+/*
+ * Generic code such as nand_base.c has default accessors for memory-mapped
+ * devices. Sandbox has no such devices; these just access host memory.
+ */
+#define readb(addr)		(*(volatile u8 *)(addr))
+#define readw(addr)		(*(volatile u16 *)(addr))
+#define readl(addr)		(*(volatile u32 *)(addr))
+#define writeb(v, addr)		(*(volatile u8 *)(addr) = (v))
+#define writew(v, addr)		(*(volatile u16 *)(addr) = (v))
+#define writel(v, addr)		(*(volatile u32 *)(addr) = (v))
+
 /*
  * Take down a mapping set up by map_physmem().
  */
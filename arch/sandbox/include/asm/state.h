@@ -38,6 +38,8 @@ struct sandbox_state {
 	const char *parse_err;		/* Error to report from parsing */
 	int argc;			/* Program arguments */
 	char **argv;
+	const char *spi_sf;		/* Host file backing the SPI flash */
+	const char *nand;		/* Host file backing the NAND chip */
 };
 
 /**
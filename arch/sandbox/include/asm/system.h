@@ -24,13 +24,10 @@
 #define __ASM_SANDBOX_SYSTEM_H
 
 /* Define this as nops for sandbox architecture */
-static inline void local_irq_save(unsigned flags __attribute__((unused)))
-{
-}
-
+#define local_irq_save(x)	do { (x) = 0; } while (0)
 #define local_irq_enable()
 #define local_irq_disable()
-#define local_save_flags(x)
-#define local_irq_restore(x)
+#define local_save_flags(x)	do { (x) = 0; } while (0)
+#define local_irq_restore(x)	do { (void)(x); } while (0)
 
 #endif
@@ -40,6 +40,7 @@
 #include <common.h>
 #include <command.h>
 #include <malloc.h>
+#include <nand.h>
 #include <stdio_dev.h>
 #include <timestamp.h>
 #include <version.h>
@@ -230,6 +231,11 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	mem_malloc_init((ulong)gd->ram_buf + gd->ram_size - TOTAL_MALLOC_LEN,
 			TOTAL_MALLOC_LEN);
 
+#if defined(CONFIG_CMD_NAND)
+	puts("NAND:  ");
+	nand_init();		/* go init the NAND */
+#endif
+
 	/* initialize environment */
 	env_relocate();
 
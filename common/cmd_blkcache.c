@@ -0,0 +1,68 @@
+/*
+ * (C) Copyright 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Block device read cache statistics
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct blkcache_stats st;
+	unsigned long total;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "flush")) {
+			blkcache_invalidate(NULL);
+			blkcache_reset_stats();
+			return CMD_RET_SUCCESS;
+		}
+		if (strcmp(argv[1], "info"))
+			return CMD_RET_USAGE;
+	}
+
+	blkcache_get_stats(&st);
+	total = st.hits + st.misses;
+	printf("entries: %d used, %d total, up to %d blocks each\n",
+	       st.used, st.entries, st.max_blks);
+	printf("hits:    %lu\n", st.hits);
+	printf("misses:  %lu\n", st.misses);
+	if (total)
+		printf("hit rate: %lu%%\n", st.hits * 100 / total);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	blkcache,	2,	1,	do_blkcache,
+	"block device read cache",
+	"[info]\n"
+	"    - show hit/miss statistics of the block device read cache\n"
+	"blkcache flush\n"
+	"    - drop all cached blocks and clear the statistics"
+);
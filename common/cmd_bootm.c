@@ -190,7 +190,8 @@ static void boot_start_lmb(bootm_headers_t *images)
 static inline void boot_start_lmb(bootm_headers_t *images) { }
 #endif
 
-static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+static int __bootm_start(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
 {
 	void		*os_hdr;
 	int		ret;
@@ -311,6 +312,18 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 	return 0;
 }
 
+static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = __bootm_start(cmdtp, flag, argc, argv);
+
+	/* hashes computed ahead for this boot must not outlive it */
+	fit_drop_hashes();
+
+	return ret;
+}
+
 #define BOOTM_ERR_RESET		-1
 #define BOOTM_ERR_OVERLAP	-2
 #define BOOTM_ERR_UNIMPLEMENTED	-3
@@ -400,12 +413,14 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	}
 #endif /* CONFIG_LZMA */
 #ifdef CONFIG_LZO
-	case IH_COMP_LZO:
+	case IH_COMP_LZO: {
+		size_t size;
+
 		printf("   Uncompressing %s ... ", type_name);
 
 		ret = lzop_decompress((const unsigned char *)image_start,
 					  image_len, (unsigned char *)load,
-					  &unc_len);
+					  &size);
 		if (ret != LZO_E_OK) {
 			printf("LZO: uncompress or overwrite error %d "
 			      "- must RESET board to recover\n", ret);
@@ -414,8 +429,9 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 			return BOOTM_ERR_RESET;
 		}
 
-		*load_end = load + unc_len;
+		*load_end = load + size;
 		break;
+	}
 #endif /* CONFIG_LZO */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
@@ -440,6 +456,178 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	return 0;
 }
 
+#ifdef CONFIG_CMD_LOADZ
+/* Compressed data of a legacy image, read through bootm_stream_read() */
+struct bootm_stream {
+	stream_read_fn read;
+	void *priv;
+	ulong left;		/* bytes of image data not read yet */
+	uint32_t dcrc;		/* CRC32 of the image data read so far */
+};
+
+static int bootm_stream_read(void *priv, void *buf, int len)
+{
+	struct bootm_stream *s = priv;
+	int n;
+
+	if (len > s->left)
+		len = s->left;
+	n = s->read(s->priv, buf, len);
+	if (n > 0) {
+		s->dcrc = crc32(s->dcrc, buf, n);
+		s->left -= n;
+	}
+
+	return n;
+}
+
+/*
+ * Decompress a stream of type comp to load. *len gives the room available
+ * at load and returns the uncompressed size.
+ */
+static int bootm_decomp_stream(int comp, ulong load, ulong *len,
+			       stream_read_fn read, void *priv)
+{
+	ulong room = *len;
+	ulong chunk;
+	int ret, n;
+	char c;
+
+	switch (comp) {
+	case IH_COMP_NONE:
+		*len = 0;
+		do {
+			chunk = min(room - *len, (ulong)CHUNKSZ);
+			if (chunk == 0) {
+				/* make sure nothing is left over */
+				n = read(priv, &c, 1);
+				if (n == 0)
+					break;
+				puts("Image too large\n");
+				return -1;
+			}
+			n = read(priv, (void *)(load + *len), chunk);
+			if (n < 0)
+				return -1;
+			*len += n;
+			WATCHDOG_RESET();
+		} while (n == chunk);
+		return 0;
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		return gunzip_stream((void *)load, room, read, priv, len);
+#endif /* CONFIG_GZIP */
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA: {
+		SizeT lzma_len = room;
+
+		ret = lzmaStreamDecompress((unsigned char *)load, &lzma_len,
+					   read, priv);
+		*len = lzma_len;
+		if (ret != SZ_OK) {
+			printf("LZMA: uncompress error %d\n", ret);
+			return -1;
+		}
+		return 0;
+	}
+#endif /* CONFIG_LZMA */
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO: {
+		size_t lzo_len = room;
+
+		ret = lzop_decompress_stream(read, priv,
+					     (unsigned char *)load, &lzo_len);
+		*len = lzo_len;
+		if (ret != LZO_E_OK) {
+			printf("LZO: uncompress error %d\n", ret);
+			return -1;
+		}
+		return 0;
+	}
+#endif /* CONFIG_LZO */
+	default:
+		printf("Unimplemented compression type %d\n", comp);
+		return -1;
+	}
+}
+
+/**
+ * bootm_load_stream() - load an image from storage, uncompressing on the fly
+ * @addr: address to load the image to
+ * @read: callback supplying the file contents in order
+ * @priv: private data for @read
+ * @comp: IH_COMP_* type of a raw compressed file, or -1 for a legacy image
+ * @lenp: returns the number of bytes stored at @addr
+ *
+ * The compressed data is fed to the decompressor in chunks as it is read,
+ * so it never has to be staged in memory as a whole. A legacy image keeps
+ * its header at @addr, followed by the uncompressed data; the header is
+ * rewritten to describe an uncompressed image, so "bootm @addr" boots it
+ * in place when @addr + 64 is the load address.
+ *
+ * returns:
+ *     0 on success, -1 on error
+ */
+int bootm_load_stream(ulong addr, stream_read_fn read, void *priv, int comp,
+		      ulong *lenp)
+{
+	image_header_t *hdr = (image_header_t *)addr;
+	struct bootm_stream s;
+	ulong load, len = CONFIG_SYS_BOOTM_LEN;
+
+	if (comp >= 0) {
+		if (bootm_decomp_stream(comp, addr, &len, read, priv))
+			return -1;
+		flush_cache(addr, len);
+		*lenp = len;
+		return 0;
+	}
+
+	if (read(priv, hdr, image_get_header_size()) !=
+	    image_get_header_size() || !image_check_magic(hdr)) {
+		puts("Bad Magic Number\n");
+		return -1;
+	}
+	if (!image_check_hcrc(hdr)) {
+		puts("Bad Header Checksum\n");
+		return -1;
+	}
+	image_print_contents(hdr);
+
+	printf("   Uncompressing %s ... ",
+	       genimg_get_type_name(image_get_type(hdr)));
+	s.read = read;
+	s.priv = priv;
+	s.left = image_get_data_size(hdr);
+	s.dcrc = 0;
+	load = image_get_data(hdr);
+	if (bootm_decomp_stream(image_get_comp(hdr), load, &len,
+				bootm_stream_read, &s))
+		return -1;
+	if (s.left) {
+		puts("Image truncated\n");
+		return -1;
+	}
+	if (getenv_yesno("verify") && s.dcrc != image_get_dcrc(hdr)) {
+		puts("Bad Data CRC\n");
+		return -1;
+	}
+	puts("OK\n");
+
+	image_set_comp(hdr, IH_COMP_NONE);
+	image_set_size(hdr, len);
+	image_set_dcrc(hdr, crc32_wd(0, (unsigned char *)load, len,
+				     CHUNKSZ_CRC32));
+	image_set_hcrc(hdr, 0);
+	image_set_hcrc(hdr, crc32(0, (unsigned char *)hdr,
+				  image_get_header_size()));
+	flush_cache(addr, image_get_image_size(hdr));
+	*lenp = image_get_image_size(hdr);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_LOADZ */
+
 static int bootm_start_standalone(ulong iflag, int argc, char * const argv[])
 {
 	char  *s;
@@ -570,6 +758,9 @@ static int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 			 * left it up
 			 */
 			eth_halt();
+#endif
+#ifdef CONFIG_LCD_SHADOW
+			lcd_sync();
 #endif
 			arch_preboot_os();
 			boot_fn(BOOTM_STATE_OS_GO, argc, argv, &images);
@@ -733,6 +924,9 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return 1;
 	}
 
+#ifdef CONFIG_LCD_SHADOW
+	lcd_sync();
+#endif
 	arch_preboot_os();
 
 	boot_fn(0, argc, argv, &images);
@@ -997,6 +1191,16 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 
 			os_noffset = fit_conf_get_kernel_node(fit_hdr,
 								cfg_noffset);
+			if (images->verify) {
+				int nodes[3];
+
+				nodes[0] = os_noffset;
+				nodes[1] = fit_conf_get_ramdisk_node(fit_hdr,
+								cfg_noffset);
+				nodes[2] = fit_conf_get_fdt_node(fit_hdr,
+								cfg_noffset);
+				fit_prepare_hashes(fit_hdr, nodes, 3);
+			}
 			fit_uname_kernel = fit_get_name(fit_hdr, os_noffset,
 							NULL);
 		} else {
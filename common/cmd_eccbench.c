@@ -0,0 +1,306 @@
+/*
+ * (C) Copyright 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Throughput benchmark for the software NAND ECC: Hamming and BCH
+ * encoding, and decoding of clean pages and pages with bitflips
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <div64.h>
+#include <linux/mtd/nand_ecc.h>
+#ifdef CONFIG_BCH
+#include <linux/bch.h>
+#endif
+
+#define ECCBENCH_DEFAULT_PAGE	2048
+#define ECCBENCH_DEFAULT_T	8
+#define ECCBENCH_HAMMING_STEP	256
+#define ECCBENCH_HAMMING_BYTES	3
+#define ECCBENCH_BCH_STEP	512
+/* Galois field order for 512-byte steps, as picked by nand_bch_init() */
+#define ECCBENCH_BCH_M		13
+/* Minimum measuring time per case, in timer ticks */
+#define ECCBENCH_TICKS		(CONFIG_SYS_HZ / 10)
+
+enum eccbench_op {
+	ECCBENCH_ENCODE,
+	ECCBENCH_CLEAN,
+	ECCBENCH_FLIPS,
+};
+
+struct eccbench {
+	u_char *buf;		/* page data */
+	ulong pagesize;
+	u_char *read_ecc;	/* ECC of the original page, for every step */
+	u_char *calc_ecc;
+#ifdef CONFIG_BCH
+	struct bch_control *bch;
+	unsigned int *errloc;
+#endif
+};
+
+/*
+ * Bit to flip in a step, spreading 'count' flips evenly over the step
+ * and over the bit positions within a byte
+ */
+static inline uint eccbench_flip_bit(uint step_bits, uint count, uint i)
+{
+	return i * (step_bits / count) + (i & 7);
+}
+
+/* Process one page with Hamming ECC, returns 0 if the result is correct */
+static int eccbench_hamming(struct eccbench *eb, enum eccbench_op op)
+{
+	u_char *read_ecc = eb->read_ecc;
+	u_char *dat = eb->buf;
+	uint bit;
+	ulong i;
+
+	for (i = 0; i < eb->pagesize; i += ECCBENCH_HAMMING_STEP) {
+		if (op == ECCBENCH_FLIPS) {
+			bit = eccbench_flip_bit(ECCBENCH_HAMMING_STEP * 8, 8,
+						(i / ECCBENCH_HAMMING_STEP) & 7);
+			dat[bit >> 3] ^= 1 << (bit & 7);
+		}
+		nand_calculate_ecc(NULL, dat, eb->calc_ecc);
+		if (op != ECCBENCH_ENCODE &&
+		    nand_correct_data(NULL, dat, read_ecc, eb->calc_ecc) !=
+		    (op == ECCBENCH_FLIPS))
+			return -1;
+		dat += ECCBENCH_HAMMING_STEP;
+		read_ecc += ECCBENCH_HAMMING_BYTES;
+	}
+
+	return 0;
+}
+
+/*
+ * Compare the Hamming ECC of an unaligned copy of the page, which takes the
+ * byte-wise parity path, with read_ecc from the aligned, word-wise one.
+ * Returns 0 if they agree.
+ */
+static int eccbench_hamming_check(struct eccbench *eb, u_char *dat)
+{
+	u_char *read_ecc = eb->read_ecc;
+	ulong i;
+
+	for (i = 0; i < eb->pagesize; i += ECCBENCH_HAMMING_STEP) {
+		nand_calculate_ecc(NULL, dat + i, eb->calc_ecc);
+		if (memcmp(eb->calc_ecc, read_ecc, ECCBENCH_HAMMING_BYTES)) {
+			printf("hamming: unaligned ECC differs at 0x%lx\n", i);
+			return -1;
+		}
+		read_ecc += ECCBENCH_HAMMING_BYTES;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_BCH
+/* Process one page with BCH ECC, returns 0 if the result is correct */
+static int eccbench_bch(struct eccbench *eb, enum eccbench_op op)
+{
+	struct bch_control *bch = eb->bch;
+	u_char *read_ecc = eb->read_ecc;
+	u_char *dat = eb->buf;
+	uint bit, j;
+	int count;
+	ulong i;
+
+	for (i = 0; i < eb->pagesize; i += ECCBENCH_BCH_STEP) {
+		if (op == ECCBENCH_FLIPS) {
+			for (j = 0; j < bch->t; j++) {
+				bit = eccbench_flip_bit(ECCBENCH_BCH_STEP * 8,
+							bch->t, j);
+				dat[bit >> 3] ^= 1 << (bit & 7);
+			}
+		}
+		memset(eb->calc_ecc, 0, bch->ecc_bytes);
+		encode_bch(bch, dat, ECCBENCH_BCH_STEP, eb->calc_ecc);
+		if (op != ECCBENCH_ENCODE) {
+			count = decode_bch(bch, NULL, ECCBENCH_BCH_STEP,
+					   read_ecc, eb->calc_ecc, NULL,
+					   eb->errloc);
+			if (count != (op == ECCBENCH_FLIPS ? bch->t : 0))
+				return -1;
+			for (j = 0; j < count; j++)
+				if (eb->errloc[j] < ECCBENCH_BCH_STEP * 8)
+					dat[eb->errloc[j] >> 3] ^=
+						1 << (eb->errloc[j] & 7);
+		}
+		dat += ECCBENCH_BCH_STEP;
+		read_ecc += bch->ecc_bytes;
+	}
+
+	return 0;
+}
+#endif
+
+/*
+ * Run one case for a while and print pages/s and MB/s. Returns 0 if every
+ * page was corrected back to its original contents.
+ */
+static int eccbench_run(struct eccbench *eb, const char *code,
+			const char *name, enum eccbench_op op,
+			int (*page)(struct eccbench *, enum eccbench_op),
+			const u_char *orig)
+{
+	uint64_t pages = 0;
+	ulong start, ticks, kbs;
+	int ret = 0;
+
+	start = get_timer(0);
+	do {
+		ret |= page(eb, op);
+		pages++;
+		ticks = get_timer(start);
+	} while (ticks < ECCBENCH_TICKS);
+
+	if (op != ECCBENCH_ENCODE && memcmp(eb->buf, orig, eb->pagesize))
+		ret = -1;
+
+	kbs = lldiv(pages * eb->pagesize * CONFIG_SYS_HZ, ticks * 1024);
+	printf("%-8s %-10s %10lu %6lu.%03lu%s\n", code, name,
+	       (ulong)lldiv(pages * CONFIG_SYS_HZ, ticks),
+	       kbs / 1024, (kbs % 1024) * 1000 / 1024,
+	       ret ? "  FAILED" : "");
+
+	return ret;
+}
+
+static int do_eccbench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct eccbench eb;
+	ulong pagesize = ECCBENCH_DEFAULT_PAGE;
+	u_char *mem = NULL, *orig;
+	ulong i, ecc_len;
+	int ret = 0;
+#ifdef CONFIG_BCH
+	int t = ECCBENCH_DEFAULT_T;
+	char code[16], name[16];
+#endif
+
+	if (argc > 3)
+		return CMD_RET_USAGE;
+	if (argc > 1)
+		pagesize = simple_strtoul(argv[1], NULL, 16);
+	if (!pagesize || pagesize % ECCBENCH_BCH_STEP)
+		return CMD_RET_USAGE;
+#ifdef CONFIG_BCH
+	if (argc > 2)
+		t = simple_strtoul(argv[2], NULL, 10);
+	eb.bch = init_bch(ECCBENCH_BCH_M, t, 0);
+	if (!eb.bch) {
+		printf("eccbench: cannot set up BCH with t=%d\n", t);
+		return CMD_RET_FAILURE;
+	}
+	eb.errloc = malloc(t * sizeof(*eb.errloc));
+	if (!eb.errloc) {
+		printf("eccbench: out of memory\n");
+		ret = -1;
+		goto out;
+	}
+	ecc_len = max(eb.bch->ecc_bytes, 2 * ECCBENCH_HAMMING_BYTES);
+#else
+	if (argc > 2)
+		return CMD_RET_USAGE;
+	ecc_len = 2 * ECCBENCH_HAMMING_BYTES;
+#endif
+	/* ECC bytes per 512-byte step, with either code */
+	ecc_len *= pagesize / ECCBENCH_BCH_STEP;
+
+	/* page with room for misalignment, a copy of it, read and calc ECC */
+	eb.pagesize = pagesize;
+	mem = malloc(2 * pagesize + 8 + 2 * ecc_len);
+	if (!mem) {
+		printf("eccbench: out of memory\n");
+		ret = -1;
+		goto out;
+	}
+	orig = mem + pagesize + 8;
+	eb.read_ecc = orig + pagesize;
+	eb.calc_ecc = eb.read_ecc + ecc_len;
+	for (i = 0; i < pagesize; i++)
+		orig[i] = (i * 0x9e3779b1) >> 24;
+
+	printf("%-8s %-10s %10s %10s\n", "code", "op", "pages/s", "MB/s");
+
+	/* Hamming, aligned and unaligned to exercise both parity paths */
+	eb.buf = mem + 1;
+	memcpy(eb.buf, orig, pagesize);
+	ret |= eccbench_run(&eb, "hamming", "unaligned", ECCBENCH_ENCODE,
+			    eccbench_hamming, orig);
+	eb.buf = mem;
+	memcpy(eb.buf, orig, pagesize);
+	ret |= eccbench_run(&eb, "hamming", "encode", ECCBENCH_ENCODE,
+			    eccbench_hamming, orig);
+	for (i = 0; i < pagesize; i += ECCBENCH_HAMMING_STEP)
+		nand_calculate_ecc(NULL, orig + i, eb.read_ecc +
+				   i / ECCBENCH_HAMMING_STEP *
+				   ECCBENCH_HAMMING_BYTES);
+	memcpy(mem + 1, orig, pagesize);
+	ret |= eccbench_hamming_check(&eb, mem + 1);
+	memcpy(eb.buf, orig, pagesize);
+	ret |= eccbench_run(&eb, "hamming", "clean", ECCBENCH_CLEAN,
+			    eccbench_hamming, orig);
+	if (ctrlc())
+		goto out;
+	ret |= eccbench_run(&eb, "hamming", "1 flip", ECCBENCH_FLIPS,
+			    eccbench_hamming, orig);
+
+#ifdef CONFIG_BCH
+	sprintf(code, "bch%d", t);
+	ret |= eccbench_run(&eb, code, "encode", ECCBENCH_ENCODE,
+			    eccbench_bch, orig);
+	memset(eb.read_ecc, 0, ecc_len);
+	for (i = 0; i < pagesize; i += ECCBENCH_BCH_STEP)
+		encode_bch(eb.bch, orig + i, ECCBENCH_BCH_STEP, eb.read_ecc +
+			   i / ECCBENCH_BCH_STEP * eb.bch->ecc_bytes);
+	ret |= eccbench_run(&eb, code, "clean", ECCBENCH_CLEAN,
+			    eccbench_bch, orig);
+	if (ctrlc())
+		goto out;
+	sprintf(name, "%d flips", t);
+	ret |= eccbench_run(&eb, code, name, ECCBENCH_FLIPS, eccbench_bch,
+			    orig);
+#endif
+
+out:
+	free(mem);
+#ifdef CONFIG_BCH
+	free(eb.errloc);
+	free_bch(eb.bch);
+#endif
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	eccbench,	3,	0,	do_eccbench,
+	"measure software NAND ECC throughput",
+	"[pagesize [t]]\n"
+	"    - encode and correct pages of pagesize bytes (hex, default 0x800)\n"
+	"      with Hamming and t-bit BCH (default 8) ECC, print pages/s"
+);
@@ -51,3 +51,24 @@ U_BOOT_CMD(
 	"    - List files in directory 'directory' of partition 'part' on\n"
 	"      device type 'interface' instance 'dev'."
 );
+
+#ifdef CONFIG_CMD_LOADZ
+int do_loadz_wrapper(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	return do_loadz(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	loadz,	6,	0,	do_loadz_wrapper,
+	"load and uncompress a file from a filesystem",
+	"<interface> <dev[:part]> <addr> <filename> [comp]\n"
+	"    - Load file 'filename' from partition 'part' on device type\n"
+	"      'interface' instance 'dev' and uncompress it to address 'addr'\n"
+	"      while it is read, without staging the compressed data in memory.\n"
+	"      Without 'comp' the file must be a legacy uImage; its header is\n"
+	"      kept at 'addr', followed by the uncompressed data, and is updated\n"
+	"      so that 'bootm addr' boots the image in place when 'addr' + 0x40\n"
+	"      is its load address. Otherwise 'comp' (none, gzip, lzma or lzo)\n"
+	"      gives the compression type of a raw file."
+);
+#endif
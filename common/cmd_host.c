@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+
+static int do_host_bind(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	int dev;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	dev = simple_strtoul(argv[1], NULL, 10);
+	if (host_dev_bind(dev, argv[2]))
+		return CMD_RET_FAILURE;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_host_unbind(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	int dev;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	dev = simple_strtoul(argv[1], NULL, 10);
+	if (host_dev_bind(dev, NULL))
+		return CMD_RET_FAILURE;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_host_latency(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct host_block_dev *host_dev;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	host_dev = host_get_block_dev(simple_strtoul(argv[1], NULL, 10));
+	if (!host_dev)
+		return CMD_RET_USAGE;
+
+	host_dev->latency = simple_strtoul(argv[2], NULL, 10);
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_host_info(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct host_block_dev *host_dev;
+	int dev, first = 0, last = CONFIG_HOST_MAX_DEVICES - 1;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		first = last = simple_strtoul(argv[1], NULL, 10);
+		if (!host_get_block_dev(first))
+			return CMD_RET_USAGE;
+	}
+
+	printf("%3s %10s %8s %10s %10s %s\n", "dev", "blocks", "latency",
+	       "reads", "writes", "file");
+	for (dev = first; dev <= last; dev++) {
+		host_dev = host_get_block_dev(dev);
+
+		printf("%3d ", dev);
+		if (!host_dev->filename) {
+			puts("Not bound\n");
+			continue;
+		}
+		printf("%10lu %6luus %10lu %10lu %s\n",
+		       (ulong)host_dev->blk_dev.lba, host_dev->latency,
+		       host_dev->reads, host_dev->writes, host_dev->filename);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+static cmd_tbl_t cmd_host_sub[] = {
+	U_BOOT_CMD_MKENT(bind, 3, 0, do_host_bind, "", ""),
+	U_BOOT_CMD_MKENT(unbind, 2, 0, do_host_unbind, "", ""),
+	U_BOOT_CMD_MKENT(latency, 3, 0, do_host_latency, "", ""),
+	U_BOOT_CMD_MKENT(info, 2, 0, do_host_info, "", ""),
+};
+
+static int do_host(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *cp;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* drop initial "host" arg */
+	argc--;
+	argv++;
+
+	cp = find_cmd_tbl(argv[0], cmd_host_sub, ARRAY_SIZE(cmd_host_sub));
+
+	if (cp)
+		return cp->cmd(cmdtp, flag, argc, argv);
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	host, 4, 1, do_host,
+	"block devices backed by files on the host",
+	"bind <dev> <file> - attach <file> as host device <dev>\n"
+	"host unbind <dev> - detach host device <dev>\n"
+	"host latency <dev> <us> - add <us> microseconds to each I/O\n"
+	"host info [<dev>] - show host devices and their I/O counts"
+);
@@ -33,6 +33,10 @@
 #include <dataflash.h>
 #endif
 #include <watchdog.h>
+#ifdef CONFIG_CMD_CRC32_BENCH
+#include <malloc.h>
+#include <div64.h>
+#endif
 
 static int mod_mem(cmd_tbl_t *, int, int, int, char * const []);
 
@@ -1055,6 +1059,76 @@ mod_mem(cmd_tbl_t *cmdtp, int incrflag, int flag, int argc, char * const argv[])
 
 #ifdef CONFIG_CMD_CRC32
 
+#ifdef CONFIG_CMD_CRC32_BENCH
+#define CRC32_BENCH_SIZE	(1 << 20)
+
+/* Plain bit-at-a-time CRC32 to check the table driven one against */
+static uint32_t crc32_bitwise(uint32_t crc, const uchar *p, ulong len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+/*
+ * Verify crc32() against the reference for all small lengths and
+ * alignments, then report its throughput over a buffer of 'size' bytes.
+ */
+static int do_mem_crc_bench(ulong size)
+{
+	uint64_t bytes = 0;
+	ulong start, ticks, kbs;
+	uchar *buf;
+	int i, len;
+
+	buf = malloc(size + 8);
+	if (!buf) {
+		printf("crc32: cannot allocate %lu bytes\n", size + 8);
+		return 1;
+	}
+	for (i = 0; i < size + 8; i++)
+		buf[i] = i * 13 + (i >> 8);
+
+	for (i = 0; i < 8; i++) {
+		for (len = 0; len <= 64 && len <= size; len++) {
+			if (crc32(0, buf + i, len) !=
+			    crc32_bitwise(0, buf + i, len)) {
+				printf("CRC32 self-test failed (offset %d, "
+				       "length %d)\n", i, len);
+				free(buf);
+				return 1;
+			}
+		}
+	}
+
+	start = get_timer(0);
+	do {
+		crc32(0, buf, size);
+		bytes += size;
+		ticks = get_timer(start);
+	} while (ticks < CONFIG_SYS_HZ / 2);
+	free(buf);
+
+	kbs = lldiv(bytes * CONFIG_SYS_HZ, ticks * 1024);
+	printf("CRC32 self-test passed, %lu bytes: %lu.%03lu MB/s\n",
+	       size, kbs / 1024, (kbs % 1024) * 1000 / 1024);
+
+	return 0;
+}
+
+#define CRC32_BENCH_HELP	"\n-b [size]\n    - self-test and measure " \
+				"CRC32 throughput"
+#else
+#define CRC32_BENCH_HELP	""
+#endif
+
 #ifndef CONFIG_CRC32_VERIFY
 
 static int do_mem_crc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -1063,6 +1137,12 @@ static int do_mem_crc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	ulong crc;
 	ulong *ptr;
 
+#ifdef CONFIG_CMD_CRC32_BENCH
+	if (argc > 1 && strcmp(argv[1], "-b") == 0)
+		return do_mem_crc_bench(argc > 2 ?
+					simple_strtoul(argv[2], NULL, 16) :
+					CRC32_BENCH_SIZE);
+#endif
 	if (argc < 3)
 		return CMD_RET_USAGE;
 
@@ -1096,6 +1176,12 @@ int do_mem_crc (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	int ac;
 	char * const *av;
 
+#ifdef CONFIG_CMD_CRC32_BENCH
+	if (argc > 1 && strcmp(argv[1], "-b") == 0)
+		return do_mem_crc_bench(argc > 2 ?
+					simple_strtoul(argv[2], NULL, 16) :
+					CRC32_BENCH_SIZE);
+#endif
 	if (argc < 3) {
 usage:
 		return CMD_RET_USAGE;
@@ -1188,6 +1274,7 @@ U_BOOT_CMD(
 	crc32,	4,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]"
+	CRC32_BENCH_HELP
 );
 
 #else	/* CONFIG_CRC32_VERIFY */
@@ -1197,6 +1284,7 @@ U_BOOT_CMD(
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
 	"-v address count crc\n    - verify crc of memory area"
+	CRC32_BENCH_HELP
 );
 
 #endif	/* CONFIG_CRC32_VERIFY */
@@ -0,0 +1,141 @@
+/*
+ * (C) Copyright 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Throughput benchmark for memcpy(), memmove() and memset()
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <div64.h>
+
+#define MEMBENCH_DEFAULT_SIZE	(1 << 20)
+#define MEMBENCH_MIN_SIZE	64
+/* Minimum measuring time per case, in timer ticks */
+#define MEMBENCH_TICKS		(CONFIG_SYS_HZ / 10)
+
+enum membench_op {
+	MEMBENCH_MEMCPY,
+	MEMBENCH_MEMMOVE,
+	MEMBENCH_MEMSET,
+};
+
+/* Source and destination misalignment in bytes */
+static const struct {
+	int src;
+	int dst;
+} membench_align[] = {
+	{ 0, 0 },
+	{ 1, 1 },
+	{ 0, 3 },
+	{ 3, 0 },
+};
+
+/* Return the throughput of one operation in KiB/s */
+static ulong membench_run(enum membench_op op, char *buf, ulong size,
+			  int src_off, int dst_off)
+{
+	char *src = buf + src_off;
+	char *dst = buf + size + 32 + dst_off;
+	uint64_t bytes = 0;
+	ulong start, ticks;
+
+	start = get_timer(0);
+	do {
+		switch (op) {
+		case MEMBENCH_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case MEMBENCH_MEMMOVE:
+			/* overlapping, so a backward copy is needed */
+			memmove(src + size / 2 + dst_off, src, size);
+			break;
+		case MEMBENCH_MEMSET:
+			memset(dst, 0x5a, size);
+			break;
+		}
+		bytes += size;
+		ticks = get_timer(start);
+	} while (ticks < MEMBENCH_TICKS);
+
+	return lldiv(bytes * CONFIG_SYS_HZ, ticks * 1024);
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	static const char * const names[] = { "memcpy", "memmove", "memset" };
+	ulong max_size = MEMBENCH_DEFAULT_SIZE;
+	ulong size, kbs;
+	char *buf;
+	int op, i;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+	if (argc == 2)
+		max_size = simple_strtoul(argv[1], NULL, 16);
+	if (max_size < MEMBENCH_MIN_SIZE)
+		return CMD_RET_USAGE;
+
+	/* room for source, destination and the misalignment offsets */
+	buf = malloc(2 * max_size + 64);
+	if (!buf) {
+		printf("membench: cannot allocate %lu bytes\n",
+		       2 * max_size + 64);
+		return CMD_RET_FAILURE;
+	}
+	memset(buf, 0xa5, 2 * max_size + 64);
+
+	printf("%-8s %10s %4s %4s %10s\n", "op", "size", "src", "dst", "MB/s");
+	for (op = MEMBENCH_MEMCPY; op <= MEMBENCH_MEMSET; op++) {
+		for (size = MEMBENCH_MIN_SIZE; size <= max_size; size *= 16) {
+			for (i = 0; i < ARRAY_SIZE(membench_align); i++) {
+				if (op == MEMBENCH_MEMSET &&
+				    membench_align[i].src)
+					continue;
+				kbs = membench_run(op, buf, size,
+						   membench_align[i].src,
+						   membench_align[i].dst);
+				printf("%-8s %10lu %4d %4d %6lu.%03lu\n",
+				       names[op], size,
+				       membench_align[i].src,
+				       membench_align[i].dst,
+				       kbs / 1024, (kbs % 1024) * 1000 / 1024);
+				if (ctrlc()) {
+					free(buf);
+					return CMD_RET_FAILURE;
+				}
+			}
+		}
+	}
+	free(buf);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	membench,	2,	0,	do_membench,
+	"measure memcpy/memmove/memset throughput",
+	"[maxsize]\n"
+	"    - copy and fill buffers from 64 bytes up to maxsize (hex,\n"
+	"      default 0x100000) with several alignments and print MB/s"
+);
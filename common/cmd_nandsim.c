@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Counters and fault injection for the sandbox NAND chip
+ */
+
+#include <common.h>
+#include <command.h>
+#include <sandboxnand.h>
+
+static int do_nandsim_info(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct sandbox_nand_timing *t = sandbox_nand_get_timing();
+	struct sandbox_nand_stats st;
+
+	sandbox_nand_get_stats(&st);
+
+	printf("timing: tR %uus, tPROG %uus, tBERS %uus, tRC %uns\n",
+	       t->t_r, t->t_prog, t->t_bers, t->t_rc);
+	printf("%10s %10s %10s %10s\n", "reads", "programs", "erases",
+	       "bitflips");
+	printf("%10lu %10lu %10lu %10lu\n", st.reads, st.programs, st.erases,
+	       st.bitflips);
+	printf("bus: %llu bytes out, %llu bytes in\n",
+	       (unsigned long long)st.bytes_out,
+	       (unsigned long long)st.bytes_in);
+	printf("modelled time: array %llu us, bus %llu us, total %llu us\n",
+	       (unsigned long long)st.array_ns / 1000,
+	       (unsigned long long)st.bus_ns / 1000,
+	       (unsigned long long)(st.array_ns + st.bus_ns) / 1000);
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_nandsim_reset(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	sandbox_nand_reset_stats();
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_nandsim_timing(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	struct sandbox_nand_timing *t = sandbox_nand_get_timing();
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	t->t_r = simple_strtoul(argv[1], NULL, 10);
+	t->t_prog = simple_strtoul(argv[2], NULL, 10);
+	t->t_bers = simple_strtoul(argv[3], NULL, 10);
+	if (argc > 4)
+		t->t_rc = simple_strtoul(argv[4], NULL, 10);
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_nandsim_bitflips(cmd_tbl_t *cmdtp, int flag, int argc,
+			       char * const argv[])
+{
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	sandbox_nand_set_bitflips(simple_strtoul(argv[1], NULL, 10));
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_nandsim_bad(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (sandbox_nand_mark_bad(simple_strtoul(argv[1], NULL, 0)))
+		return CMD_RET_FAILURE;
+
+	return CMD_RET_SUCCESS;
+}
+
+static cmd_tbl_t cmd_nandsim_sub[] = {
+	U_BOOT_CMD_MKENT(info, 1, 0, do_nandsim_info, "", ""),
+	U_BOOT_CMD_MKENT(reset, 1, 0, do_nandsim_reset, "", ""),
+	U_BOOT_CMD_MKENT(timing, 5, 0, do_nandsim_timing, "", ""),
+	U_BOOT_CMD_MKENT(bitflips, 2, 0, do_nandsim_bitflips, "", ""),
+	U_BOOT_CMD_MKENT(bad, 2, 0, do_nandsim_bad, "", ""),
+};
+
+static int do_nandsim(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	cmd_tbl_t *cp;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* drop initial "nandsim" arg */
+	argc--;
+	argv++;
+
+	cp = find_cmd_tbl(argv[0], cmd_nandsim_sub,
+			  ARRAY_SIZE(cmd_nandsim_sub));
+
+	if (cp)
+		return cp->cmd(cmdtp, flag, argc, argv);
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	nandsim, 6, 1, do_nandsim,
+	"sandbox NAND chip counters and fault injection",
+	"info - show operation counts and modelled time\n"
+	"nandsim reset - clear the counters\n"
+	"nandsim timing <tR> <tPROG> <tBERS> [<tRC>] - set the timing model\n"
+	"    (us, us, us, ns)\n"
+	"nandsim bitflips <n> - flip <n> bits in every page read\n"
+	"nandsim bad <block> - make <block> a factory bad block"
+);
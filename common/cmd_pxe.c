@@ -21,6 +21,7 @@
 #include <linux/ctype.h>
 #include <errno.h>
 #include <linux/list.h>
+#include <net.h>
 
 #include "menu.h"
 
@@ -143,6 +144,50 @@ static int get_bootfile_path(const char *file_path, char *bootfile_path,
 
 static int (*do_getfile)(const char *file_path, char *file_addr);
 
+/*
+ * Paths the TFTP server has told us it doesn't have. Boot scripts tend to
+ * retry 'pxe get' and 'pxe boot', so remember the misses for the rest of this
+ * boot instead of asking again. Entries are keyed by server as well, in case
+ * serverip changes in between; the oldest entry is replaced when full.
+ */
+#ifndef CONFIG_PXE_MISS_CACHE_SIZE
+#define CONFIG_PXE_MISS_CACHE_SIZE	16
+#endif
+
+static struct pxe_miss {
+	IPaddr_t server;
+	char path[MAX_TFTP_PATH_LEN+1];
+} pxe_misses[CONFIG_PXE_MISS_CACHE_SIZE];
+static int pxe_miss_next;
+
+static int pxe_miss_cached(const char *path)
+{
+	IPaddr_t server = getenv_IPaddr("serverip");
+	int i;
+
+	for (i = 0; i < CONFIG_PXE_MISS_CACHE_SIZE; i++) {
+		if (pxe_misses[i].path[0] && pxe_misses[i].server == server &&
+		    !strcmp(pxe_misses[i].path, path))
+			return 1;
+	}
+
+	return 0;
+}
+
+static void pxe_miss_add(const char *path)
+{
+	struct pxe_miss *miss;
+
+	if (pxe_miss_cached(path))
+		return;
+
+	miss = &pxe_misses[pxe_miss_next];
+	pxe_miss_next = (pxe_miss_next + 1) % CONFIG_PXE_MISS_CACHE_SIZE;
+
+	miss->server = getenv_IPaddr("serverip");
+	strcpy(miss->path, path);
+}
+
 static int do_get_tftp(const char *file_path, char *file_addr)
 {
 	char *tftp_argv[] = {"tftp", NULL, NULL, NULL};
@@ -186,20 +231,19 @@ static int do_get_fat(const char *file_path, char *file_addr)
 
 /*
  * As in pxelinux, paths to files referenced from files we retrieve are
- * relative to the location of bootfile. get_relfile takes such a path and
- * joins it with the bootfile path to get the full path to the target file. If
- * the bootfile path is NULL, we use file_path as is.
+ * relative to the location of bootfile. get_relfile_path takes such a path
+ * and joins it with the bootfile path to get the full path to the target
+ * file in 'relfile', which must hold MAX_TFTP_PATH_LEN+1 bytes. If the
+ * bootfile path is NULL, we use file_path as is.
  *
  * Returns 1 for success, or < 0 on error.
  */
-static int get_relfile(const char *file_path, void *file_addr)
+static int get_relfile_path(const char *file_path, char *relfile)
 {
 	size_t path_len;
-	char relfile[MAX_TFTP_PATH_LEN+1];
-	char addr_buf[10];
 	int err;
 
-	err = get_bootfile_path(file_path, relfile, sizeof(relfile));
+	err = get_bootfile_path(file_path, relfile, MAX_TFTP_PATH_LEN+1);
 
 	if (err < 0)
 		return err;
@@ -217,6 +261,31 @@ static int get_relfile(const char *file_path, void *file_addr)
 
 	strcat(relfile, file_path);
 
+	return 1;
+}
+
+/*
+ * Retrieve file_path, relative to the bootfile path as described above, to
+ * file_addr.
+ *
+ * Returns 1 for success, or < 0 on error.
+ */
+static int get_relfile(const char *file_path, void *file_addr)
+{
+	char relfile[MAX_TFTP_PATH_LEN+1];
+	char addr_buf[10];
+	int err;
+
+	err = get_relfile_path(file_path, relfile);
+
+	if (err < 0)
+		return err;
+
+	if (do_getfile == do_get_tftp && pxe_miss_cached(relfile)) {
+		printf("Skipping file: %s (not on server)\n", relfile);
+		return -ENOENT;
+	}
+
 	printf("Retrieving file: %s\n", relfile);
 
 	sprintf(addr_buf, "%p", file_addr);
@@ -261,17 +330,39 @@ static int get_pxe_file(const char *file_path, void *file_addr)
 
 #define PXELINUX_DIR "pxelinux.cfg/"
 
+/* uuid, mac, 8 ip address prefixes and the defaults */
+#define PXE_MAX_CANDIDATES	(10 + ARRAY_SIZE(pxe_default_paths) - 1)
+
 /*
- * Retrieves a file in the 'pxelinux.cfg' folder. Since this uses get_pxe_file
- * to do the hard work, the location of the 'pxelinux.cfg' folder is generated
- * from the bootfile path, as described above.
+ * The files in the 'pxelinux.cfg' folder 'pxe get' looks for, most specific
+ * first.
+ *
+ * path - the file path, relative to the bootfile path.
+ * relfile - the same joined with the bootfile path, as sent to the server.
+ * result - what probing the server found, a TFTP_PROBE_* value.
+ */
+struct pxe_candidates {
+	int count;
+	char path[PXE_MAX_CANDIDATES][MAX_TFTP_PATH_LEN+1];
+	char relfile[PXE_MAX_CANDIDATES][MAX_TFTP_PATH_LEN+1];
+	int result[PXE_MAX_CANDIDATES];
+};
+
+/*
+ * Adds a file in the 'pxelinux.cfg' folder to the candidates. The location
+ * of the 'pxelinux.cfg' folder is generated from the bootfile path, as
+ * described above.
  *
  * Returns 1 on success or < 0 on error.
  */
-static int get_pxelinux_path(const char *file, void *pxefile_addr_r)
+static int add_pxelinux_path(struct pxe_candidates *cand, const char *file)
 {
 	size_t base_len = strlen(PXELINUX_DIR);
-	char path[MAX_TFTP_PATH_LEN+1];
+	char *path;
+	int err;
+
+	if (cand->count >= PXE_MAX_CANDIDATES)
+		return -ENOSPC;
 
 	if (base_len + strlen(file) > MAX_TFTP_PATH_LEN) {
 		printf("path (%s%s) too long, skipping\n",
@@ -279,17 +370,25 @@ static int get_pxelinux_path(const char *file, void *pxefile_addr_r)
 		return -ENAMETOOLONG;
 	}
 
+	path = cand->path[cand->count];
 	sprintf(path, PXELINUX_DIR "%s", file);
 
-	return get_pxe_file(path, pxefile_addr_r);
+	err = get_relfile_path(path, cand->relfile[cand->count]);
+
+	if (err < 0)
+		return err;
+
+	cand->result[cand->count++] = TFTP_PROBE_UNKNOWN;
+
+	return 1;
 }
 
 /*
- * Looks for a pxe file with a name based on the pxeuuid environment variable.
+ * Adds a pxe file with a name based on the pxeuuid environment variable.
  *
  * Returns 1 on success or < 0 on error.
  */
-static int pxe_uuid_path(void *pxefile_addr_r)
+static int pxe_uuid_path(struct pxe_candidates *cand)
 {
 	char *uuid_str;
 
@@ -298,16 +397,15 @@ static int pxe_uuid_path(void *pxefile_addr_r)
 	if (!uuid_str)
 		return -ENOENT;
 
-	return get_pxelinux_path(uuid_str, pxefile_addr_r);
+	return add_pxelinux_path(cand, uuid_str);
 }
 
 /*
- * Looks for a pxe file with a name based on the 'ethaddr' environment
- * variable.
+ * Adds a pxe file with a name based on the 'ethaddr' environment variable.
  *
  * Returns 1 on success or < 0 on error.
  */
-static int pxe_mac_path(void *pxefile_addr_r)
+static int pxe_mac_path(struct pxe_candidates *cand)
 {
 	char mac_str[21];
 	int err;
@@ -317,17 +415,17 @@ static int pxe_mac_path(void *pxefile_addr_r)
 	if (err < 0)
 		return err;
 
-	return get_pxelinux_path(mac_str, pxefile_addr_r);
+	return add_pxelinux_path(cand, mac_str);
 }
 
 /*
- * Looks for pxe files with names based on our IP address. See pxelinux
+ * Adds pxe files with names based on our IP address. See pxelinux
  * documentation for details on what these file names look like.  We match
  * that exactly.
  *
  * Returns 1 on success or < 0 on error.
  */
-static int pxe_ipaddr_paths(void *pxefile_addr_r)
+static int pxe_ipaddr_paths(struct pxe_candidates *cand)
 {
 	char ip_addr[9];
 	int mask_pos, err;
@@ -335,15 +433,52 @@ static int pxe_ipaddr_paths(void *pxefile_addr_r)
 	sprintf(ip_addr, "%08X", ntohl(NetOurIP));
 
 	for (mask_pos = 7; mask_pos >= 0;  mask_pos--) {
-		err = get_pxelinux_path(ip_addr, pxefile_addr_r);
+		err = add_pxelinux_path(cand, ip_addr);
 
-		if (err > 0)
+		if (err < 0)
 			return err;
 
 		ip_addr[mask_pos] = '\0';
 	}
 
-	return -ENOENT;
+	return 1;
+}
+
+/*
+ * Asks the server about all the candidates at once, rather than paying a
+ * round trip (or a timeout) for each miss in turn. Candidates the server
+ * refused, now or earlier in this boot, are marked TFTP_PROBE_MISSING.
+ *
+ * Returns 1 on success or < 0 if the server doesn't answer.
+ */
+static int pxe_probe(struct pxe_candidates *cand)
+{
+	const char *files[PXE_MAX_CANDIDATES];
+	int result[PXE_MAX_CANDIDATES];
+	int index[PXE_MAX_CANDIDATES];
+	int i, count = 0;
+
+	for (i = 0; i < cand->count; i++) {
+		if (pxe_miss_cached(cand->relfile[i])) {
+			cand->result[i] = TFTP_PROBE_MISSING;
+			continue;
+		}
+
+		files[count] = cand->relfile[i];
+		index[count++] = i;
+	}
+
+	if (tftp_probe(files, result, count) < 0)
+		return -ETIMEDOUT;
+
+	for (i = 0; i < count; i++) {
+		cand->result[index[i]] = result[i];
+
+		if (result[i] == TFTP_PROBE_MISSING)
+			pxe_miss_add(files[i]);
+	}
+
+	return 1;
 }
 
 /*
@@ -363,9 +498,11 @@ static int pxe_ipaddr_paths(void *pxefile_addr_r)
 static int
 do_pxe_get(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	/* several KiB, keep it off the stack */
+	static struct pxe_candidates cand;
 	char *pxefile_addr_str;
 	unsigned long pxefile_addr_r;
-	int err, i = 0;
+	int err, i;
 
 	do_getfile = do_get_tftp;
 
@@ -382,25 +519,31 @@ do_pxe_get(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (err < 0)
 		return 1;
 
-	/*
-	 * Keep trying paths until we successfully get a file we're looking
-	 * for.
-	 */
-	if (pxe_uuid_path((void *)pxefile_addr_r) > 0
-		|| pxe_mac_path((void *)pxefile_addr_r) > 0
-		|| pxe_ipaddr_paths((void *)pxefile_addr_r) > 0) {
+	cand.count = 0;
+	pxe_uuid_path(&cand);
+	pxe_mac_path(&cand);
+	pxe_ipaddr_paths(&cand);
 
-		printf("Config file found\n");
+	for (i = 0; pxe_default_paths[i]; i++)
+		add_pxelinux_path(&cand, pxe_default_paths[i]);
 
-		return 0;
+	if (pxe_probe(&cand) < 0) {
+		printf("Config file not found\n");
+		return 1;
 	}
 
-	while (pxe_default_paths[i]) {
-		if (get_pxelinux_path(pxe_default_paths[i], (void *)pxefile_addr_r) > 0) {
+	/*
+	 * Take the most specific file the server has. Those it didn't answer
+	 * for are tried the slow way, in order.
+	 */
+	for (i = 0; i < cand.count; i++) {
+		if (cand.result[i] == TFTP_PROBE_MISSING)
+			continue;
+
+		if (get_pxe_file(cand.path[i], (void *)pxefile_addr_r) > 0) {
 			printf("Config file found\n");
 			return 0;
 		}
-		i++;
 	}
 
 	printf("Config file not found\n");
@@ -21,6 +21,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <div64.h>
 
 /*
  * TODO(clchiou): This function actually minics the bottom-half of the
@@ -40,14 +41,9 @@ static int run_command_and_time_it(int flag, int argc, char * const argv[],
 	if (argc > cmdtp->maxargs)
 		return CMD_RET_USAGE;
 
-	/*
-	 * TODO(clchiou): get_timer_masked() is only defined in certain ARM
-	 * boards.  We could use the new timer API that Graeme is proposing
-	 * so that this piece of code would be arch-independent.
-	 */
-	*cycles = get_timer_masked();
+	*cycles = get_timer(0);
 	retval = cmdtp->cmd(cmdtp, flag, argc, argv);
-	*cycles = get_timer_masked() - *cycles;
+	*cycles = get_timer(*cycles);
 
 	return retval;
 }
@@ -71,16 +67,40 @@ static void report_time(ulong cycles)
 			seconds, milliseconds, cycles);
 }
 
+/*
+ * Loading commands leave the size in 'filesize', report the rate too when
+ * the command changed it (reloading a file of the same size goes unnoticed)
+ */
+static void report_rate(ulong cycles, const char *old)
+{
+	char *s = getenv("filesize");
+	u64 rate;
+
+	if (!s || !cycles || !strcmp(s, old))
+		return;
+
+	rate = lldiv((u64)simple_strtoul(s, NULL, 16) * CONFIG_SYS_HZ, cycles);
+	printf("rate: ");
+	print_size(rate, "/s\n");
+}
+
 static int do_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	ulong cycles = 0;
 	int retval = 0;
+	char filesize[32] = "";
+	char *s;
 
 	if (argc == 1)
 		return CMD_RET_USAGE;
 
+	s = getenv("filesize");
+	if (s)
+		strncpy(filesize, s, sizeof(filesize) - 1);
 	retval = run_command_and_time_it(0, argc - 1, argv + 1, &cycles);
 	report_time(cycles);
+	if (retval == 0)
+		report_rate(cycles, filesize);
 
 	return retval;
 }
@@ -308,7 +308,22 @@ static int ubi_volume_write(char *volume, void *buf, size_t size)
 		ubi_gluebi_updated(vol);
 	}
 
-	printf("%d bytes written to volume %s\n", size, volume);
+	printf("%zu bytes written to volume %s\n", size, volume);
+
+	return 0;
+}
+
+/* Keep the scan summary in step with the volumes after a change */
+static int ubi_volume_changed(int ret)
+{
+	int err;
+
+	if (ret)
+		return ret;
+
+	err = ubi_sum_write(ubi);
+	if (err)
+		printf("Cannot write scan summary, error %d\n", err);
 
 	return 0;
 }
@@ -325,7 +340,7 @@ static int ubi_volume_read(char *volume, char *buf, size_t size)
 	if (vol == NULL)
 		return ENODEV;
 
-	printf("Read %d bytes from volume %s to %p\n", size, volume, buf);
+	printf("Read %zu bytes from volume %s to %p\n", size, volume, buf);
 
 	if (vol->updating) {
 		printf("updating");
@@ -557,17 +572,18 @@ static int do_ubi(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		/* Use maximum available size */
 		if (!size) {
 			size = ubi->avail_pebs * ubi->leb_size;
-			printf("No size specified -> Using max size (%u)\n", size);
+			printf("No size specified -> Using max size (%zu)\n", size);
 		}
 		/* E.g., create volume */
 		if (argc == 3)
-			return ubi_create_vol(argv[2], size, dynamic);
+			return ubi_volume_changed(ubi_create_vol(argv[2],
+							  size, dynamic));
 	}
 
 	if (strncmp(argv[1], "remove", 6) == 0) {
 		/* E.g., remove volume */
 		if (argc == 3)
-			return ubi_remove_vol(argv[2]);
+			return ubi_volume_changed(ubi_remove_vol(argv[2]));
 	}
 
 	if (strncmp(argv[1], "write", 5) == 0) {
@@ -579,7 +595,8 @@ static int do_ubi(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		addr = simple_strtoul(argv[2], NULL, 16);
 		size = simple_strtoul(argv[4], NULL, 16);
 
-		return ubi_volume_write(argv[3], (void *)addr, size);
+		return ubi_volume_changed(ubi_volume_write(argv[3],
+						(void *)addr, size));
 	}
 
 	if (strncmp(argv[1], "read", 4) == 0) {
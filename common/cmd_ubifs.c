@@ -45,7 +45,7 @@ int ubifs_init(void);
 int ubifs_mount(char *vol_name);
 void ubifs_umount(struct ubifs_info *c);
 int ubifs_ls(char *dir_name);
-int ubifs_load(char *filename, u32 addr, u32 size);
+int ubifs_load(char *filename, ulong addr, u32 size);
 
 int do_ubifs_mount(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -132,7 +132,7 @@ int do_ubifs_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *filename;
 	char *endp;
 	int ret;
-	u32 addr;
+	ulong addr;
 	u32 size = 0;
 
 	if (!ubifs_mounted) {
@@ -154,7 +154,7 @@ int do_ubifs_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (endp == argv[3])
 			return CMD_RET_USAGE;
 	}
-	debug("Loading file '%s' to address 0x%08x (size %d)\n", filename, addr, size);
+	debug("Loading file '%s' to address 0x%08lx (size %d)\n", filename, addr, size);
 
 	ret = ubifs_load(filename, addr, size);
 	if (ret)
@@ -302,6 +302,10 @@ int getc(void)
 		return 0;
 
 	if (gd->flags & GD_FLG_DEVINIT) {
+#ifdef CONFIG_LCD_SHADOW
+		/* Show what was printed before waiting for input */
+		lcd_sync();
+#endif
 		/* Get from the standard input */
 		return fgetc(stdin);
 	}
@@ -321,6 +325,10 @@ int tstc(void)
 		return 0;
 
 	if (gd->flags & GD_FLG_DEVINIT) {
+#ifdef CONFIG_LCD_SHADOW
+		/* Rate limited, tstc() is polled in tight loops */
+		lcd_poll();
+#endif
 		/* Test the standard input */
 		return ftstc(stdin);
 	}
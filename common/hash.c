@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Registry of the hash algorithms used to verify FIT images, shared by
+ * U-Boot and mkimage.
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <watchdog.h>
+#else
+#include "mkimage.h"
+#include <u-boot/crc.h>
+#endif /* !USE_HOSTCC*/
+#include <image.h>
+#include <hash.h>
+
+static void hash_init_crc32(union hash_ctx *ctx)
+{
+	ctx->crc32 = 0;
+}
+
+static void hash_update_crc32(union hash_ctx *ctx, const uint8_t *buf,
+			      unsigned int len)
+{
+	ctx->crc32 = crc32(ctx->crc32, buf, len);
+}
+
+static void hash_finish_crc32(union hash_ctx *ctx, uint8_t *digest)
+{
+	/* stored big endian, like the legacy image CRCs */
+	digest[0] = ctx->crc32 >> 24;
+	digest[1] = ctx->crc32 >> 16;
+	digest[2] = ctx->crc32 >> 8;
+	digest[3] = ctx->crc32;
+}
+
+static void hash_init_md5(union hash_ctx *ctx)
+{
+	MD5Init(&ctx->md5);
+}
+
+static void hash_update_md5(union hash_ctx *ctx, const uint8_t *buf,
+			    unsigned int len)
+{
+	MD5Update(&ctx->md5, buf, len);
+}
+
+static void hash_finish_md5(union hash_ctx *ctx, uint8_t *digest)
+{
+	MD5Final(digest, &ctx->md5);
+}
+
+static void hash_init_sha1(union hash_ctx *ctx)
+{
+	sha1_starts(&ctx->sha1);
+}
+
+static void hash_update_sha1(union hash_ctx *ctx, const uint8_t *buf,
+			     unsigned int len)
+{
+	sha1_update(&ctx->sha1, (unsigned char *)buf, len);
+}
+
+static void hash_finish_sha1(union hash_ctx *ctx, uint8_t *digest)
+{
+	sha1_finish(&ctx->sha1, digest);
+}
+
+static void hash_init_sha256(union hash_ctx *ctx)
+{
+	sha256_starts(&ctx->sha256);
+}
+
+static void hash_update_sha256(union hash_ctx *ctx, const uint8_t *buf,
+			       unsigned int len)
+{
+	sha256_update(&ctx->sha256, buf, len);
+}
+
+static void hash_finish_sha256(union hash_ctx *ctx, uint8_t *digest)
+{
+	sha256_finish(&ctx->sha256, digest);
+}
+
+static const struct hash_algo hash_algos[] = {
+	{
+		.name = "crc32",
+		.digest_size = 4,
+		.chunk_size = CHUNKSZ_CRC32,
+		.init = hash_init_crc32,
+		.update = hash_update_crc32,
+		.finish = hash_finish_crc32,
+	},
+	{
+		.name = "md5",
+		.digest_size = 16,
+		.chunk_size = CHUNKSZ_MD5,
+		.init = hash_init_md5,
+		.update = hash_update_md5,
+		.finish = hash_finish_md5,
+	},
+	{
+		.name = "sha1",
+		.digest_size = SHA1_SUM_LEN,
+		.chunk_size = CHUNKSZ_SHA1,
+		.init = hash_init_sha1,
+		.update = hash_update_sha1,
+		.finish = hash_finish_sha1,
+	},
+	{
+		.name = "sha256",
+		.digest_size = SHA256_SUM_LEN,
+		.chunk_size = CHUNKSZ_SHA256,
+		.init = hash_init_sha256,
+		.update = hash_update_sha256,
+		.finish = hash_finish_sha256,
+	},
+};
+
+const struct hash_algo *hash_lookup_algo(const char *name)
+{
+	int i;
+
+	for (i = 0; i < sizeof(hash_algos) / sizeof(hash_algos[0]); i++) {
+		if (!strcmp(name, hash_algos[i].name))
+			return &hash_algos[i];
+	}
+
+	return NULL;
+}
+
+void hash_block(const struct hash_algo *algo, const void *data,
+		unsigned int len, uint8_t *digest)
+{
+	union hash_ctx ctx;
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	const uint8_t *curr = data;
+	unsigned int chunk;
+#endif
+
+	algo->init(&ctx);
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	while (len > 0) {
+		chunk = len > algo->chunk_size ? algo->chunk_size : len;
+		algo->update(&ctx, curr, chunk);
+		curr += chunk;
+		len -= chunk;
+		WATCHDOG_RESET();
+	}
+#else
+	algo->update(&ctx, data, len);
+#endif
+	algo->finish(&ctx, digest);
+}
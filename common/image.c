@@ -52,8 +52,11 @@
 #endif
 
 #if defined(CONFIG_FIT)
-#include <u-boot/md5.h>
-#include <sha1.h>
+#include <hash.h>
+#ifdef CONFIG_FIT_PARALLEL_VERIFY
+#include <malloc.h>
+#include <mp_job.h>
+#endif
 
 static int fit_check_ramdisk(const void *fit, int os_noffset,
 		uint8_t arch, int verify);
@@ -69,7 +72,7 @@ static const image_header_t *image_get_ramdisk(ulong rd_addr, uint8_t arch,
 						int verify);
 #else
 #include "mkimage.h"
-#include <u-boot/md5.h>
+#include <hash.h>
 #include <time.h>
 #include <image.h>
 #endif /* !USE_HOSTCC*/
@@ -2557,6 +2560,150 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 	return 0;
 }
 
+#if defined(CONFIG_FIT_PARALLEL_VERIFY) && !defined(USE_HOSTCC)
+/* A component image hash computed ahead of its check */
+struct fit_hash_job {
+	const struct hash_algo *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_hash_job *fit_hash_jobs;
+static int fit_hash_njobs;
+
+static void fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *job = arg;
+	union hash_ctx ctx;
+
+	/* the watchdog belongs to the boot CPU, only it may kick it */
+	if (!cpu_job_current()) {
+		hash_block(job->algo, job->data, job->size, job->value);
+		return;
+	}
+
+	job->algo->init(&ctx);
+	job->algo->update(&ctx, job->data, job->size);
+	job->algo->finish(&ctx, job->value);
+}
+
+/* Return the precomputed hash of the given data, or NULL */
+static const uint8_t *fit_lookup_hash(const struct hash_algo *algo,
+				      const void *data, size_t size)
+{
+	int i;
+
+	for (i = 0; i < fit_hash_njobs; i++) {
+		if (fit_hash_jobs[i].algo == algo &&
+		    fit_hash_jobs[i].data == data &&
+		    fit_hash_jobs[i].size == size)
+			return fit_hash_jobs[i].value;
+	}
+
+	return NULL;
+}
+
+/*
+ * Add the hashes of a component image to jobs, or only count them if jobs
+ * is NULL. Returns the number of hashes.
+ */
+static int fit_image_queue_hashes(const void *fit, int image_noffset,
+				  struct fit_hash_job *jobs)
+{
+	const struct hash_algo *algo;
+	const void *data;
+	size_t size;
+	char *algo_name;
+	int noffset, ndepth, ignore;
+	int count = 0;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return 0;
+
+	for (ndepth = 0, noffset = fdt_next_node(fit, image_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth != 1 || strncmp(fit_get_name(fit, noffset, NULL),
+					   FIT_HASH_NODENAME,
+					   strlen(FIT_HASH_NODENAME)) != 0)
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo_name))
+			continue;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		algo = hash_lookup_algo(algo_name);
+		if (ignore || !algo)
+			continue;
+
+		if (jobs) {
+			jobs[count].algo = algo;
+			jobs[count].data = data;
+			jobs[count].size = size;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * fit_prepare_hashes - compute component image hashes in parallel
+ * @fit: pointer to the FIT format image header
+ * @noffsets: component image node offsets, negative ones are skipped
+ * @count: number of entries in @noffsets
+ *
+ * fit_prepare_hashes() computes all hashes of the given component images
+ * up front, spread over the secondary cores by mp_run_jobs(), so that the
+ * following fit_image_check_hashes() calls only compare the values. The
+ * results are used until fit_drop_hashes() is called.
+ */
+void fit_prepare_hashes(const void *fit, const int *noffsets, int count)
+{
+	struct mp_job *mp;
+	int i, n;
+
+	fit_drop_hashes();
+
+	for (i = 0, n = 0; i < count; i++) {
+		if (noffsets[i] >= 0)
+			n += fit_image_queue_hashes(fit, noffsets[i], NULL);
+	}
+	/* nothing to overlap */
+	if (n < 2)
+		return;
+
+	fit_hash_jobs = malloc(n * sizeof(*fit_hash_jobs));
+	mp = malloc(n * sizeof(*mp));
+	if (!fit_hash_jobs || !mp) {
+		free(mp);
+		fit_drop_hashes();
+		return;
+	}
+
+	for (i = 0, n = 0; i < count; i++) {
+		if (noffsets[i] >= 0)
+			n += fit_image_queue_hashes(fit, noffsets[i],
+						    fit_hash_jobs + n);
+	}
+	for (i = 0; i < n; i++) {
+		mp[i].fn = fit_hash_job_run;
+		mp[i].arg = &fit_hash_jobs[i];
+		mp[i].weight = fit_hash_jobs[i].size;
+	}
+
+	mp_run_jobs(mp, n);
+	free(mp);
+	fit_hash_njobs = n;
+}
+
+void fit_drop_hashes(void)
+{
+	free(fit_hash_jobs);
+	fit_hash_jobs = NULL;
+	fit_hash_njobs = 0;
+}
+#endif /* CONFIG_FIT_PARALLEL_VERIFY && !USE_HOSTCC */
+
 /**
  * calculate_hash - calculate and return hash for provided input data
  * @data: pointer to the input data
@@ -2569,6 +2716,7 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
  * calculate_hash() computes input data hash according to the requested algorithm.
  * Resulting hash value is placed in caller provided 'value' buffer, length
  * of the calculated hash is returned via value_len pointer argument.
+ * The algorithm is looked up in the hash registry (common/hash.c).
  *
  * returns:
  *     0, on success
@@ -2577,22 +2725,28 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 static int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
-	if (strcmp(algo, "crc32") == 0) {
-		*((uint32_t *)value) = crc32_wd(0, data, data_len,
-							CHUNKSZ_CRC32);
-		*((uint32_t *)value) = cpu_to_uimage(*((uint32_t *)value));
-		*value_len = 4;
-	} else if (strcmp(algo, "sha1") == 0) {
-		sha1_csum_wd((unsigned char *) data, data_len,
-				(unsigned char *) value, CHUNKSZ_SHA1);
-		*value_len = 20;
-	} else if (strcmp(algo, "md5") == 0) {
-		md5_wd((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
-		*value_len = 16;
-	} else {
+	const struct hash_algo *ha;
+
+	ha = hash_lookup_algo(algo);
+	if (!ha) {
 		debug("Unsupported hash alogrithm\n");
 		return -1;
 	}
+
+#if defined(CONFIG_FIT_PARALLEL_VERIFY) && !defined(USE_HOSTCC)
+	{
+		const uint8_t *ready = fit_lookup_hash(ha, data, data_len);
+
+		if (ready) {
+			memcpy(value, ready, ha->digest_size);
+			*value_len = ha->digest_size;
+			return 0;
+		}
+	}
+#endif
+	hash_block(ha, data, data_len, value);
+	*value_len = ha->digest_size;
+
 	return 0;
 }
 
@@ -2901,6 +3055,33 @@ int fit_all_image_check_hashes(const void *fit)
 		return 0;
 	}
 
+#if defined(CONFIG_FIT_PARALLEL_VERIFY) && !defined(USE_HOSTCC)
+	{
+		int *nodes;
+
+		for (ndepth = 0, count = 0,
+			noffset = fdt_next_node(fit, images_noffset, &ndepth);
+			(noffset >= 0) && (ndepth > 0);
+			noffset = fdt_next_node(fit, noffset, &ndepth)) {
+			if (ndepth == 1)
+				count++;
+		}
+		nodes = malloc(count * sizeof(*nodes));
+		if (nodes) {
+			for (ndepth = 0, count = 0,
+				noffset = fdt_next_node(fit, images_noffset,
+							&ndepth);
+				(noffset >= 0) && (ndepth > 0);
+				noffset = fdt_next_node(fit, noffset, &ndepth)) {
+				if (ndepth == 1)
+					nodes[count++] = noffset;
+			}
+			fit_prepare_hashes(fit, nodes, count);
+			free(nodes);
+		}
+	}
+#endif
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 		(ulong)fit);
@@ -2916,11 +3097,14 @@ int fit_all_image_check_hashes(const void *fit)
 			printf("   Hash(es) for Image %u (%s): ", count++,
 					fit_get_name(fit, noffset, NULL));
 
-			if (!fit_image_check_hashes(fit, noffset))
+			if (!fit_image_check_hashes(fit, noffset)) {
+				fit_drop_hashes();
 				return 0;
+			}
 			printf("\n");
 		}
 	}
+	fit_drop_hashes();
 	return 1;
 }
 
@@ -39,6 +39,7 @@
 #include <post.h>
 #endif
 #include <lcd.h>
+#include <malloc.h>
 #include <watchdog.h>
 
 #if defined(CONFIG_CPU_PXA25X) || defined(CONFIG_CPU_PXA27X) || \
@@ -97,11 +98,242 @@ static int lcd_getfgcolor(void);
 #endif	/* NOT_USED_SO_FAR */
 
 /************************************************************************/
+/* ** CONSOLE SCROLLING							*/
+/************************************************************************/
+/*
+ * Moving the console up one text row is a read and a write of the whole
+ * framebuffer, which on large panels makes console output the slowest
+ * thing in the bootloader. Two options avoid it:
+ *
+ * CONFIG_LCD_PAN_ROWS reserves that many spare text rows of framebuffer
+ * memory below the panel. If the controller can pan (see lcd_pan()),
+ * scrolling moves the scanout start down one row and clears the new last
+ * row. Only when the spare rows run out is the screen copied back to the
+ * start of the buffer.
+ *
+ * CONFIG_LCD_SHADOW keeps the console text in a shadow buffer with the
+ * first changed column of each row. Output only updates the shadow; the
+ * changed rows are drawn at most every CONFIG_LCD_SHADOW_DELAY ms while
+ * output keeps coming or the console polls for input (lcd_poll()), and
+ * whenever the console waits for input or an OS is started (lcd_sync()).
+ */
+
+#ifdef CONFIG_LCD_PAN_ROWS
+#ifdef CONFIG_FB_ADDR
+/* Only lcd_setmem() reserves the spare rows, a fixed buffer may end anywhere */
+#error "CONFIG_LCD_PAN_ROWS cannot be used with CONFIG_FB_ADDR"
+#endif
+
+static int lcd_can_pan;
+
+static int __lcd_pan(void *start)
+{
+	return -1;
+}
+int lcd_pan(void *start) __attribute__((weak, alias("__lcd_pan")));
+
+/* Pan the console up one row, returns 1 if done */
+static int console_pan(void)
+{
+	ulong size = lcd_line_length * panel_info.vl_row;
+	void *start = (void *)gd->fb_base;
+	void *base = lcd_base + CONSOLE_ROW_SIZE;
+
+	/* The logo or the board info would scroll away */
+	if (!lcd_can_pan || lcd_console_address != lcd_base)
+		return 0;
+
+	if (base > start + CONFIG_LCD_PAN_ROWS * CONSOLE_ROW_SIZE) {
+		/* Out of spare rows, move the screen back to the start */
+		memmove(start, base, CONSOLE_SCROLL_SIZE);
+		base = start;
+	}
+
+	lcd_pan(base);
+	lcd_base = base;
+	lcd_console_address = base;
+
+	/* Clear what came into view at the bottom */
+	memset(CONSOLE_ROW_LAST, COLOR_MASK(lcd_color_bg),
+		size - CONSOLE_SCROLL_SIZE);
+
+	return 1;
+}
+#else
+static inline int console_pan(void)
+{
+	return 0;
+}
+#endif /* CONFIG_LCD_PAN_ROWS */
+
+#ifdef CONFIG_LCD_SHADOW
+#ifndef CONFIG_LCD_SHADOW_DELAY
+#define CONFIG_LCD_SHADOW_DELAY	50
+#endif
+
+static uchar *shadow_text;	/* CONSOLE_ROWS x CONSOLE_COLS characters */
+static ushort *shadow_from;	/* first column to draw, per row */
+static int shadow_top;		/* shadow row shown at the top */
+static ulong shadow_time;	/* when it was last drawn */
+
+static inline int shadow_index(int row)
+{
+	return (shadow_top + row) % CONSOLE_ROWS;
+}
+
+static inline uchar *shadow_row(int row)
+{
+	return shadow_text + shadow_index(row) * CONSOLE_COLS;
+}
+
+static void shadow_alloc(void)
+{
+	shadow_text = malloc(CONSOLE_ROWS * CONSOLE_COLS);
+	shadow_from = malloc(CONSOLE_ROWS * sizeof(*shadow_from));
+	if (!shadow_text || !shadow_from) {
+		/* draw straight to the framebuffer then */
+		free(shadow_text);
+		free(shadow_from);
+		shadow_text = NULL;
+		shadow_from = NULL;
+	}
+}
+
+/* The framebuffer has just been cleared */
+static void shadow_clear(void)
+{
+	int row;
+
+	if (!shadow_text)
+		return;
+
+	memset(shadow_text, ' ', CONSOLE_ROWS * CONSOLE_COLS);
+	for (row = 0; row < CONSOLE_ROWS; row++)
+		shadow_from[row] = CONSOLE_COLS;
+	shadow_top = 0;
+}
+
+static inline void shadow_mark(int row, int col)
+{
+	int i = shadow_index(row);
+
+	if (col < shadow_from[i])
+		shadow_from[i] = col;
+}
+
+/* Draw a row from its first changed column on */
+static void shadow_draw_row(int row)
+{
+	int i = shadow_index(row);
+	int col = shadow_from[i];
+	uchar *text = shadow_row(row);
+	uchar *dest;
+	ulong off;
+	int len, line;
+
+	if (col >= CONSOLE_COLS)
+		return;
+
+	for (len = CONSOLE_COLS; len > col && text[len - 1] == ' '; len--)
+		;
+	if (len > col)
+		lcd_drawchars(col * VIDEO_FONT_WIDTH, row * VIDEO_FONT_HEIGHT,
+			text + col, len - col);
+
+	/* Blank the rest of the row rather than drawing spaces */
+	off = len * VIDEO_FONT_WIDTH * NBITS(LCD_BPP) / 8;
+	dest = (uchar *)CONSOLE_ROW_FIRST + row * CONSOLE_ROW_SIZE + off;
+	for (line = 0; line < VIDEO_FONT_HEIGHT; line++) {
+		memset(dest, COLOR_MASK(lcd_color_bg), lcd_line_length - off);
+		dest += lcd_line_length;
+	}
+
+	shadow_from[i] = CONSOLE_COLS;
+}
+
+static void shadow_draw(int force)
+{
+	int row;
+
+	if (!shadow_text)
+		return;
+	if (!force && get_timer(shadow_time) < CONFIG_LCD_SHADOW_DELAY)
+		return;
+
+	for (row = 0; row < CONSOLE_ROWS; row++)
+		shadow_draw_row(row);
+	shadow_time = get_timer(0);
+}
+
+void lcd_sync(void)
+{
+	if (lcd_is_enabled)
+		shadow_draw(1);
+}
+
+/* Like lcd_sync(), but only once the redraw delay has passed */
+void lcd_poll(void)
+{
+	if (lcd_is_enabled)
+		shadow_draw(0);
+}
+
+/* Scroll the shadow, returns 1 if done */
+static int shadow_scrollup(int panned)
+{
+	int row;
+
+	if (!shadow_text)
+		return 0;
+
+	shadow_top = shadow_index(1);
+	memset(shadow_row(CONSOLE_ROWS - 1), ' ', CONSOLE_COLS);
+
+	if (panned) {
+		/* the last row was cleared along with the pan */
+		shadow_from[shadow_index(CONSOLE_ROWS - 1)] = CONSOLE_COLS;
+	} else {
+		/* everything moved: draw it all again, next time */
+		for (row = 0; row < CONSOLE_ROWS; row++)
+			shadow_from[row] = 0;
+	}
+
+	return 1;
+}
+
+static inline int shadow_putc(int col, int row, uchar c)
+{
+	if (!shadow_text)
+		return 0;
+
+	shadow_row(row)[col] = c;
+	shadow_mark(row, col);
+
+	return 1;
+}
+#else
+static inline void shadow_alloc(void) {}
+static inline void shadow_clear(void) {}
+static inline void shadow_draw(int force) {}
+static inline int shadow_scrollup(int panned)
+{
+	return 0;
+}
+static inline int shadow_putc(int col, int row, uchar c)
+{
+	return 0;
+}
+#endif /* CONFIG_LCD_SHADOW */
 
 /*----------------------------------------------------------------------*/
 
 static void console_scrollup(void)
 {
+	int panned = console_pan();
+
+	if (shadow_scrollup(panned) || panned)
+		return;
+
 	/* Copy up rows ignoring the first one */
 	memcpy(CONSOLE_ROW_FIRST, CONSOLE_ROW_SECOND, CONSOLE_SCROLL_SIZE);
 
@@ -111,6 +343,15 @@ static void console_scrollup(void)
 
 /*----------------------------------------------------------------------*/
 
+static inline void console_putc_xy(int col, int row, uchar c)
+{
+	if (!shadow_putc(col, row, c))
+		lcd_putc_xy(col * VIDEO_FONT_WIDTH,
+			row * VIDEO_FONT_HEIGHT, c);
+}
+
+/*----------------------------------------------------------------------*/
+
 static inline void console_back(void)
 {
 	if (--console_col < 0) {
@@ -120,8 +361,7 @@ static inline void console_back(void)
 		}
 	}
 
-	lcd_putc_xy(console_col * VIDEO_FONT_WIDTH,
-		console_row * VIDEO_FONT_HEIGHT, ' ');
+	console_putc_xy(console_col, console_row, ' ');
 }
 
 /*----------------------------------------------------------------------*/
@@ -141,14 +381,8 @@ static inline void console_newline(void)
 
 /*----------------------------------------------------------------------*/
 
-void lcd_putc(const char c)
+static void console_putc(const char c)
 {
-	if (!lcd_is_enabled) {
-		serial_putc(c);
-
-		return;
-	}
-
 	switch (c) {
 	case '\r':
 		console_col = 0;
@@ -171,13 +405,24 @@ void lcd_putc(const char c)
 
 		return;
 	default:
-		lcd_putc_xy(console_col * VIDEO_FONT_WIDTH,
-			console_row * VIDEO_FONT_HEIGHT, c);
+		console_putc_xy(console_col, console_row, c);
 		if (++console_col >= CONSOLE_COLS)
 			console_newline();
 	}
 }
 
+void lcd_putc(const char c)
+{
+	if (!lcd_is_enabled) {
+		serial_putc(c);
+
+		return;
+	}
+
+	console_putc(c);
+	shadow_draw(0);
+}
+
 /*----------------------------------------------------------------------*/
 
 void lcd_puts(const char *s)
@@ -189,8 +434,9 @@ void lcd_puts(const char *s)
 	}
 
 	while (*s) {
-		lcd_putc(*s++);
+		console_putc(*s++);
 	}
+	shadow_draw(0);
 }
 
 /*----------------------------------------------------------------------*/
@@ -335,6 +581,8 @@ int drv_lcd_init (void)
 
 	lcd_line_length = (panel_info.vl_col * NBITS (panel_info.vl_bpix)) / 8;
 
+	shadow_alloc();
+
 	lcd_init(lcd_base);		/* LCD initialization */
 
 	/* Device initialization */
@@ -386,6 +634,14 @@ void lcd_clear(void)
 	lcd_setbgcolor(CONSOLE_COLOR_BLACK);
 #endif	/* CONFIG_SYS_WHITE_ON_BLACK */
 
+#ifdef CONFIG_LCD_PAN_ROWS
+	/* Start over at the top of the framebuffer */
+	if (lcd_can_pan) {
+		lcd_base = (void *)gd->fb_base;
+		lcd_pan(lcd_base);
+	}
+#endif
+
 #ifdef	LCD_TEST_PATTERN
 	test_pattern();
 #else
@@ -400,6 +656,7 @@ void lcd_clear(void)
 
 	console_col = 0;
 	console_row = 0;
+	shadow_clear();
 }
 
 U_BOOT_CMD(
@@ -416,6 +673,9 @@ static int lcd_init(void *lcdbase)
 	debug("[LCD] Initializing LCD frambuffer at %p\n", lcdbase);
 
 	lcd_ctrl_init(lcdbase);
+#ifdef CONFIG_LCD_PAN_ROWS
+	lcd_can_pan = (lcd_pan(lcdbase) == 0);
+#endif
 	lcd_is_enabled = 1;
 	lcd_clear();
 	lcd_enable ();
@@ -451,6 +711,10 @@ ulong lcd_setmem(ulong addr)
 		panel_info.vl_row, NBITS(panel_info.vl_bpix));
 
 	size = line_length * panel_info.vl_row;
+#ifdef CONFIG_LCD_PAN_ROWS
+	/* Spare rows to pan the console into */
+	size += CONFIG_LCD_PAN_ROWS * VIDEO_FONT_HEIGHT * line_length;
+#endif
 
 	/* Round up to nearest full page */
 	size = (size + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
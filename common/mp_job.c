@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Minimal job queue running independent jobs on the secondary cores
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mp_job.h>
+
+struct mp_worker {
+	int id;
+	struct mp_job *jobs;
+	int njobs;
+	int *owner;		/* worker each job is assigned to */
+	ulong load;		/* sum of the weights assigned to it */
+};
+
+static int __cpu_job_cores(void)
+{
+	return 1;
+}
+int cpu_job_cores(void) __attribute__((weak, alias("__cpu_job_cores")));
+
+static int __cpu_start_job(int nr, void (*fn)(void *arg), void *arg)
+{
+	return -1;
+}
+int cpu_start_job(int nr, void (*fn)(void *arg), void *arg)
+	__attribute__((weak, alias("__cpu_start_job")));
+
+static void __cpu_wait_job(int nr)
+{
+}
+void cpu_wait_job(int nr) __attribute__((weak, alias("__cpu_wait_job")));
+
+static int __cpu_job_current(void)
+{
+	return 0;
+}
+int cpu_job_current(void) __attribute__((weak, alias("__cpu_job_current")));
+
+static void mp_worker_run(void *arg)
+{
+	struct mp_worker *w = arg;
+	int i;
+
+	for (i = 0; i < w->njobs; i++) {
+		if (w->owner[i] == w->id)
+			w->jobs[i].fn(w->jobs[i].arg);
+	}
+}
+
+/*
+ * Hand the jobs out heaviest first, each to the least loaded worker, so
+ * the cores finish at about the same time without sharing a queue.
+ */
+static void mp_assign_jobs(struct mp_worker *workers, int nworkers,
+			   struct mp_job *jobs, int njobs, int *owner)
+{
+	int i, j, best, w;
+
+	for (i = 0; i < njobs; i++)
+		owner[i] = -1;
+
+	for (i = 0; i < njobs; i++) {
+		best = -1;
+		for (j = 0; j < njobs; j++) {
+			if (owner[j] < 0 && (best < 0 ||
+			    jobs[j].weight > jobs[best].weight))
+				best = j;
+		}
+
+		w = 0;
+		for (j = 1; j < nworkers; j++) {
+			if (workers[j].load < workers[w].load)
+				w = j;
+		}
+		owner[best] = w;
+		workers[w].load += jobs[best].weight;
+	}
+}
+
+void mp_run_jobs(struct mp_job *jobs, int njobs)
+{
+	struct mp_worker workers[MP_JOB_MAX_CORES];
+	int started[MP_JOB_MAX_CORES];
+	int nworkers, i;
+	int *owner;
+
+	nworkers = min(cpu_job_cores(), MP_JOB_MAX_CORES);
+	nworkers = min(nworkers, njobs);
+	owner = nworkers > 1 ? malloc(njobs * sizeof(*owner)) : NULL;
+	if (!owner) {
+		for (i = 0; i < njobs; i++)
+			jobs[i].fn(jobs[i].arg);
+		return;
+	}
+
+	for (i = 0; i < nworkers; i++) {
+		workers[i].id = i;
+		workers[i].jobs = jobs;
+		workers[i].njobs = njobs;
+		workers[i].owner = owner;
+		workers[i].load = 0;
+	}
+	mp_assign_jobs(workers, nworkers, jobs, njobs, owner);
+
+	for (i = 1; i < nworkers; i++)
+		started[i] = !cpu_start_job(i, mp_worker_run, &workers[i]);
+
+	mp_worker_run(&workers[0]);
+
+	for (i = 1; i < nworkers; i++) {
+		if (started[i])
+			cpu_wait_job(i);
+		else
+			mp_worker_run(&workers[i]);
+	}
+
+	free(owner);
+}
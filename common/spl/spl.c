@@ -32,6 +32,9 @@
 #include <image.h>
 #include <malloc.h>
 #include <linux/compiler.h>
+#ifdef CONFIG_SPL_LZO_SUPPORT
+#include <linux/lzo.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -98,6 +101,17 @@ void spl_parse_image_header(const struct image_header *header)
 		}
 		spl_image.os = image_get_os(header);
 		spl_image.name = image_get_name(header);
+		spl_image.comp = image_get_comp(header);
+#ifdef CONFIG_SPL_LZO_SUPPORT
+		if (spl_image.comp != IH_COMP_NONE) {
+			/*
+			 * Only the payload is uncompressed to the load
+			 * address; size is that of the compressed data.
+			 */
+			spl_image.load_addr = image_get_load(header);
+			spl_image.size = image_get_data_size(header);
+		}
+#endif
 		debug("spl: payload image: %s load addr: 0x%x size: %d\n",
 			spl_image.name, spl_image.load_addr, spl_image.size);
 	} else {
@@ -110,9 +124,90 @@ void spl_parse_image_header(const struct image_header *header)
 		spl_image.load_addr = CONFIG_SYS_TEXT_BASE;
 		spl_image.os = IH_OS_U_BOOT;
 		spl_image.name = "U-Boot";
+		spl_image.comp = IH_COMP_NONE;
 	}
 }
 
+#ifdef CONFIG_SPL_LZO_SUPPORT
+/*
+ * Room at the load address for an uncompressed payload of up to
+ * CONFIG_SYS_MONITOR_LEN bytes, including the margin the LZO decoder needs
+ * to decompress each block over its own input.
+ */
+#define SPL_LZO_ROOM	lzo1x_worst_compress(CONFIG_SYS_MONITOR_LEN)
+
+/*
+ * DRAM above that room, free for a loader to stage compressed data in
+ * while it is being decoded.
+ */
+void *spl_lzo_scratch(void)
+{
+	return (void *)ALIGN(spl_image.load_addr + SPL_LZO_ROOM,
+			     ARCH_DMA_MINALIGN);
+}
+
+/**
+ * spl_load_compressed() - uncompress the payload to its load address
+ * @read: callback supplying the compressed data in order
+ * @priv: private data for @read
+ *
+ * The data is decoded as it is read, so apart from what @read itself
+ * buffers nothing beyond the destination area is needed. On success
+ * spl_image.size is updated to the uncompressed size.
+ */
+void spl_load_compressed(stream_read_fn read, void *priv)
+{
+	size_t len = SPL_LZO_ROOM;
+	int ret;
+
+	if (spl_image.comp != IH_COMP_LZO) {
+		printf("spl: unsupported compression type %d\n",
+		       spl_image.comp);
+		hang();
+	}
+
+	ret = lzop_decompress_stream(read, priv,
+				     (unsigned char *)spl_image.load_addr, &len);
+	if (ret != LZO_E_OK) {
+		printf("spl: LZO uncompress error %d\n", ret);
+		hang();
+	}
+	spl_image.size = len;
+	debug("spl: uncompressed %s to %d bytes\n", spl_image.name,
+	      spl_image.size);
+}
+
+struct spl_mem_stream {
+	const u8 *src;
+	u32 left;
+};
+
+static int spl_mem_read(void *priv, void *buf, int len)
+{
+	struct spl_mem_stream *s = priv;
+
+	if (len > s->left)
+		len = s->left;
+	memcpy(buf, s->src, len);
+	s->src += len;
+	s->left -= len;
+
+	return len;
+}
+
+/*
+ * For loaders that can only read the whole payload at once: uncompress it
+ * from where it was read to, which must lie outside the destination area,
+ * e.g. at spl_lzo_scratch().
+ */
+void spl_load_compressed_buf(const void *src, u32 len)
+{
+	struct spl_mem_stream s = { src, len };
+
+	spl_load_compressed(spl_mem_read, &s);
+}
+#endif
+
 static void __noreturn jump_to_image_no_args(void)
 {
 	typedef void __noreturn (*image_entry_noargs_t)(u32 *);
@@ -26,6 +26,29 @@
 #include <asm/io.h>
 #include <nand.h>
 
+/* Read the image at offs, whose header has been parsed, to its load address */
+static void spl_nand_load_payload(uint32_t offs)
+{
+#ifdef CONFIG_SPL_LZO_SUPPORT
+	if (spl_image.comp != IH_COMP_NONE) {
+		u8 *buf = spl_lzo_scratch();
+
+		/*
+		 * nand_spl_load_image() reads whole erase blocks and skips
+		 * bad ones as it goes, so stage all of the (small) compressed
+		 * image in DRAM and uncompress it from there.
+		 */
+		nand_spl_load_image(offs,
+			spl_image.size + sizeof(struct image_header), buf);
+		spl_load_compressed_buf(buf + sizeof(struct image_header),
+			spl_image.size);
+		return;
+	}
+#endif
+	nand_spl_load_image(offs, spl_image.size,
+		(void *)spl_image.load_addr);
+}
+
 void spl_nand_load_image(void)
 {
 	struct image_header *header;
@@ -64,8 +87,7 @@ void spl_nand_load_image(void)
 		spl_parse_image_header(header);
 		if (header->ih_os == IH_OS_LINUX) {
 			/* happy - was a linux */
-			nand_spl_load_image(CONFIG_SYS_NAND_SPL_KERNEL_OFFS,
-				spl_image.size, (void *)spl_image.load_addr);
+			spl_nand_load_payload(CONFIG_SYS_NAND_SPL_KERNEL_OFFS);
 			nand_deselect();
 			return;
 		} else {
@@ -94,7 +116,6 @@ void spl_nand_load_image(void)
 	nand_spl_load_image(CONFIG_SYS_NAND_U_BOOT_OFFS,
 		CONFIG_SYS_NAND_PAGE_SIZE, (void *)header);
 	spl_parse_image_header(header);
-	nand_spl_load_image(CONFIG_SYS_NAND_U_BOOT_OFFS,
-		spl_image.size, (void *)spl_image.load_addr);
+	spl_nand_load_payload(CONFIG_SYS_NAND_U_BOOT_OFFS);
 	nand_deselect();
 }
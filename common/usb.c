@@ -269,6 +269,18 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 }
 
 
+/*
+ * Largest bulk transfer, in bytes, the host controller driver accepts in one
+ * submit_bulk_msg() call. This conservative default is what every driver has
+ * been shown to cope with; drivers that know better override it.
+ */
+unsigned int __usb_max_bulk_xfer(void)
+{
+	return 20 * 512;
+}
+unsigned int usb_max_bulk_xfer(void)
+	__attribute__((weak, alias("__usb_max_bulk_xfer")));
+
 /*-------------------------------------------------------------------
  * Max Packet stuff
  */
@@ -154,18 +154,17 @@ struct us_data {
 	ccb		*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
+	unsigned int	max_xfer;		/* max bytes per READ/WRITE */
 };
 
-#ifdef CONFIG_USB_EHCI
 /*
- * The U-Boot EHCI driver can handle any transfer length as long as there is
- * enough free heap space left, but the SCSI READ(10) and WRITE(10) commands are
- * limited to 65535 blocks.
+ * The SCSI READ(10) and WRITE(10) commands are limited to 65535 blocks. How
+ * much of that can be moved in one bulk transfer is up to the host controller
+ * driver, see usb_max_bulk_xfer(); drivers which do not say fall back to
+ * USB_MIN_XFER_BLK blocks of 512 bytes.
  */
 #define USB_MAX_XFER_BLK	65535
-#else
-#define USB_MAX_XFER_BLK	20
-#endif
+#define USB_MIN_XFER_BLK	20
 
 static struct us_data usb_stor[USB_MAX_STOR_DEV];
 
@@ -1052,6 +1051,51 @@ static void usb_bin_fixup(struct usb_device_descriptor descriptor,
 }
 #endif /* CONFIG_USB_BIN_FIXUP */
 
+/*
+ * Number of blocks to move with the next READ(10)/WRITE(10): as many as the
+ * host controller takes in one bulk transfer, but never more than the command
+ * can address or than the device reported as its capacity.
+ */
+static unsigned short usb_stor_xfer_blks(struct us_data *ss,
+					 block_dev_desc_t *dev_desc,
+					 lbaint_t blks)
+{
+	lbaint_t max = USB_MIN_XFER_BLK;
+
+	if (dev_desc->blksz)
+		max = ss->max_xfer / dev_desc->blksz;
+	if (max > USB_MAX_XFER_BLK)
+		max = USB_MAX_XFER_BLK;
+	if (dev_desc->lba && max > dev_desc->lba)
+		max = dev_desc->lba;
+	if (max == 0)
+		max = 1;
+
+	return (unsigned short)(blks > max ? max : blks);
+}
+
+/*
+ * Some devices choke on transfers larger than they care to admit. Halve the
+ * per-device limit after a failed large transfer, down to the size every
+ * controller and device has always been driven with. Returns 1 if the limit
+ * was lowered and the transfer should be retried.
+ */
+static int usb_stor_shrink_xfer(struct us_data *ss, block_dev_desc_t *dev_desc,
+				unsigned short blks)
+{
+	unsigned int min = USB_MIN_XFER_BLK * dev_desc->blksz;
+
+	if (blks <= USB_MIN_XFER_BLK || ss->max_xfer <= min)
+		return 0;
+
+	ss->max_xfer = blks * dev_desc->blksz / 2;
+	if (ss->max_xfer < min)
+		ss->max_xfer = min;
+	USB_STOR_PRINTF("usb: lowering max transfer to %u bytes\n",
+			ss->max_xfer);
+	return 1;
+}
+
 unsigned long usb_stor_read(int device, unsigned long blknr,
 			    lbaint_t blkcnt, void *buffer)
 {
@@ -1092,18 +1136,19 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_XFER_BLK)
-			smallblks = USB_MAX_XFER_BLK;
-		else
-			smallblks = (unsigned short) blks;
+resize:
+		smallblks = usb_stor_xfer_blks(ss, &usb_dev_desc[device], blks);
 retry_it:
-		if (smallblks == USB_MAX_XFER_BLK)
+		if (blkcnt > smallblks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
 		if (usb_read_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Read ERROR\n");
 			usb_request_sense(srb, ss);
+			if (usb_stor_shrink_xfer(ss, &usb_dev_desc[device],
+						 smallblks))
+				goto resize;
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1120,7 +1165,7 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_XFER_BLK)
+	if (blkcnt > USB_MIN_XFER_BLK)
 		debug("\n");
 	return blkcnt;
 }
@@ -1168,18 +1213,19 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		 */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_XFER_BLK)
-			smallblks = USB_MAX_XFER_BLK;
-		else
-			smallblks = (unsigned short) blks;
+resize:
+		smallblks = usb_stor_xfer_blks(ss, &usb_dev_desc[device], blks);
 retry_it:
-		if (smallblks == USB_MAX_XFER_BLK)
+		if (blkcnt > smallblks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
 		if (usb_write_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Write ERROR\n");
 			usb_request_sense(srb, ss);
+			if (usb_stor_shrink_xfer(ss, &usb_dev_desc[device],
+						 smallblks))
+				goto resize;
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1196,7 +1242,7 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_XFER_BLK)
+	if (blkcnt > USB_MIN_XFER_BLK)
 		debug("\n");
 	return blkcnt;
 
@@ -1247,6 +1293,7 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	ss->ifnum = ifnum;
 	ss->pusb_dev = dev;
 	ss->attention_done = 0;
+	ss->max_xfer = usb_max_bulk_xfer();
 
 	/* If the device has subclass and protocol, then use that.  Otherwise,
 	 * take data from the specific interface.
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Small LRU cache of block device reads, shared by the filesystems.
+ *
+ * Filesystem drivers keep rereading the same superblock, FAT, inode table
+ * and directory sectors, both within one command and across the several
+ * lookups a boot script does. Only short reads are cached: anything longer
+ * than CONFIG_BLOCK_CACHE_BLKS blocks is file data and goes straight to the
+ * device. Each cache entry holds one such read, and a later read is a hit
+ * if it lies entirely inside an entry of the same device.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <part.h>
+#include <linux/list.h>
+
+#ifndef CONFIG_BLOCK_CACHE_ENTRIES
+#define CONFIG_BLOCK_CACHE_ENTRIES	32
+#endif
+
+#ifndef CONFIG_BLOCK_CACHE_BLKS
+#define CONFIG_BLOCK_CACHE_BLKS		8
+#endif
+
+struct blkcache_entry {
+	struct list_head lru;		/* most recently used first */
+	int		if_type;	/* device this entry belongs to */
+	int		dev;
+	unsigned long	blksz;
+	unsigned long	start;		/* first block held */
+	lbaint_t	blkcnt;		/* number of blocks held, 0 if unused */
+	size_t		size;		/* bytes allocated for data */
+	void		*data;
+};
+
+static struct blkcache_entry blkcache[CONFIG_BLOCK_CACHE_ENTRIES];
+static struct list_head blkcache_lru;
+static struct blkcache_stats blkcache_stats;
+
+static void blkcache_init(void)
+{
+	int i;
+
+	if (blkcache_lru.next)
+		return;
+
+	INIT_LIST_HEAD(&blkcache_lru);
+	for (i = 0; i < CONFIG_BLOCK_CACHE_ENTRIES; i++)
+		list_add_tail(&blkcache[i].lru, &blkcache_lru);
+}
+
+static int blkcache_same_dev(struct blkcache_entry *e,
+			     block_dev_desc_t *dev_desc)
+{
+	return e->blkcnt && e->if_type == dev_desc->if_type &&
+		e->dev == dev_desc->dev;
+}
+
+static struct blkcache_entry *blkcache_find(block_dev_desc_t *dev_desc,
+					    unsigned long start,
+					    lbaint_t blkcnt)
+{
+	struct blkcache_entry *e;
+
+	list_for_each_entry(e, &blkcache_lru, lru) {
+		if (!blkcache_same_dev(e, dev_desc) ||
+		    e->blksz != dev_desc->blksz)
+			continue;
+		if (start >= e->start &&
+		    start + blkcnt <= e->start + e->blkcnt)
+			return e;
+	}
+
+	return NULL;
+}
+
+/* Forget an entry and make it the first to be reused */
+static void blkcache_drop(struct blkcache_entry *e)
+{
+	e->blkcnt = 0;
+	list_move_tail(&e->lru, &blkcache_lru);
+}
+
+/* Store a freshly read run of blocks in the least recently used entry */
+static void blkcache_fill(block_dev_desc_t *dev_desc, unsigned long start,
+			  lbaint_t blkcnt, const void *buffer)
+{
+	struct blkcache_entry *e;
+	size_t size = blkcnt * dev_desc->blksz;
+
+	e = list_entry(blkcache_lru.prev, struct blkcache_entry, lru);
+	if (e->size < size) {
+		free(e->data);
+		e->blkcnt = 0;
+		e->size = 0;
+		e->data = malloc(size);
+		if (!e->data)
+			return;
+		e->size = size;
+	}
+
+	e->if_type = dev_desc->if_type;
+	e->dev = dev_desc->dev;
+	e->blksz = dev_desc->blksz;
+	e->start = start;
+	e->blkcnt = blkcnt;
+	memcpy(e->data, buffer, size);
+	list_move(&e->lru, &blkcache_lru);
+}
+
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, unsigned long start,
+			    lbaint_t blkcnt, void *buffer)
+{
+	struct blkcache_entry *e;
+	unsigned long n;
+
+	if (!dev_desc->block_read)
+		return 0;
+	if (blkcnt == 0 || blkcnt > CONFIG_BLOCK_CACHE_BLKS)
+		return dev_desc->block_read(dev_desc->dev, start, blkcnt,
+					    buffer);
+
+	blkcache_init();
+
+	e = blkcache_find(dev_desc, start, blkcnt);
+	if (e) {
+		memcpy(buffer, e->data + (start - e->start) * e->blksz,
+		       blkcnt * e->blksz);
+		list_move(&e->lru, &blkcache_lru);
+		blkcache_stats.hits++;
+		return blkcnt;
+	}
+
+	blkcache_stats.misses++;
+	n = dev_desc->block_read(dev_desc->dev, start, blkcnt, buffer);
+	if (n == blkcnt)
+		blkcache_fill(dev_desc, start, blkcnt, buffer);
+
+	return n;
+}
+
+unsigned long blkcache_write(block_dev_desc_t *dev_desc, unsigned long start,
+			     lbaint_t blkcnt, const void *buffer)
+{
+	struct blkcache_entry *e, *n;
+
+	if (!dev_desc->block_write)
+		return 0;
+
+	blkcache_init();
+
+	/* Drop every entry overlapping the blocks about to change */
+	list_for_each_entry_safe(e, n, &blkcache_lru, lru) {
+		if (blkcache_same_dev(e, dev_desc) &&
+		    start < e->start + e->blkcnt && e->start < start + blkcnt)
+			blkcache_drop(e);
+	}
+
+	return dev_desc->block_write(dev_desc->dev, start, blkcnt, buffer);
+}
+
+void blkcache_invalidate(block_dev_desc_t *dev_desc)
+{
+	struct blkcache_entry *e, *n;
+
+	blkcache_init();
+
+	list_for_each_entry_safe(e, n, &blkcache_lru, lru) {
+		if (e->blkcnt && (!dev_desc || blkcache_same_dev(e, dev_desc)))
+			blkcache_drop(e);
+	}
+}
+
+void blkcache_get_stats(struct blkcache_stats *stats)
+{
+	struct blkcache_entry *e;
+
+	blkcache_init();
+
+	blkcache_stats.entries = CONFIG_BLOCK_CACHE_ENTRIES;
+	blkcache_stats.max_blks = CONFIG_BLOCK_CACHE_BLKS;
+	blkcache_stats.used = 0;
+	list_for_each_entry(e, &blkcache_lru, lru) {
+		if (e->blkcnt)
+			blkcache_stats.used++;
+	}
+
+	*stats = blkcache_stats;
+}
+
+void blkcache_reset_stats(void)
+{
+	blkcache_stats.hits = 0;
+	blkcache_stats.misses = 0;
+}
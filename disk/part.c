@@ -41,7 +41,8 @@
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
-     defined(CONFIG_SYSTEMACE) )
+     defined(CONFIG_SYSTEMACE) || \
+     defined(CONFIG_SANDBOX) )
 #define HAVE_BLOCK_DEVICE
 #endif
 
@@ -68,6 +69,9 @@ static const struct block_drvr block_drvr[] = {
 #endif
 #if defined(CONFIG_SYSTEMACE)
 	{ .name = "ace", .get_dev = systemace_get_dev, },
+#endif
+#if defined(CONFIG_SANDBOX)
+	{ .name = "host", .get_dev = host_get_dev, },
 #endif
 	{ },
 };
@@ -163,6 +167,7 @@ void dev_print (block_dev_desc_t *dev_desc)
 	case IF_TYPE_SD:
 	case IF_TYPE_MMC:
 	case IF_TYPE_USB:
+	case IF_TYPE_HOST:
 		printf ("Vendor: %s Rev: %s Prod: %s\n",
 			dev_desc->vendor,
 			dev_desc->revision,
@@ -312,6 +317,9 @@ static void print_part_header (const char *type, block_dev_desc_t * dev_desc)
 	case IF_TYPE_MMC:
 		puts ("MMC");
 		break;
+	case IF_TYPE_HOST:
+		puts ("HOST");
+		break;
 	default:
 		puts ("UNKNOWN");
 		break;
@@ -452,6 +460,9 @@ int get_device(const char *ifname, const char *dev_str,
 		return -1;
 	}
 
+	/* the medium may have been swapped or written behind our back */
+	blkcache_invalidate(*dev_desc);
+
 	return dev;
 }
 
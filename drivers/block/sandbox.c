@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox "host" block devices: disk images on the host, so that the
+ * partition and filesystem code can be run and timed without hardware.
+ * An optional latency is added to every I/O to mimic a slow device.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+
+#define HOST_BLKSZ	512
+
+static struct host_block_dev host_devices[CONFIG_HOST_MAX_DEVICES];
+
+struct host_block_dev *host_get_block_dev(int dev)
+{
+	if (dev < 0 || dev >= CONFIG_HOST_MAX_DEVICES)
+		return NULL;
+
+	return &host_devices[dev];
+}
+
+static struct host_block_dev *host_find(int dev)
+{
+	struct host_block_dev *host_dev = host_get_block_dev(dev);
+
+	if (!host_dev || !host_dev->filename)
+		return NULL;
+
+	return host_dev;
+}
+
+static int host_seek(struct host_block_dev *host_dev, unsigned long start)
+{
+	off_t offset = (off_t)start * HOST_BLKSZ;
+
+	if (host_dev->latency)
+		os_usleep(host_dev->latency);
+
+	return os_lseek(host_dev->fd, offset, OS_SEEK_SET) == offset ? 0 : -1;
+}
+
+static unsigned long host_block_read(int dev, unsigned long start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	struct host_block_dev *host_dev = host_find(dev);
+	ssize_t len;
+
+	if (!host_dev || host_seek(host_dev, start))
+		return 0;
+
+	len = os_read(host_dev->fd, buffer, blkcnt * HOST_BLKSZ);
+	if (len < 0)
+		return 0;
+
+	host_dev->reads++;
+	host_dev->read_blks += len / HOST_BLKSZ;
+
+	return len / HOST_BLKSZ;
+}
+
+static unsigned long host_block_write(int dev, unsigned long start,
+				      lbaint_t blkcnt, const void *buffer)
+{
+	struct host_block_dev *host_dev = host_find(dev);
+	ssize_t len;
+
+	if (!host_dev || host_seek(host_dev, start))
+		return 0;
+
+	len = os_write(host_dev->fd, buffer, blkcnt * HOST_BLKSZ);
+	if (len < 0)
+		return 0;
+
+	host_dev->writes++;
+	host_dev->write_blks += len / HOST_BLKSZ;
+
+	return len / HOST_BLKSZ;
+}
+
+int host_dev_bind(int dev, const char *filename)
+{
+	struct host_block_dev *host_dev = host_get_block_dev(dev);
+	block_dev_desc_t *blk_dev;
+	off_t size;
+	int fd;
+
+	if (!host_dev)
+		return -1;
+
+	if (host_dev->filename) {
+		blkcache_invalidate(&host_dev->blk_dev);
+		os_close(host_dev->fd);
+		free(host_dev->filename);
+		host_dev->filename = NULL;
+	}
+	if (!filename)
+		return 0;
+
+	fd = os_open(filename, OS_O_RDWR);
+	if (fd < 0)
+		fd = os_open(filename, OS_O_RDONLY);
+	if (fd < 0) {
+		printf("Failed to access host backing file '%s'\n", filename);
+		return -1;
+	}
+
+	size = os_lseek(fd, 0, OS_SEEK_END);
+	host_dev->filename = malloc(strlen(filename) + 1);
+	if (size < 0 || !host_dev->filename) {
+		os_close(fd);
+		free(host_dev->filename);
+		host_dev->filename = NULL;
+		return -1;
+	}
+	strcpy(host_dev->filename, filename);
+	host_dev->fd = fd;
+	host_dev->reads = host_dev->read_blks = 0;
+	host_dev->writes = host_dev->write_blks = 0;
+
+	blk_dev = &host_dev->blk_dev;
+	memset(blk_dev, 0, sizeof(*blk_dev));
+	blk_dev->if_type = IF_TYPE_HOST;
+	blk_dev->dev = dev;
+	blk_dev->part_type = PART_TYPE_UNKNOWN;
+	blk_dev->type = DEV_TYPE_HARDDISK;
+	blk_dev->lba = size / HOST_BLKSZ;
+	blk_dev->blksz = HOST_BLKSZ;
+	blk_dev->block_read = host_block_read;
+	blk_dev->block_write = host_block_write;
+	blk_dev->priv = host_dev;
+	strcpy(blk_dev->vendor, "U-Boot");
+	strcpy(blk_dev->product, "host file");
+	strcpy(blk_dev->revision, "1.0");
+
+	init_part(blk_dev);
+
+	return 0;
+}
+
+block_dev_desc_t *host_get_dev(int dev)
+{
+	struct host_block_dev *host_dev = host_find(dev);
+
+	return host_dev ? &host_dev->blk_dev : NULL;
+}
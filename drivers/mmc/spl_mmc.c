@@ -32,34 +32,117 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-static void mmc_load_image_raw(struct mmc *mmc)
+#ifdef CONFIG_SPL_LZO_SUPPORT
+/* Sectors read at a time when streaming a compressed payload */
+#define MMC_STREAM_SECTORS	128
+
+struct mmc_stream {
+	struct mmc *mmc;
+	u8 *buf;		/* MMC_STREAM_SECTORS sectors of scratch */
+	u32 sector;		/* next sector to fill buf from */
+	u32 left;		/* payload bytes not read from the card yet */
+	u32 pos;		/* first unconsumed byte in buf */
+	u32 fill;		/* valid bytes in buf */
+};
+
+static int mmc_stream_read(void *priv, void *buf, int len)
+{
+	struct mmc_stream *s = priv;
+	u32 blksz = s->mmc->read_bl_len;
+	u32 cnt;
+	int done = 0, n;
+
+	while (done < len) {
+		if (s->pos == s->fill) {
+			if (!s->left)
+				break;
+			cnt = min(s->left, (u32)MMC_STREAM_SECTORS * blksz);
+			n = (cnt + blksz - 1) / blksz;
+			if (s->mmc->block_dev.block_read(0, s->sector, n,
+							 s->buf) != n)
+				return -1;
+			s->sector += n;
+			s->left -= cnt;
+			s->pos = 0;
+			s->fill = cnt;
+		}
+		n = min((u32)(len - done), s->fill - s->pos);
+		memcpy(buf + done, s->buf + s->pos, n);
+		s->pos += n;
+		done += n;
+	}
+
+	return done;
+}
+
+/*
+ * Decode a compressed payload as it comes off the card, through a bounded
+ * buffer in the DRAM above the destination.
+ */
+static void mmc_load_image_raw_lzo(struct mmc *mmc, u32 sector,
+				   const struct image_header *header)
+{
+	u32 blksz = mmc->read_bl_len;
+	struct mmc_stream s;
+
+	s.mmc = mmc;
+	s.buf = spl_lzo_scratch();
+	/* the first sector is already in, holding the header */
+	memcpy(s.buf, header, blksz);
+	s.sector = sector + 1;
+	s.pos = sizeof(struct image_header);
+	s.fill = min(blksz, s.pos + spl_image.size);
+	s.left = s.pos + spl_image.size - s.fill;
+
+	spl_load_compressed(mmc_stream_read, &s);
+}
+#endif
+
+/*
+ * Load the image stored from 'sector' on, reading no more than 'maxsize'
+ * bytes of it when that is known
+ */
+static int mmc_load_image_sector(struct mmc *mmc, u32 sector, u32 maxsize)
 {
-	u32 image_size_sectors, err;
+	u32 image_size_sectors;
 	const struct image_header *header;
+	int err;
 
 	header = (struct image_header *)(CONFIG_SYS_TEXT_BASE -
 						sizeof(struct image_header));
 
 	/* read image header to find the image size & load address */
-	err = mmc->block_dev.block_read(0,
-			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR, 1,
-			(void *)header);
-
+	err = mmc->block_dev.block_read(0, sector, 1, (void *)header);
 	if (err <= 0)
-		goto end;
+		return err;
 
 	spl_parse_image_header(header);
 
+#ifdef CONFIG_SPL_LZO_SUPPORT
+	if (spl_image.comp != IH_COMP_NONE) {
+		mmc_load_image_raw_lzo(mmc, sector, header);
+		return 1;
+	}
+#endif
+
+	if (maxsize && spl_image.size > maxsize)
+		spl_image.size = maxsize;
+
 	/* convert size to sectors - round up */
 	image_size_sectors = (spl_image.size + mmc->read_bl_len - 1) /
 				mmc->read_bl_len;
 
 	/* Read the header too to avoid extra memcpy */
-	err = mmc->block_dev.block_read(0,
-			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR,
-			image_size_sectors, (void *)spl_image.load_addr);
+	return mmc->block_dev.block_read(0, sector, image_size_sectors,
+					 (void *)spl_image.load_addr);
+}
 
-end:
+static void mmc_load_image_raw(struct mmc *mmc)
+{
+	int err;
+
+	err = mmc_load_image_sector(mmc,
+			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR, 0);
 	if (err <= 0) {
 		printf("spl: mmc blk read err - %d\n", err);
 		hang();
@@ -72,6 +155,8 @@ static void mmc_load_image_fat(struct mmc *mmc)
 	s32 err;
 	struct image_header *header;
 	char *payloadname;
+	lbaint_t blk;
+	long size;
 
 	header = (struct image_header *)(CONFIG_SYS_TEXT_BASE -
 						sizeof(struct image_header));
@@ -84,6 +169,18 @@ static void mmc_load_image_fat(struct mmc *mmc)
 	}
 
 	payloadname = CONFIG_SPL_FAT_LOAD_PAYLOAD_NAME;
+
+	/*
+	 * A payload stored in one run of clusters, as on any freshly
+	 * written boot partition, is read like a raw image: one lookup,
+	 * then a single block read.
+	 */
+	size = file_fat_map(payloadname, &blk);
+	if (size > 0) {
+		err = mmc_load_image_sector(mmc, blk, size);
+		goto end;
+	}
+
 	err = file_fat_read(payloadname,
 				(u8 *)header, sizeof(struct image_header));
 	if (err <= 0) {
@@ -97,6 +194,19 @@ static void mmc_load_image_fat(struct mmc *mmc)
 
 	spl_parse_image_header(header);
 
+#ifdef CONFIG_SPL_LZO_SUPPORT
+	if (spl_image.comp != IH_COMP_NONE) {
+		u8 *buf = spl_lzo_scratch();
+
+		err = file_fat_read(payloadname, buf, 0);
+		if (err <= 0)
+			goto end;
+		spl_load_compressed_buf(buf + sizeof(struct image_header),
+					spl_image.size);
+		return;
+	}
+#endif
+
 	err = file_fat_read(payloadname,
 				(u8 *)spl_image.load_addr, 0);
 
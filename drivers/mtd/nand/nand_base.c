@@ -437,6 +437,11 @@ static int nand_default_block_markbad(struct mtd_info *mtd, loff_t ofs)
 				i < 2);
 
 		nand_release_device(mtd);
+#ifdef CONFIG_NAND_BBT_STASH
+		/* Keep the stashed bbt in line with the memory based one */
+		if (chip->bbt)
+			nand_update_bbt_stash(mtd);
+#endif
 	}
 	if (!ret)
 		mtd->ecc_stats.badblocks++;
@@ -2238,6 +2243,9 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 	loff_t rewrite_bbt[CONFIG_SYS_NAND_MAX_CHIPS] = {0};
 	unsigned int bbt_masked_page = 0xffffffff;
 	loff_t len;
+#ifdef CONFIG_NAND_BBT_STASH
+	int stash_stale = 0;
+#endif
 
 	MTDDEBUG(MTD_DEBUG_LEVEL3, "%s: start = 0x%012llx, len = %llu\n",
 				__func__, (unsigned long long)instr->addr,
@@ -2296,6 +2304,18 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 			goto erase_exit;
 		}
 
+#ifdef CONFIG_NAND_BBT_STASH
+		/* The bbt may be an old stashed one, trust the marker */
+		if (!instr->scrub && !allowbbt && nand_recheck_bbt_stash(mtd,
+					((loff_t) page) << chip->page_shift)) {
+			printk(KERN_WARNING "%s: attempt to erase a bad block "
+					"at page 0x%08x\n", __func__, page);
+			instr->state = MTD_ERASE_FAILED;
+			stash_stale = 1;
+			goto erase_exit;
+		}
+#endif
+
 		/*
 		 * Invalidate the page cache, if we erase the block which
 		 * contains the current cached page
@@ -2364,6 +2384,11 @@ erase_exit:
 	/* Deselect and wake up anyone waiting on the device */
 	nand_release_device(mtd);
 
+#ifdef CONFIG_NAND_BBT_STASH
+	if (stash_stale)
+		nand_update_bbt_stash(mtd);
+#endif
+
 	/* Do call back function */
 	if (!ret)
 		mtd_erase_callback(instr);
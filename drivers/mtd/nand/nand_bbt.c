@@ -1138,6 +1138,280 @@ static void verify_bbt_descr(struct mtd_info *mtd, struct nand_bbt_descr *bd)
 	BUG_ON(table_size > (1 << this->bbt_erase_shift));
 }
 
+#ifdef CONFIG_NAND_BBT_STASH
+/*
+ * Without a flash based bbt the whole device is scanned for bad block
+ * markers whenever the bbt is built. To avoid that, the memory based bbt
+ * is stashed in a reserved area of the device after a scan, and read back
+ * from there when a valid copy is found. Each copy starts an eraseblock of
+ * the area. A new copy goes to the next good block, so that the previous
+ * one survives an interrupted update, and the newest copy is the one with
+ * the highest generation.
+ */
+#if !defined(CONFIG_SYS_NAND_BBT_STASH_OFFS) || \
+	!defined(CONFIG_SYS_NAND_BBT_STASH_SIZE)
+#error "CONFIG_NAND_BBT_STASH needs CONFIG_SYS_NAND_BBT_STASH_OFFS and _SIZE"
+#endif
+
+#define NAND_BBT_STASH_MAGIC	0x42627453	/* "BbtS" */
+
+/* Header of a stashed bbt, all fields big endian */
+struct nand_bbt_stash_hdr {
+	uint32_t magic;
+	uint32_t generation;
+	uint32_t numblocks;	/* eraseblocks in the device */
+	uint32_t erasesize;
+	uint32_t len;		/* bytes of bbt following the header */
+	uint32_t crc;		/* of the header with crc = 0, and the bbt */
+};
+
+static inline int bbt_stash_first(struct nand_chip *this)
+{
+	return CONFIG_SYS_NAND_BBT_STASH_OFFS >> this->bbt_erase_shift;
+}
+
+static inline int bbt_stash_count(struct nand_chip *this)
+{
+	return CONFIG_SYS_NAND_BBT_STASH_SIZE >> this->bbt_erase_shift;
+}
+
+/* Size of a stashed bbt on flash, in whole pages */
+static size_t bbt_stash_size(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd->priv;
+	size_t len = sizeof(struct nand_bbt_stash_hdr) +
+		(mtd->size >> (this->bbt_erase_shift + 2));
+
+	return (len + mtd->writesize - 1) & ~(mtd->writesize - 1);
+}
+
+static uint32_t bbt_stash_crc(struct nand_bbt_stash_hdr *hdr)
+{
+	uint32_t saved = hdr->crc, crc;
+
+	hdr->crc = 0;
+	crc = crc32(0, (uint8_t *)hdr, sizeof(*hdr) + be32_to_cpu(hdr->len));
+	hdr->crc = saved;
+
+	return crc;
+}
+
+/*
+ * Keep the stash area from being erased / written like the flash based
+ * bbt, with the reserved mark 0x02
+ */
+static void mark_bbt_stash_region(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd->priv;
+	int block = bbt_stash_first(this);
+	int last = block + bbt_stash_count(this);
+
+	for (; block < last; block++)
+		if (!((this->bbt[block >> 2] >> ((block & 0x03) << 1)) & 0x03))
+			this->bbt[block >> 2] |= 0x02 << ((block & 0x03) << 1);
+}
+
+/**
+ * nand_load_bbt_stash - [GENERIC] read the memory based bbt from the stash
+ * @mtd:	MTD device structure
+ *
+ * Looks for the newest valid copy in the stash area and loads it into the
+ * memory based bbt. Returns 0 if one was found.
+ */
+static int nand_load_bbt_stash(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd->priv;
+	struct nand_bbt_stash_hdr *hdr;
+	int len = mtd->size >> (this->bbt_erase_shift + 2);
+	int numblocks = mtd->size >> this->bbt_erase_shift;
+	int block, last, found = 0, res, i;
+	size_t size = bbt_stash_size(mtd);
+	size_t retlen;
+	uint32_t gen;
+	uint8_t *buf;
+
+	this->bbt_stash_block = -1;
+	if (size > mtd->erasesize) {
+		printk(KERN_WARNING "nand_bbt: bbt does not fit the stash blocks\n");
+		return -EFBIG;
+	}
+
+	buf = kmalloc(size, GFP_KERNEL);
+	if (!buf) {
+		printk(KERN_ERR "nand_load_bbt_stash: Out of memory\n");
+		return -ENOMEM;
+	}
+	hdr = (struct nand_bbt_stash_hdr *)buf;
+
+	block = bbt_stash_first(this);
+	last = block + bbt_stash_count(this);
+	for (; block < last; block++) {
+		res = mtd->read(mtd, (loff_t)block << this->bbt_erase_shift,
+				size, &retlen, buf);
+		if (res && res != -EUCLEAN)
+			continue;
+
+		if (be32_to_cpu(hdr->magic) != NAND_BBT_STASH_MAGIC ||
+		    be32_to_cpu(hdr->numblocks) != numblocks ||
+		    be32_to_cpu(hdr->erasesize) != mtd->erasesize ||
+		    be32_to_cpu(hdr->len) != len)
+			continue;
+
+		gen = be32_to_cpu(hdr->generation);
+		if (found && (int32_t)(gen - this->bbt_stash_gen) <= 0)
+			continue;
+		if (be32_to_cpu(hdr->crc) != bbt_stash_crc(hdr))
+			continue;
+
+		memcpy(this->bbt, buf + sizeof(*hdr), len);
+		this->bbt_stash_gen = gen;
+		this->bbt_stash_block = block;
+		found = 1;
+	}
+	kfree(buf);
+
+	if (!found)
+		return -ENOENT;
+
+	MTDDEBUG(MTD_DEBUG_LEVEL0, "Loaded bbt generation %u from block %d\n",
+		 this->bbt_stash_gen, this->bbt_stash_block);
+
+	/* Count bad blocks as the scan would have */
+	for (i = 0; i < numblocks; i++) {
+		res = (this->bbt[i >> 2] >> ((i & 0x03) << 1)) & 0x03;
+		if (res == 0x01 || res == 0x03)
+			mtd->ecc_stats.badblocks++;
+	}
+	return 0;
+}
+
+/**
+ * nand_update_bbt_stash - [NAND Interface] stash the memory based bbt
+ * @mtd:	MTD device structure
+ *
+ * Writes the memory based bbt to the stash area as a new generation,
+ * leaving the previous copy alone if there is another good block.
+ */
+int nand_update_bbt_stash(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd->priv;
+	struct nand_bbt_stash_hdr *hdr;
+	struct erase_info einfo;
+	int len, first, count, next, block, i, res = -EIO;
+	size_t size = bbt_stash_size(mtd);
+	size_t retlen;
+	uint8_t *buf;
+	loff_t offs;
+
+	/* Only a memory based bbt is stashed */
+	if (!this->bbt || this->bbt_td)
+		return -EINVAL;
+	if (size > mtd->erasesize)
+		return -EFBIG;
+
+	buf = kmalloc(size, GFP_KERNEL);
+	if (!buf) {
+		printk(KERN_ERR "nand_update_bbt_stash: Out of memory\n");
+		return -ENOMEM;
+	}
+	memset(buf, 0xff, size);
+
+	len = mtd->size >> (this->bbt_erase_shift + 2);
+	hdr = (struct nand_bbt_stash_hdr *)buf;
+	hdr->magic = cpu_to_be32(NAND_BBT_STASH_MAGIC);
+	hdr->generation = cpu_to_be32(this->bbt_stash_gen + 1);
+	hdr->numblocks = cpu_to_be32(mtd->size >> this->bbt_erase_shift);
+	hdr->erasesize = cpu_to_be32(mtd->erasesize);
+	hdr->len = cpu_to_be32(len);
+	memcpy(buf + sizeof(*hdr), this->bbt, len);
+	hdr->crc = cpu_to_be32(bbt_stash_crc(hdr));
+
+	/* Start after the block holding the current copy */
+	first = bbt_stash_first(this);
+	count = bbt_stash_count(this);
+	next = this->bbt_stash_block < 0 ? 0 :
+		this->bbt_stash_block - first + 1;
+
+	for (i = 0; i < count; i++) {
+		block = first + (next + i) % count;
+		offs = (loff_t)block << this->bbt_erase_shift;
+		if (nand_isbad_bbt(mtd, offs, 1))
+			continue;
+
+		memset(&einfo, 0, sizeof(einfo));
+		einfo.mtd = mtd;
+		einfo.addr = offs;
+		einfo.len = mtd->erasesize;
+		res = nand_erase_nand(mtd, &einfo, 1);
+		if (!res)
+			res = mtd->write(mtd, offs, size, &retlen, buf);
+		if (!res) {
+			this->bbt_stash_gen++;
+			this->bbt_stash_block = block;
+			break;
+		}
+		printk(KERN_WARNING "nand_bbt: Cannot stash bbt at 0x%012llx\n",
+		       (unsigned long long)offs);
+	}
+	kfree(buf);
+
+	return res;
+}
+
+/**
+ * nand_recheck_bbt_stash - [NAND Interface] check the marker of a good block
+ * @mtd:	MTD device structure
+ * @offs:	offset of the block
+ *
+ * A stashed bbt is not checked against the bad block markers again, so a
+ * block marked bad after the stash was written (e.g. by another OS) still
+ * shows up as good. Erasing it would wipe the marker for good, so callers
+ * read the marker first. Returns 1, and marks the block bad in the memory
+ * based bbt, if the marker says it is bad. The chip must be selected.
+ */
+int nand_recheck_bbt_stash(struct mtd_info *mtd, loff_t offs)
+{
+	struct nand_chip *this = mtd->priv;
+	int block = (int)(offs >> this->bbt_erase_shift);
+
+	if (!this->bbt || this->bbt_td || !this->block_bad(mtd, offs, 0))
+		return 0;
+
+	printk(KERN_WARNING "nand_bbt: stashed bbt missed bad block at "
+	       "0x%012llx\n", (unsigned long long)offs);
+	this->bbt[block >> 2] |= 0x03 << ((block & 0x03) << 1);
+	mtd->ecc_stats.badblocks++;
+
+	return 1;
+}
+
+/**
+ * nand_erase_bbt_stash - [NAND Interface] drop the stashed bbt
+ * @mtd:	MTD device structure
+ *
+ * Erases the stash area, so that the next bbt scan reads the bad block
+ * markers of the whole device again.
+ */
+int nand_erase_bbt_stash(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd->priv;
+	struct erase_info einfo;
+	int block = bbt_stash_first(this);
+	int last = block + bbt_stash_count(this);
+
+	for (; block < last; block++) {
+		memset(&einfo, 0, sizeof(einfo));
+		einfo.mtd = mtd;
+		einfo.addr = (loff_t)block << this->bbt_erase_shift;
+		einfo.len = mtd->erasesize;
+		nand_erase_nand(mtd, &einfo, 1);
+	}
+	this->bbt_stash_block = -1;
+
+	return 0;
+}
+#endif /* CONFIG_NAND_BBT_STASH */
+
 /**
  * nand_scan_bbt - [NAND Interface] scan, find, read and maybe create bad block table(s)
  * @mtd:	MTD device structure
@@ -1172,12 +1446,23 @@ int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd)
 	 * to build a memory based bad block table
 	 */
 	if (!td) {
+#ifdef CONFIG_NAND_BBT_STASH
+		if (!nand_load_bbt_stash(mtd)) {
+			mark_bbt_stash_region(mtd);
+			return 0;
+		}
+#endif
 		if ((res = nand_memory_bbt(mtd, bd))) {
 			printk(KERN_ERR "nand_bbt: Can't scan flash and build the RAM-based BBT\n");
 			kfree(this->bbt);
 			this->bbt = NULL;
+			return res;
 		}
-		return res;
+#ifdef CONFIG_NAND_BBT_STASH
+		mark_bbt_stash_region(mtd);
+		nand_update_bbt_stash(mtd);
+#endif
+		return 0;
 	}
 	verify_bbt_descr(mtd, td);
 	verify_bbt_descr(mtd, md);
@@ -74,14 +74,33 @@ static const u_char nand_ecc_precalc_table[] = {
 	0x00, 0x55, 0x56, 0x03, 0x59, 0x0c, 0x0f, 0x5a, 0x5a, 0x0f, 0x0c, 0x59, 0x03, 0x56, 0x55, 0x00
 };
 
-/**
- * nand_calculate_ecc - [NAND Interface] Calculate 3-byte ECC for 256-byte block
- * @mtd:	MTD block structure
- * @dat:	raw data
- * @ecc_code:	buffer for ECC
+/*
+ * Inverted parity of every byte value: 1 if it has an even number of bits set
  */
-int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat,
-		       u_char *ecc_code)
+static const u_char nand_ecc_invparity[256] = {
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+	1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1
+};
+
+/*
+ * Byte at a time version of the calculation below, for buffers which are not
+ * word aligned
+ */
+static void nand_calculate_ecc_bytes(const u_char *dat, u_char *ecc_code)
 {
 	uint8_t idx, reg1, reg2, reg3, tmp1, tmp2;
 	int i;
@@ -131,6 +150,193 @@ int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat,
 #endif
 	ecc_code[2] = ((~reg1) << 2) | 0x03;
 
+}
+
+/**
+ * nand_calculate_ecc - [NAND Interface] Calculate 3-byte ECC for 256-byte block
+ * @mtd:	MTD block structure
+ * @dat:	raw data
+ * @ecc_code:	buffer for ECC
+ *
+ * The block is processed a 32-bit word at a time. All 16 line parities only
+ * depend on which words and which byte lanes of a word a byte sits in, so
+ * they are gathered as XORs of whole words and folded down to bytes at the
+ * end, instead of looking up and branching on every byte.
+ */
+int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat,
+		       u_char *ecc_code)
+{
+	const uint32_t *bp = (const uint32_t *)dat;
+	uint32_t cur, par, tmppar;
+	uint32_t rp0, rp1, rp2, rp3, rp4, rp5, rp6, rp7;
+	uint32_t rp8, rp9, rp10, rp11, rp12, rp13, rp14, rp15;
+	u_char code0, code1;
+	int i;
+
+	if ((unsigned long)dat & (sizeof(uint32_t) - 1)) {
+		nand_calculate_ecc_bytes(dat, ecc_code);
+		return 0;
+	}
+
+	/*
+	 * rpN with N even is the parity of the bytes whose address has bit
+	 * N / 2 clear. Each pass takes 16 words: rp4 .. rp10 select by the
+	 * word index within the pass, rp12 and rp14 by the pass.
+	 */
+	par = rp4 = rp6 = rp8 = rp10 = rp12 = rp14 = 0;
+	for (i = 0; i < 4; i++) {
+		cur = *bp++;
+		tmppar = cur;
+		rp4 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp6 ^= tmppar;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp8 ^= tmppar;
+
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		rp6 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp6 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp10 ^= tmppar;
+
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		rp6 ^= cur;
+		rp8 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp6 ^= cur;
+		rp8 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		rp8 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp8 ^= cur;
+
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		rp6 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp6 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+		rp4 ^= cur;
+		cur = *bp++;
+		tmppar ^= cur;
+
+		par ^= tmppar;
+		if ((i & 0x1) == 0)
+			rp12 ^= tmppar;
+		if ((i & 0x2) == 0)
+			rp14 ^= tmppar;
+	}
+
+	/* Fold the word-wide parities down to bytes */
+	rp4 ^= rp4 >> 16;
+	rp4 ^= rp4 >> 8;
+	rp4 &= 0xff;
+	rp6 ^= rp6 >> 16;
+	rp6 ^= rp6 >> 8;
+	rp6 &= 0xff;
+	rp8 ^= rp8 >> 16;
+	rp8 ^= rp8 >> 8;
+	rp8 &= 0xff;
+	rp10 ^= rp10 >> 16;
+	rp10 ^= rp10 >> 8;
+	rp10 &= 0xff;
+	rp12 ^= rp12 >> 16;
+	rp12 ^= rp12 >> 8;
+	rp12 &= 0xff;
+	rp14 ^= rp14 >> 16;
+	rp14 ^= rp14 >> 8;
+	rp14 &= 0xff;
+
+	/* rp0 .. rp3 select by byte lane, which depends on the endianness */
+#ifdef __BIG_ENDIAN
+	rp2 = par >> 16;
+	rp2 ^= rp2 >> 8;
+	rp2 &= 0xff;
+	rp3 = par & 0xffff;
+	rp3 ^= rp3 >> 8;
+	rp3 &= 0xff;
+#else
+	rp3 = par >> 16;
+	rp3 ^= rp3 >> 8;
+	rp3 &= 0xff;
+	rp2 = par & 0xffff;
+	rp2 ^= rp2 >> 8;
+	rp2 &= 0xff;
+#endif
+	par ^= par >> 16;
+#ifdef __BIG_ENDIAN
+	rp0 = (par >> 8) & 0xff;
+	rp1 = par & 0xff;
+#else
+	rp1 = (par >> 8) & 0xff;
+	rp0 = par & 0xff;
+#endif
+	par ^= par >> 8;
+	par &= 0xff;
+
+	/* The odd parities are what the even ones leave of the total */
+	rp5 = (par ^ rp4) & 0xff;
+	rp7 = (par ^ rp6) & 0xff;
+	rp9 = (par ^ rp8) & 0xff;
+	rp11 = (par ^ rp10) & 0xff;
+	rp13 = (par ^ rp12) & 0xff;
+	rp15 = (par ^ rp14) & 0xff;
+
+	code0 = (nand_ecc_invparity[rp15] << 7) |
+		(nand_ecc_invparity[rp14] << 6) |
+		(nand_ecc_invparity[rp13] << 5) |
+		(nand_ecc_invparity[rp12] << 4) |
+		(nand_ecc_invparity[rp11] << 3) |
+		(nand_ecc_invparity[rp10] << 2) |
+		(nand_ecc_invparity[rp9] << 1) |
+		nand_ecc_invparity[rp8];
+	code1 = (nand_ecc_invparity[rp7] << 7) |
+		(nand_ecc_invparity[rp6] << 6) |
+		(nand_ecc_invparity[rp5] << 5) |
+		(nand_ecc_invparity[rp4] << 4) |
+		(nand_ecc_invparity[rp3] << 3) |
+		(nand_ecc_invparity[rp2] << 2) |
+		(nand_ecc_invparity[rp1] << 1) |
+		nand_ecc_invparity[rp0];
+
+#ifdef CONFIG_MTD_NAND_ECC_SMC
+	ecc_code[0] = code1;
+	ecc_code[1] = code0;
+#else
+	ecc_code[0] = code0;
+	ecc_code[1] = code1;
+#endif
+	/* Column parities CP5 .. CP0 */
+	ecc_code[2] = (nand_ecc_invparity[par & 0xf0] << 7) |
+		      (nand_ecc_invparity[par & 0x0f] << 6) |
+		      (nand_ecc_invparity[par & 0xcc] << 5) |
+		      (nand_ecc_invparity[par & 0x33] << 4) |
+		      (nand_ecc_invparity[par & 0xaa] << 3) |
+		      (nand_ecc_invparity[par & 0x55] << 2) |
+		      3;
+
 	return 0;
 }
 #endif /* CONFIG_NAND_SPL */
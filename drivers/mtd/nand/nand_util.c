@@ -195,8 +195,13 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 	if (!opts->quiet)
 		printf("\n");
 
-	if (opts->scrub)
+	if (opts->scrub) {
+#ifdef CONFIG_NAND_BBT_STASH
+		/* the stashed bbt still has the markers scrubbed away */
+		nand_erase_bbt_stash(meminfo);
+#endif
 		chip->scan_bbt(meminfo);
+	}
 
 	return 0;
 }
@@ -0,0 +1,660 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox NAND chip, kept in a file on the host (--nand). The file holds
+ * every page followed by its OOB area, which is the layout of 'nanddump -o'
+ * and 'nandwrite -o'; past the end of a short file the chip is erased.
+ *
+ * The chip is driven through cmd_ctrl() and the byte/buffer accessors like
+ * real hardware, so nand_base.c, the software ECC and the bad block scan
+ * all run unchanged. It identifies itself through an ONFI parameter page,
+ * which lets --nand_geometry pick any page, OOB and erase block size.
+ *
+ * Every page read, program and erase is counted along with the time the
+ * array and the bus would have taken (--nand_timing). With --nand_delay
+ * that time is also really spent, so 'time' shows it.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <nand.h>
+#include <os.h>
+#include <sandboxnand.h>
+#include <asm/errno.h>
+#include <asm/getopt.h>
+#include <asm/state.h>
+#include <linux/mtd/nand.h>
+
+#define SANDBOX_NAND_MFR	NAND_MFR_MICRON
+#define SANDBOX_NAND_ID		0x00	/* not in nand_flash_ids, use ONFI */
+
+enum {
+	NS_OUT_NONE,
+	NS_OUT_DATA,		/* page register */
+	NS_OUT_ID,
+	NS_OUT_ONFI,		/* ONFI signature */
+	NS_OUT_PARAM,		/* ONFI parameter page */
+	NS_OUT_STATUS,
+};
+
+struct sandbox_nand {
+	int fd;
+	unsigned int page_size;
+	unsigned int oob_size;
+	unsigned int pages_per_block;
+	unsigned int blocks;
+	unsigned int row_cycles;	/* page address bytes */
+	unsigned int ecc_bits;		/* 1: Hamming, else BCH strength */
+	u8 *reg;			/* page register, data and OOB */
+	unsigned int file_pages;	/* pages present in the host file */
+	u8 *bad;			/* injected bad blocks */
+	unsigned int cmd;		/* last command latched */
+	u8 addr[5];
+	unsigned int naddr;
+	unsigned int page;
+	unsigned int col;
+	int out;
+	unsigned int pos;		/* position in ID or parameter page */
+	u8 status;
+	unsigned int bitflips;
+	int delay;
+	const char *bad_list;
+	struct nand_onfi_params param;
+	struct sandbox_nand_timing timing;
+	struct sandbox_nand_stats stats;
+};
+
+static struct sandbox_nand sandbox_nand = {
+	.fd = -1,
+	.page_size = 2048,
+	.oob_size = 64,
+	.pages_per_block = 64,
+	.blocks = 1024,
+	.ecc_bits = 1,
+	.timing = {
+		.t_r = 25,
+		.t_prog = 200,
+		.t_bers = 1500,
+		.t_rc = 25,
+	},
+};
+
+static int sb_cmdline_cb_nand(struct sandbox_state *state, const char *arg)
+{
+	state->nand = arg;
+	return 0;
+}
+SB_CMDLINE_OPT(nand, 1, "Host file backing the NAND chip");
+
+static int sb_cmdline_cb_nand_geometry(struct sandbox_state *state,
+				       const char *arg)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+	char *end;
+
+	ns->page_size = simple_strtoul(arg, &end, 0);
+	if (*end++ != ',')
+		return 1;
+	ns->oob_size = simple_strtoul(end, &end, 0);
+	if (*end++ != ',')
+		return 1;
+	ns->pages_per_block = simple_strtoul(end, &end, 0);
+	if (*end++ != ',')
+		return 1;
+	ns->blocks = simple_strtoul(end, &end, 0);
+
+	return *end != '\0';
+}
+SB_CMDLINE_OPT(nand_geometry, 1,
+	       "NAND page,oob,pages per block,blocks (2048,64,64,1024)");
+
+static int sb_cmdline_cb_nand_ecc(struct sandbox_state *state,
+				  const char *arg)
+{
+	sandbox_nand.ecc_bits = simple_strtoul(arg, NULL, 0);
+	return sandbox_nand.ecc_bits < 1;
+}
+SB_CMDLINE_OPT(nand_ecc, 1, "NAND ECC bits per 512 bytes, 1 for Hamming");
+
+static int sb_cmdline_cb_nand_bad(struct sandbox_state *state,
+				  const char *arg)
+{
+	sandbox_nand.bad_list = arg;
+	return 0;
+}
+SB_CMDLINE_OPT(nand_bad, 1, "Comma-separated NAND blocks to make bad");
+
+static int sb_cmdline_cb_nand_bitflips(struct sandbox_state *state,
+				       const char *arg)
+{
+	sandbox_nand.bitflips = simple_strtoul(arg, NULL, 0);
+	return 0;
+}
+SB_CMDLINE_OPT(nand_bitflips, 1, "Bits to flip in every NAND page read");
+
+static int sb_cmdline_cb_nand_timing(struct sandbox_state *state,
+				     const char *arg)
+{
+	struct sandbox_nand_timing *t = &sandbox_nand.timing;
+	char *end;
+
+	t->t_r = simple_strtoul(arg, &end, 0);
+	if (*end++ != ',')
+		return 1;
+	t->t_prog = simple_strtoul(end, &end, 0);
+	if (*end++ != ',')
+		return 1;
+	t->t_bers = simple_strtoul(end, &end, 0);
+	if (*end == ',')
+		t->t_rc = simple_strtoul(end + 1, &end, 0);
+
+	return *end != '\0';
+}
+SB_CMDLINE_OPT(nand_timing, 1,
+	       "NAND tR,tPROG,tBERS in us[,tRC in ns] (25,200,1500,25)");
+
+static int sb_cmdline_cb_nand_delay(struct sandbox_state *state,
+				    const char *arg)
+{
+	sandbox_nand.delay = 1;
+	return 0;
+}
+SB_CMDLINE_OPT(nand_delay, 0, "Really wait for the modelled NAND timing");
+
+static void sandbox_nand_busy(struct sandbox_nand *ns, u64 *counter,
+			      u64 nsec)
+{
+	*counter += nsec;
+	if (ns->delay && nsec >= 1000)
+		os_usleep(nsec / 1000);
+}
+
+static u32 sandbox_nand_random(u32 *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+static int sandbox_nand_seek(struct sandbox_nand *ns, unsigned int page)
+{
+	off_t offset = (off_t)page * (ns->page_size + ns->oob_size);
+
+	return os_lseek(ns->fd, offset, OS_SEEK_SET) == offset ? 0 : -1;
+}
+
+/* Read a page with its OOB area, past the end of the file it is erased */
+static void sandbox_nand_load(struct sandbox_nand *ns, unsigned int page,
+			      u8 *buf)
+{
+	unsigned int len = ns->page_size + ns->oob_size;
+	ssize_t got = -1;
+
+	if (!sandbox_nand_seek(ns, page))
+		got = os_read(ns->fd, buf, len);
+	if (got < 0)
+		got = 0;
+	memset(buf + got, 0xff, len - got);
+}
+
+static int sandbox_nand_store(struct sandbox_nand *ns, unsigned int page,
+			      const u8 *buf)
+{
+	unsigned int len = ns->page_size + ns->oob_size;
+	u8 *erased;
+
+	/* a hole in the host file would read as zeroes, i.e. as bad blocks */
+	if (page > ns->file_pages) {
+		erased = malloc(len);
+		if (!erased)
+			return -1;
+		memset(erased, 0xff, len);
+		while (ns->file_pages < page) {
+			if (sandbox_nand_seek(ns, ns->file_pages) ||
+			    os_write(ns->fd, erased, len) != len)
+				break;
+			ns->file_pages++;
+		}
+		free(erased);
+		if (ns->file_pages < page)
+			return -1;
+	}
+
+	if (sandbox_nand_seek(ns, page) || os_write(ns->fd, buf, len) != len)
+		return -1;
+	if (page >= ns->file_pages)
+		ns->file_pages = page + 1;
+
+	return 0;
+}
+
+static int sandbox_nand_is_bad(struct sandbox_nand *ns, unsigned int page)
+{
+	return ns->bad[page / ns->pages_per_block];
+}
+
+static void sandbox_nand_read_page(struct sandbox_nand *ns)
+{
+	unsigned int i, bit;
+	u32 seed;
+
+	ns->stats.reads++;
+	sandbox_nand_busy(ns, &ns->stats.array_ns, ns->timing.t_r * 1000ULL);
+
+	if (sandbox_nand_is_bad(ns, ns->page)) {
+		memset(ns->reg, 0, ns->page_size + ns->oob_size);
+		return;
+	}
+
+	sandbox_nand_load(ns, ns->page, ns->reg);
+
+	/* A page always flips the same bits, like weak cells would */
+	seed = ns->page + 1;
+	for (i = 0; i < ns->bitflips; i++) {
+		bit = sandbox_nand_random(&seed) % (ns->page_size * 8);
+		ns->reg[bit / 8] ^= 1 << (bit % 8);
+		ns->stats.bitflips++;
+	}
+}
+
+/* Program: bits can only go from 1 to 0 */
+static void sandbox_nand_program(struct sandbox_nand *ns)
+{
+	unsigned int len = ns->page_size + ns->oob_size;
+	unsigned int i;
+	u8 *cur;
+
+	ns->stats.programs++;
+	sandbox_nand_busy(ns, &ns->stats.array_ns,
+			  ns->timing.t_prog * 1000ULL);
+
+	cur = malloc(len);
+	if (!cur || sandbox_nand_is_bad(ns, ns->page)) {
+		ns->status |= NAND_STATUS_FAIL;
+		free(cur);
+		return;
+	}
+
+	sandbox_nand_load(ns, ns->page, cur);
+	for (i = 0; i < len; i++)
+		cur[i] &= ns->reg[i];
+	if (sandbox_nand_store(ns, ns->page, cur))
+		ns->status |= NAND_STATUS_FAIL;
+	free(cur);
+}
+
+static void sandbox_nand_erase(struct sandbox_nand *ns)
+{
+	unsigned int first = ns->page - ns->page % ns->pages_per_block;
+	unsigned int i;
+
+	ns->stats.erases++;
+	sandbox_nand_busy(ns, &ns->stats.array_ns,
+			  ns->timing.t_bers * 1000ULL);
+
+	if (sandbox_nand_is_bad(ns, first)) {
+		ns->status |= NAND_STATUS_FAIL;
+		return;
+	}
+
+	/* the page register is not kept across an erase on real chips */
+	memset(ns->reg, 0xff, ns->page_size + ns->oob_size);
+	for (i = 0; i < ns->pages_per_block; i++) {
+		if (sandbox_nand_store(ns, first + i, ns->reg)) {
+			ns->status |= NAND_STATUS_FAIL;
+			return;
+		}
+	}
+}
+
+/* Decode the address bytes latched so far for the current command */
+static void sandbox_nand_address(struct sandbox_nand *ns)
+{
+	const u8 *row = ns->addr;
+	unsigned int i, page = 0;
+
+	switch (ns->cmd) {
+	case NAND_CMD_READID:
+		ns->out = ns->addr[0] == 0x20 ? NS_OUT_ONFI : NS_OUT_ID;
+		ns->pos = 0;
+		return;
+	case NAND_CMD_READ0:
+	case NAND_CMD_SEQIN:
+		row += 2;
+		/* fall through */
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		ns->col = ns->addr[0] | ns->addr[1] << 8;
+		if (ns->cmd == NAND_CMD_RNDOUT || ns->cmd == NAND_CMD_RNDIN)
+			return;
+		break;
+	case NAND_CMD_ERASE1:
+		break;
+	default:
+		return;
+	}
+
+	for (i = 0; i < ns->row_cycles; i++)
+		page |= row[i] << (8 * i);
+	ns->page = page & (ns->pages_per_block * ns->blocks - 1);
+}
+
+static void sandbox_nand_command(struct sandbox_nand *ns, unsigned int cmd)
+{
+	switch (cmd) {
+	case NAND_CMD_RESET:
+		ns->out = NS_OUT_NONE;
+		ns->status = NAND_STATUS_READY | NAND_STATUS_WP;
+		break;
+	case NAND_CMD_STATUS:
+		ns->out = NS_OUT_STATUS;
+		break;
+	case NAND_CMD_PARAM:
+		ns->out = NS_OUT_PARAM;
+		ns->pos = 0;
+		break;
+	case NAND_CMD_SEQIN:
+		memset(ns->reg, 0xff, ns->page_size + ns->oob_size);
+		break;
+	case NAND_CMD_READSTART:
+		sandbox_nand_read_page(ns);
+		ns->out = NS_OUT_DATA;
+		break;
+	case NAND_CMD_RNDOUTSTART:
+		ns->out = NS_OUT_DATA;
+		break;
+	case NAND_CMD_PAGEPROG:
+		ns->status &= ~NAND_STATUS_FAIL;
+		sandbox_nand_program(ns);
+		break;
+	case NAND_CMD_ERASE2:
+		ns->status &= ~NAND_STATUS_FAIL;
+		sandbox_nand_erase(ns);
+		break;
+	}
+
+	ns->cmd = cmd;
+	ns->naddr = 0;
+	memset(ns->addr, 0, sizeof(ns->addr));
+}
+
+static void sandbox_nand_cmd_ctrl(struct mtd_info *mtd, int dat,
+				  unsigned int ctrl)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+
+	if (dat == NAND_CMD_NONE)
+		return;
+
+	if (ctrl & NAND_CLE) {
+		sandbox_nand_command(ns, dat & 0xff);
+	} else if (ctrl & NAND_ALE) {
+		if (ns->naddr < sizeof(ns->addr))
+			ns->addr[ns->naddr++] = dat;
+		sandbox_nand_address(ns);
+	}
+}
+
+static int sandbox_nand_dev_ready(struct mtd_info *mtd)
+{
+	return 1;
+}
+
+static uint8_t sandbox_nand_read_byte(struct mtd_info *mtd)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+	const u8 *param = (const u8 *)&ns->param;
+	u8 id[] = { SANDBOX_NAND_MFR, SANDBOX_NAND_ID };
+	u8 val = 0;
+
+	switch (ns->out) {
+	case NS_OUT_DATA:
+		val = 0xff;
+		if (ns->col < ns->page_size + ns->oob_size)
+			val = ns->reg[ns->col];
+		ns->col++;
+		ns->stats.bytes_out++;
+		break;
+	case NS_OUT_ID:
+		if (ns->pos < sizeof(id))
+			val = id[ns->pos];
+		ns->pos++;
+		break;
+	case NS_OUT_ONFI:
+		if (ns->pos < 4)
+			val = "ONFI"[ns->pos];
+		ns->pos++;
+		break;
+	case NS_OUT_PARAM:
+		/* the parameter page is repeated */
+		val = param[ns->pos++ % sizeof(ns->param)];
+		break;
+	case NS_OUT_STATUS:
+		val = ns->status;
+		break;
+	}
+	sandbox_nand_busy(ns, &ns->stats.bus_ns, ns->timing.t_rc);
+
+	return val;
+}
+
+static void sandbox_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+	unsigned int size = ns->page_size + ns->oob_size;
+	unsigned int n;
+
+	if (ns->out != NS_OUT_DATA) {
+		while (len--)
+			*buf++ = sandbox_nand_read_byte(mtd);
+		return;
+	}
+
+	n = ns->col < size ? min(size - ns->col, (unsigned int)len) : 0;
+	memcpy(buf, ns->reg + ns->col, n);
+	memset(buf + n, 0xff, len - n);
+	ns->col += len;
+	ns->stats.bytes_out += len;
+	sandbox_nand_busy(ns, &ns->stats.bus_ns,
+			  (u64)len * ns->timing.t_rc);
+}
+
+static void sandbox_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+				   int len)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+	unsigned int size = ns->page_size + ns->oob_size;
+	unsigned int n;
+
+	n = ns->col < size ? min(size - ns->col, (unsigned int)len) : 0;
+	memcpy(ns->reg + ns->col, buf, n);
+	ns->col += len;
+	ns->stats.bytes_in += len;
+	sandbox_nand_busy(ns, &ns->stats.bus_ns,
+			  (u64)len * ns->timing.t_rc);
+}
+
+static int sandbox_nand_verify_buf(struct mtd_info *mtd, const uint8_t *buf,
+				   int len)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+	unsigned int size = ns->page_size + ns->oob_size;
+
+	if (ns->col > size || len > size - ns->col ||
+	    memcmp(buf, ns->reg + ns->col, len))
+		return -EFAULT;
+	ns->col += len;
+
+	return 0;
+}
+
+static u16 sandbox_nand_onfi_crc16(u16 crc, const u8 *p, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc << 1) ^ ((crc & 0x8000) ? 0x8005 : 0);
+	}
+
+	return crc;
+}
+
+static void sandbox_nand_init_param(struct sandbox_nand *ns)
+{
+	struct nand_onfi_params *p = &ns->param;
+
+	memset(p, 0, sizeof(*p));
+	memcpy(p->sig, "ONFI", 4);
+	p->revision = cpu_to_le16(1 << 1);	/* ONFI 1.0 */
+	memcpy(p->manufacturer, "SANDBOX     ", sizeof(p->manufacturer));
+	memcpy(p->model, "SANDBOX NAND        ", sizeof(p->model));
+	p->jedec_id = SANDBOX_NAND_MFR;
+	p->byte_per_page = cpu_to_le32(ns->page_size);
+	p->spare_bytes_per_page = cpu_to_le16(ns->oob_size);
+	p->pages_per_block = cpu_to_le32(ns->pages_per_block);
+	p->blocks_per_lun = cpu_to_le32(ns->blocks);
+	p->lun_count = 1;
+	p->addr_cycles = ns->row_cycles | 2 << 4;
+	p->bits_per_cell = 1;
+	p->programs_per_page = 4;
+	p->ecc_bits = ns->ecc_bits;
+	p->t_prog = cpu_to_le16(min(ns->timing.t_prog, 0xffffU));
+	p->t_bers = cpu_to_le16(min(ns->timing.t_bers, 0xffffU));
+	p->t_r = cpu_to_le16(min(ns->timing.t_r, 0xffffU));
+	p->crc = cpu_to_le16(sandbox_nand_onfi_crc16(ONFI_CRC_BASE,
+						      (u8 *)p, 254));
+}
+
+/* Mark the blocks listed with --nand_bad */
+static void sandbox_nand_parse_bad(struct sandbox_nand *ns)
+{
+	const char *s = ns->bad_list;
+	char *end;
+
+	while (s && *s) {
+		if (sandbox_nand_mark_bad(simple_strtoul(s, &end, 0)))
+			printf("sandbox_nand: bad block '%s' out of range\n", s);
+		if (end == s)
+			break;
+		s = *end == ',' ? end + 1 : end;
+	}
+}
+
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats)
+{
+	*stats = sandbox_nand.stats;
+}
+
+void sandbox_nand_reset_stats(void)
+{
+	memset(&sandbox_nand.stats, 0, sizeof(sandbox_nand.stats));
+}
+
+struct sandbox_nand_timing *sandbox_nand_get_timing(void)
+{
+	return &sandbox_nand.timing;
+}
+
+void sandbox_nand_set_bitflips(unsigned int bits)
+{
+	sandbox_nand.bitflips = bits;
+}
+
+int sandbox_nand_mark_bad(unsigned int block)
+{
+	struct sandbox_nand *ns = &sandbox_nand;
+
+	if (!ns->bad || block >= ns->blocks)
+		return -1;
+	ns->bad[block] = 1;
+
+	return 0;
+}
+
+static int sandbox_nand_pow2(unsigned int x)
+{
+	return x && !(x & (x - 1));
+}
+
+int board_nand_init(struct nand_chip *nand)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sandbox_nand *ns = &sandbox_nand;
+	u64 chipsize;
+
+	if (!state->nand)
+		return -ENODEV;
+
+	if (!sandbox_nand_pow2(ns->page_size) || ns->page_size < 1024 ||
+	    !sandbox_nand_pow2(ns->pages_per_block) ||
+	    !sandbox_nand_pow2(ns->blocks) || !ns->oob_size) {
+		printf("sandbox_nand: unsupported geometry %u,%u,%u,%u\n",
+		       ns->page_size, ns->oob_size, ns->pages_per_block,
+		       ns->blocks);
+		return -EINVAL;
+	}
+
+	ns->fd = os_open(state->nand, OS_O_RDWR | OS_O_CREAT);
+	if (ns->fd < 0) {
+		printf("sandbox_nand: cannot open '%s'\n", state->nand);
+		return -ENODEV;
+	}
+	ns->file_pages = os_lseek(ns->fd, 0, OS_SEEK_END) /
+		(ns->page_size + ns->oob_size);
+
+	ns->reg = malloc(ns->page_size + ns->oob_size);
+	ns->bad = calloc(ns->blocks, 1);
+	if (!ns->reg || !ns->bad) {
+		free(ns->reg);
+		free(ns->bad);
+		ns->bad = NULL;
+		os_close(ns->fd);
+		ns->fd = -1;
+		return -ENOMEM;
+	}
+
+	chipsize = (u64)ns->page_size * ns->pages_per_block * ns->blocks;
+	ns->row_cycles = chipsize > (128 << 20) ? 3 : 2;
+	ns->status = NAND_STATUS_READY | NAND_STATUS_WP;
+	sandbox_nand_init_param(ns);
+	sandbox_nand_parse_bad(ns);
+
+	nand->cmd_ctrl = sandbox_nand_cmd_ctrl;
+	nand->dev_ready = sandbox_nand_dev_ready;
+	nand->read_byte = sandbox_nand_read_byte;
+	nand->read_buf = sandbox_nand_read_buf;
+	nand->write_buf = sandbox_nand_write_buf;
+	nand->verify_buf = sandbox_nand_verify_buf;
+	nand->chip_delay = 0;
+
+	if (ns->ecc_bits > 1) {
+		/* 512-byte steps need 13 ECC bits per corrected bit */
+		nand->ecc.mode = NAND_ECC_SOFT_BCH;
+		nand->ecc.size = 512;
+		nand->ecc.bytes = DIV_ROUND_UP(13 * ns->ecc_bits, 8);
+	} else {
+		nand->ecc.mode = NAND_ECC_SOFT;
+	}
+
+	return 0;
+}
@@ -147,6 +147,107 @@ int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
 }
 
+/* Controllers that can move data on more than one wire override this */
+__weak unsigned int spi_xfer_caps(struct spi_slave *slave)
+{
+	return 0;
+}
+
+/*
+ * Multi-wire fast reads, fastest first. addr_len counts the address, mode
+ * and dummy bytes following the command; the mode byte is sent as zero so
+ * the device never enters continuous read mode.
+ */
+static const struct {
+	u8 mode;
+	u8 cmd;
+	u8 addr_len;
+	u8 addr_flags;
+	u8 data_flags;
+	u8 caps;		/* SPI_CAP_* the controller needs */
+} spi_flash_read_modes[] = {
+	{ SPI_FLASH_RD_QUAD_IO, CMD_READ_QUAD_IO_FAST, 6,
+	  SPI_XFER_QUAD, SPI_XFER_QUAD, SPI_CAP_TX_QUAD | SPI_CAP_RX_QUAD, },
+	{ SPI_FLASH_RD_QUAD, CMD_READ_QUAD_OUTPUT_FAST, 4,
+	  0, SPI_XFER_QUAD, SPI_CAP_RX_QUAD, },
+	{ SPI_FLASH_RD_DUAL_IO, CMD_READ_DUAL_IO_FAST, 4,
+	  SPI_XFER_DUAL, SPI_XFER_DUAL, SPI_CAP_TX_DUAL | SPI_CAP_RX_DUAL, },
+	{ SPI_FLASH_RD_DUAL, CMD_READ_DUAL_OUTPUT_FAST, 4,
+	  0, SPI_XFER_DUAL, SPI_CAP_RX_DUAL, },
+};
+
+static int spi_flash_cmd_read_multi(struct spi_flash *flash, u32 offset,
+		size_t len, void *data)
+{
+	struct spi_slave *spi = flash->spi;
+	u8 cmd[7];
+	int ret;
+
+	if (len == 0)
+		return 0;
+
+	cmd[0] = flash->read_cmd;
+	spi_flash_addr(offset, cmd);
+	memset(cmd + 4, 0, sizeof(cmd) - 4);
+
+	ret = spi_claim_bus(spi);
+	if (ret) {
+		debug("SF: unable to claim SPI bus\n");
+		return ret;
+	}
+
+	if (flash->read_addr_flags) {
+		/* only the command goes out on a single wire */
+		ret = spi_xfer(spi, 8, cmd, NULL, SPI_XFER_BEGIN);
+		if (!ret)
+			ret = spi_xfer(spi, flash->read_addr_len * 8, cmd + 1,
+				       NULL, flash->read_addr_flags);
+	} else {
+		ret = spi_xfer(spi, (1 + flash->read_addr_len) * 8, cmd, NULL,
+			       SPI_XFER_BEGIN);
+	}
+
+	if (ret) {
+		debug("SF: Failed to send read command %02x: %d\n",
+		      cmd[0], ret);
+		spi_xfer(spi, 0, NULL, NULL, SPI_XFER_END);
+	} else {
+		ret = spi_xfer(spi, len * 8, NULL, data,
+			       flash->read_data_flags | SPI_XFER_END);
+		if (ret)
+			debug("SF: Failed to read %zu bytes: %d\n", len, ret);
+	}
+
+	spi_release_bus(spi);
+
+	return ret;
+}
+
+int spi_flash_setup_read(struct spi_flash *flash, unsigned int modes)
+{
+	unsigned int caps = spi_xfer_caps(flash->spi);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(spi_flash_read_modes); i++) {
+		if (!(modes & spi_flash_read_modes[i].mode))
+			continue;
+		if ((caps & spi_flash_read_modes[i].caps) !=
+				spi_flash_read_modes[i].caps)
+			continue;
+
+		flash->read_cmd = spi_flash_read_modes[i].cmd;
+		flash->read_addr_len = spi_flash_read_modes[i].addr_len;
+		flash->read_addr_flags = spi_flash_read_modes[i].addr_flags;
+		flash->read_data_flags = spi_flash_read_modes[i].data_flags;
+		flash->read = spi_flash_cmd_read_multi;
+		debug("SF: Using fast read command %02x\n", flash->read_cmd);
+
+		return spi_flash_read_modes[i].mode;
+	}
+
+	return 0;
+}
+
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
 			   u8 cmd, u8 poll_bit)
 {
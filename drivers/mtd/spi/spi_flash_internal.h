@@ -17,6 +17,10 @@
 
 #define CMD_READ_ARRAY_SLOW		0x03
 #define CMD_READ_ARRAY_FAST		0x0b
+#define CMD_READ_DUAL_OUTPUT_FAST	0x3b
+#define CMD_READ_QUAD_OUTPUT_FAST	0x6b
+#define CMD_READ_DUAL_IO_FAST		0xbb
+#define CMD_READ_QUAD_IO_FAST		0xeb
 
 #define CMD_WRITE_STATUS		0x01
 #define CMD_PAGE_PROGRAM		0x02
@@ -31,6 +35,13 @@
 /* Common status */
 #define STATUS_WIP			0x01
 
+/* Multi-wire fast reads a device may support */
+#define SPI_FLASH_RD_DUAL		0x01	/* 0x3b, data on 2 wires */
+#define SPI_FLASH_RD_QUAD		0x02	/* 0x6b, data on 4 wires */
+#define SPI_FLASH_RD_DUAL_IO		0x04	/* 0xbb, address and data on 2 */
+#define SPI_FLASH_RD_QUAD_IO		0x08	/* 0xeb, address and data on 4 */
+#define SPI_FLASH_RD_QUAD_ANY	(SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO)
+
 /* Send a single-byte command to the device and read the response */
 int spi_flash_cmd(struct spi_slave *spi, u8 cmd, void *response, size_t len);
 
@@ -44,6 +55,15 @@ int spi_flash_cmd_read(struct spi_slave *spi, const u8 *cmd,
 int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 		size_t len, void *data);
 
+/*
+ * Switch flash->read to the fastest of the multi-wire reads in @modes
+ * (SPI_FLASH_RD_*) that the SPI controller can also do. The dual and
+ * quad I/O reads use the common 4 and 6 clocks of mode bits and dummy
+ * cycles after the address. Returns the mode picked, or 0 if the read
+ * method was left alone.
+ */
+int spi_flash_setup_read(struct spi_flash *flash, unsigned int modes);
+
 /*
  * Send a multi-byte command to the device followed by (optional)
  * data. Used for programming the flash array, etc.
@@ -36,10 +36,14 @@
 /* M25Pxx-specific commands */
 #define CMD_M25PXX_RES		0xab	/* Release from DP, and Read Signature */
 
+/* N25Q parts do the output fast reads without any setup */
+#define N25Q_READ_MODES		(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD)
+
 struct stmicro_spi_flash_params {
 	u16 id;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u8 read_modes;
 	const char *name;
 };
 
@@ -96,18 +100,21 @@ static const struct stmicro_spi_flash_params stmicro_spi_flash_table[] = {
 		.id = 0xba18,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.read_modes = N25Q_READ_MODES,
 		.name = "N25Q128",
 	},
 	{
 		.id = 0xbb18,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.read_modes = N25Q_READ_MODES,
 		.name = "N25Q128A",
 	},
 	{
 		.id = 0xba19,
 		.pages_per_sector = 256,
 		.nr_sectors = 512,
+		.read_modes = N25Q_READ_MODES,
 		.name = "N25Q256",
 	},
 };
@@ -162,5 +169,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 	flash->sector_size = 256 * params->pages_per_sector;
 	flash->size = flash->sector_size * params->nr_sectors;
 
+	spi_flash_setup_read(flash, params->read_modes);
+
 	return flash;
 }
@@ -10,9 +10,18 @@
 
 #include "spi_flash_internal.h"
 
+/* W25Qxx-specific commands and status */
+#define CMD_W25_READ_STATUS2	0x35
+#define W25_SR2_QE		0x02	/* IO2/IO3 enabled for quad I/O */
+
+#define W25X_READ_MODES		SPI_FLASH_RD_DUAL
+#define W25Q_READ_MODES		(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_DUAL_IO | SPI_FLASH_RD_QUAD_IO)
+
 struct winbond_spi_flash_params {
 	uint16_t	id;
 	uint16_t	nr_blocks;
+	uint8_t		read_modes;
 	const char	*name;
 };
 
@@ -20,55 +29,94 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 	{
 		.id			= 0x3013,
 		.nr_blocks		= 8,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X40",
 	},
 	{
 		.id			= 0x3015,
 		.nr_blocks		= 32,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X16",
 	},
 	{
 		.id			= 0x3016,
 		.nr_blocks		= 64,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X32",
 	},
 	{
 		.id			= 0x3017,
 		.nr_blocks		= 128,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X64",
 	},
 	{
 		.id			= 0x4014,
 		.nr_blocks		= 16,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q80BL",
 	},
 	{
 		.id			= 0x4015,
 		.nr_blocks		= 32,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q16",
 	},
 	{
 		.id			= 0x4016,
 		.nr_blocks		= 64,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q32",
 	},
 	{
 		.id			= 0x4017,
 		.nr_blocks		= 128,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q64",
 	},
 	{
 		.id			= 0x4018,
 		.nr_blocks		= 256,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q128",
 	},
 	{
 		.id			= 0x5014,
 		.nr_blocks		= 128,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q80",
 	},
 };
 
+/* The quad reads need IO2/IO3, which double as /WP and /HOLD until enabled */
+static int winbond_enable_quad(struct spi_flash *flash)
+{
+	u8 cmd = CMD_WRITE_STATUS;
+	u8 sr[2];
+	int ret;
+
+	ret = spi_flash_cmd(flash->spi, CMD_READ_STATUS, &sr[0], 1);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, CMD_W25_READ_STATUS2, &sr[1], 1);
+	if (ret)
+		return ret;
+	if (sr[1] & W25_SR2_QE)
+		return 0;
+
+	sr[1] |= W25_SR2_QE;
+	ret = spi_flash_cmd_write_enable(flash);
+	if (!ret)
+		ret = spi_flash_cmd_write(flash->spi, &cmd, 1, sr, 2);
+	if (!ret)
+		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, CMD_W25_READ_STATUS2, &sr[1], 1);
+	if (!ret && !(sr[1] & W25_SR2_QE))
+		ret = -1;
+
+	return ret;
+}
+
 struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 {
 	const struct winbond_spi_flash_params *params;
@@ -103,5 +151,13 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 	flash->sector_size = 4096;
 	flash->size = 4096 * 16 * params->nr_blocks;
 
+	if ((spi_flash_setup_read(flash, params->read_modes) &
+	     SPI_FLASH_RD_QUAD_ANY) && winbond_enable_quad(flash)) {
+		debug("SF: Failed to enable quad mode\n");
+		flash->read = spi_flash_cmd_read_fast;
+		spi_flash_setup_read(flash,
+				     params->read_modes & ~SPI_FLASH_RD_QUAD_ANY);
+	}
+
 	return flash;
 }
@@ -60,18 +60,18 @@ static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
 
 /**
- * add_to_list - add physical eraseblock to a list.
+ * ubi_scan_add_to_list - add physical eraseblock to a list.
  * @si: scanning information
  * @pnum: physical eraseblock number to add
  * @ec: erase counter of the physical eraseblock
  * @list: the list to add to
  *
- * This function adds physical eraseblock @pnum to free, erase, corrupted or
- * alien lists. Returns zero in case of success and a negative error code in
- * case of failure.
+ * This function adds physical eraseblock @pnum to free, erase, corrupted,
+ * alien or summary lists. Returns zero in case of success and a negative error
+ * code in case of failure.
  */
-static int add_to_list(struct ubi_scan_info *si, int pnum, int ec,
-		       struct list_head *list)
+int ubi_scan_add_to_list(struct ubi_scan_info *si, int pnum, int ec,
+			 struct list_head *list)
 {
 	struct ubi_scan_leb *seb;
 
@@ -83,6 +83,8 @@ static int add_to_list(struct ubi_scan_info *si, int pnum, int ec,
 		dbg_bld("add to corrupted: PEB %d, EC %d", pnum, ec);
 	else if (list == &si->alien)
 		dbg_bld("add to alien: PEB %d, EC %d", pnum, ec);
+	else if (list == &si->summary)
+		dbg_bld("add to summary: PEB %d, EC %d", pnum, ec);
 	else
 		BUG();
 
@@ -495,11 +497,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 				return err;
 
 			if (cmp_res & 4)
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->corr);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->corr);
 			else
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->erase);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->erase);
 			if (err)
 				return err;
 
@@ -520,9 +522,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 			 * previously.
 			 */
 			if (cmp_res & 4)
-				return add_to_list(si, pnum, ec, &si->corr);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->corr);
 			else
-				return add_to_list(si, pnum, ec, &si->erase);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->erase);
 		}
 	}
 
@@ -781,7 +785,8 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	else if (err == UBI_IO_BITFLIPS)
 		bitflips = 1;
 	else if (err == UBI_IO_PEB_EMPTY)
-		return add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC, &si->erase);
+		return ubi_scan_add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC,
+					    &si->erase);
 	else if (err == UBI_IO_BAD_EC_HDR) {
 		/*
 		 * We have to also look at the VID header, possibly it is not
@@ -829,13 +834,13 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	else if (err == UBI_IO_BAD_VID_HDR ||
 		 (err == UBI_IO_PEB_FREE && ec_corr)) {
 		/* VID header is corrupted */
-		err = add_to_list(si, pnum, ec, &si->corr);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
 	} else if (err == UBI_IO_PEB_FREE) {
 		/* No VID header - the physical eraseblock is free */
-		err = add_to_list(si, pnum, ec, &si->free);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->free);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
@@ -845,12 +850,22 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	if (vol_id > UBI_MAX_VOLUMES && vol_id != UBI_LAYOUT_VOLUME_ID) {
 		int lnum = be32_to_cpu(vidh->lnum);
 
+		/* A stale scan summary, nothing to tell about */
+		if (vol_id == UBI_SUMMARY_VOLUME_ID) {
+			dbg_bld("old summary LEB %d found in PEB %d",
+				lnum, pnum);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->erase);
+			if (err)
+				return err;
+			goto adjust_mean_ec;
+		}
+
 		/* Unsupported internal volume */
 		switch (vidh->compat) {
 		case UBI_COMPAT_DELETE:
 			ubi_msg("\"delete\" compatible internal volume %d:%d"
 				" found, remove it", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->corr);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 			if (err)
 				return err;
 			break;
@@ -865,7 +880,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_PRESERVE:
 			ubi_msg("\"preserve\" compatible internal volume %d:%d"
 				" found", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->alien);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->alien);
 			if (err)
 				return err;
 			si->alien_peb_count += 1;
@@ -919,6 +934,7 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	INIT_LIST_HEAD(&si->free);
 	INIT_LIST_HEAD(&si->erase);
 	INIT_LIST_HEAD(&si->alien);
+	INIT_LIST_HEAD(&si->summary);
 	si->volumes = RB_ROOT;
 	si->is_empty = 1;
 
@@ -931,6 +947,15 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
+#ifdef CONFIG_MTD_UBI_SUMMARY
+	/* A valid scan summary saves reading every PEB of the device */
+	err = ubi_sum_scan(ubi, si);
+	if (err < 0)
+		goto out_vidh;
+	if (err == 0)
+		goto scanned;
+#endif
+
 	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -940,6 +965,9 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 			goto out_vidh;
 	}
 
+#ifdef CONFIG_MTD_UBI_SUMMARY
+scanned:
+#endif
 	dbg_msg("scanning is finished");
 
 	/* Calculate mean erase counter */
@@ -974,11 +1002,17 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 		if (seb->ec == UBI_SCAN_UNKNOWN_EC)
 			seb->ec = si->mean_ec;
 
-	err = paranoid_check_si(ubi, si);
-	if (err) {
-		if (err > 0)
-			err = -EINVAL;
-		goto out_vidh;
+	/*
+	 * The summary does not keep sequence numbers, so the paranoid check
+	 * only makes sense for information found by scanning.
+	 */
+	if (list_empty(&si->summary)) {
+		err = paranoid_check_si(ubi, si);
+		if (err) {
+			if (err > 0)
+				err = -EINVAL;
+			goto out_vidh;
+		}
 	}
 
 	ubi_free_vid_hdr(ubi, vidh);
@@ -1054,6 +1088,10 @@ void ubi_scan_destroy_si(struct ubi_scan_info *si)
 		list_del(&seb->u.list);
 		kfree(seb);
 	}
+	list_for_each_entry_safe(seb, seb_tmp, &si->summary, u.list) {
+		list_del(&seb->u.list);
+		kfree(seb);
+	}
 
 	/* Destroy the volume RB-tree */
 	rb = si->volumes.rb_node;
@@ -1324,6 +1362,9 @@ static int paranoid_check_si(struct ubi_device *ubi, struct ubi_scan_info *si)
 	list_for_each_entry(seb, &si->alien, u.list)
 		buf[seb->pnum] = 1;
 
+	list_for_each_entry(seb, &si->summary, u.list)
+		buf[seb->pnum] = 1;
+
 	err = 0;
 	for (pnum = 0; pnum < ubi->peb_count; pnum++)
 		if (!buf[pnum]) {
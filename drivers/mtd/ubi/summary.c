@@ -0,0 +1,840 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * UBI scan summary.
+ *
+ * Attaching an MTD device normally means reading the EC and VID headers of
+ * every physical eraseblock, which takes a while on big NAND chips. The scan
+ * summary is a copy of what that scan would find - the erase counter and the
+ * owner of each PEB plus a few per-volume facts - stored in an internal
+ * volume. If a valid summary is found, attaching only reads the first
+ * %UBI_SUM_MAX_START PEBs and the summary itself.
+ *
+ * The summary is only valid as long as nothing else changes on the device,
+ * so LEB 0 of the summary is erased before the first write or erase which
+ * follows an attach from it (see 'ubi_sum_invalidate()'). A new summary is
+ * written when the device is detached and after the 'ubi' commands which
+ * change volumes. Without a valid summary the device is scanned as usual.
+ * Implementations which do not know the summary volume erase it when they
+ * scan, as it is "delete" compatible.
+ *
+ * The summary is not trusted if any of the first %UBI_SUM_MAX_START PEBs
+ * disagrees with it or carries a sequence number newer than the summary.
+ * This catches software which wrote to the device without scanning it first,
+ * but only as long as it touched one of those PEBs.
+ *
+ * The PEBs holding the summary are owned by this unit and are not known to
+ * the WL unit, so they are never moved by wear-leveling. They are taken from
+ * and given back to the WL unit as the summary grows and shrinks, and are
+ * reserved at attach time so that volumes cannot claim them as well.
+ */
+
+#include <ubi_uboot.h>
+#include "ubi.h"
+
+/* @vol_id value of a probed PEB which is empty or has corrupted headers */
+#define PROBE_UNKNOWN 0xFFFFFFFFU
+
+/**
+ * struct sum_probe - what one of the first PEBs of the device contains.
+ * @vol_id: volume ID from the VID header, or %UBI_SUM_PEB_FREE,
+ *          %UBI_SUM_PEB_BAD or %PROBE_UNKNOWN
+ * @lnum: logical eraseblock number from the VID header
+ * @ec: erase counter, %-1 if the EC header is not usable
+ * @sqnum: sequence number from the VID header
+ */
+struct sum_probe {
+	uint32_t vol_id;
+	int lnum;
+	int ec;
+	unsigned long long sqnum;
+};
+
+/**
+ * probe_pebs - read the headers of the first physical eraseblocks.
+ * @ubi: UBI device description object
+ * @probe: results are stored here
+ * @count: how many physical eraseblocks to read
+ *
+ * Returns zero in case of success and a negative error code in case of
+ * failure.
+ */
+static int probe_pebs(struct ubi_device *ubi, struct sum_probe *probe,
+		      int count)
+{
+	int err = -ENOMEM, pnum;
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_hdr *vidh;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	if (!ech)
+		return err;
+
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vidh)
+		goto out_ech;
+
+	for (pnum = 0; pnum < count; pnum++) {
+		struct sum_probe *p = &probe[pnum];
+
+		p->vol_id = PROBE_UNKNOWN;
+		p->lnum = 0;
+		p->ec = -1;
+		p->sqnum = 0;
+
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			goto out_vidh;
+		if (err) {
+			p->vol_id = UBI_SUM_PEB_BAD;
+			continue;
+		}
+
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+		if (err < 0)
+			goto out_vidh;
+		if (err == UBI_IO_PEB_EMPTY)
+			continue;
+		if (err != UBI_IO_BAD_EC_HDR)
+			p->ec = be64_to_cpu(ech->ec);
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+		if (err < 0)
+			goto out_vidh;
+		if (err == UBI_IO_PEB_FREE) {
+			p->vol_id = UBI_SUM_PEB_FREE;
+			continue;
+		}
+		if (err == UBI_IO_BAD_VID_HDR)
+			continue;
+
+		p->vol_id = be32_to_cpu(vidh->vol_id);
+		p->lnum = be32_to_cpu(vidh->lnum);
+		p->sqnum = be64_to_cpu(vidh->sqnum);
+	}
+	err = 0;
+
+out_vidh:
+	ubi_free_vid_hdr(ubi, vidh);
+out_ech:
+	kfree(ech);
+	return err;
+}
+
+/**
+ * read_summary - read and check the whole summary.
+ * @ubi: UBI device description object
+ * @anchor: physical eraseblock holding LEB 0 of the summary
+ * @bufp: the summary is returned here
+ *
+ * Returns zero in case of success, %1 if the summary is not usable and a
+ * negative error code in case of failure. The caller frees the buffer with
+ * 'vfree()'.
+ */
+static int read_summary(struct ubi_device *ubi, int anchor, void **bufp)
+{
+	int err, i, len, size, leb_count;
+	struct ubi_sum_hdr *hdr;
+	struct ubi_vid_hdr *vidh;
+	void *buf;
+	uint32_t crc;
+
+	hdr = kmalloc(sizeof(struct ubi_sum_hdr), GFP_KERNEL);
+	if (!hdr)
+		return -ENOMEM;
+
+	err = ubi_io_read_data(ubi, hdr, anchor, 0,
+			       sizeof(struct ubi_sum_hdr));
+	if (err && err != UBI_IO_BITFLIPS && err != -EBADMSG)
+		goto out_hdr;
+
+	err = 1;
+	crc = crc32(UBI_CRC32_INIT, hdr, UBI_SUM_HDR_SIZE_CRC);
+	if (be32_to_cpu(hdr->magic) != UBI_SUM_HDR_MAGIC ||
+	    be32_to_cpu(hdr->hdr_crc) != crc) {
+		dbg_bld("bad summary header in PEB %d", anchor);
+		goto out_hdr;
+	}
+
+	size = sizeof(struct ubi_sum_hdr) + be32_to_cpu(hdr->data_size);
+	leb_count = be32_to_cpu(hdr->leb_count);
+	if (hdr->version != UBI_SUM_VERSION ||
+	    be32_to_cpu(hdr->peb_count) != ubi->peb_count ||
+	    be32_to_cpu(hdr->data_size) !=
+	    be32_to_cpu(hdr->vol_count) * sizeof(struct ubi_sum_vol) +
+	    ubi->peb_count * sizeof(struct ubi_sum_peb) ||
+	    be32_to_cpu(hdr->vol_count) >
+	    UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT ||
+	    leb_count != DIV_ROUND_UP(size, ubi->leb_size) ||
+	    leb_count > UBI_SUM_MAX_LEBS ||
+	    be32_to_cpu(hdr->pnum[0]) != anchor) {
+		ubi_warn("scan summary in PEB %d does not match the device",
+			 anchor);
+		goto out_hdr;
+	}
+
+	err = -ENOMEM;
+	buf = vmalloc(size);
+	if (!buf)
+		goto out_hdr;
+
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vidh)
+		goto out_buf;
+
+	for (i = 0; i < leb_count; i++) {
+		int pnum = be32_to_cpu(hdr->pnum[i]);
+
+		err = 1;
+		if (pnum < 0 || pnum >= ubi->peb_count)
+			goto out_vidh;
+
+		if (i > 0) {
+			err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+			if (err < 0)
+				goto out_vidh;
+			if ((err && err != UBI_IO_BITFLIPS) ||
+			    be32_to_cpu(vidh->vol_id) !=
+			    UBI_SUMMARY_VOLUME_ID ||
+			    be32_to_cpu(vidh->lnum) != i ||
+			    be64_to_cpu(vidh->sqnum) >
+			    be64_to_cpu(hdr->max_sqnum)) {
+				dbg_bld("summary LEB %d is not in PEB %d",
+					i, pnum);
+				err = 1;
+				goto out_vidh;
+			}
+		}
+
+		len = min_t(int, ubi->leb_size, size - i * ubi->leb_size);
+		err = ubi_io_read_data(ubi, buf + i * ubi->leb_size, pnum, 0,
+				       len);
+		if (err == -EBADMSG) {
+			err = 1;
+			goto out_vidh;
+		}
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_vidh;
+	}
+
+	crc = crc32(UBI_CRC32_INIT, buf + sizeof(struct ubi_sum_hdr),
+		    be32_to_cpu(hdr->data_size));
+	if (be32_to_cpu(hdr->data_crc) != crc) {
+		ubi_warn("bad scan summary data CRC");
+		err = 1;
+		goto out_vidh;
+	}
+
+	ubi_free_vid_hdr(ubi, vidh);
+	kfree(hdr);
+	*bufp = buf;
+	return 0;
+
+out_vidh:
+	ubi_free_vid_hdr(ubi, vidh);
+out_buf:
+	vfree(buf);
+out_hdr:
+	kfree(hdr);
+	return err;
+}
+
+static const struct ubi_sum_vol *find_vol(const struct ubi_sum_vol *vols,
+					  int vol_count, uint32_t vol_id)
+{
+	int i;
+
+	for (i = 0; i < vol_count; i++)
+		if (be32_to_cpu(vols[i].vol_id) == vol_id)
+			return &vols[i];
+	return NULL;
+}
+
+/**
+ * check_summary - check the summary against the device.
+ * @ubi: UBI device description object
+ * @buf: the summary
+ * @probe: headers of the first physical eraseblocks
+ * @count: number of entries in @probe
+ *
+ * Returns zero if the summary may be used and %1 if not.
+ */
+static int check_summary(struct ubi_device *ubi, const void *buf,
+			 const struct sum_probe *probe, int count)
+{
+	int i, pnum;
+	const struct ubi_sum_hdr *hdr = buf;
+	const struct ubi_sum_vol *vols = buf + sizeof(struct ubi_sum_hdr);
+	int vol_count = be32_to_cpu(hdr->vol_count);
+	const struct ubi_sum_peb *pebs = (const void *)(vols + vol_count);
+	unsigned long long max_sqnum = be64_to_cpu(hdr->max_sqnum);
+
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		uint32_t vol_id = be32_to_cpu(pebs[pnum].vol_id);
+		int lnum = be32_to_cpu(pebs[pnum].lnum) & ~UBI_SUM_PEB_SCRUB;
+		int ec = be32_to_cpu(pebs[pnum].ec);
+		const struct sum_probe *p = &probe[pnum];
+
+		if (vol_id != UBI_SUM_PEB_BAD && vol_id != UBI_SUM_PEB_ALIEN &&
+		    (ec < 0 || ec > UBI_MAX_ERASECOUNTER))
+			goto bad;
+
+		switch (vol_id) {
+		case UBI_SUM_PEB_BAD:
+		case UBI_SUM_PEB_ALIEN:
+		case UBI_SUM_PEB_FREE:
+			break;
+		case UBI_SUM_PEB_SELF:
+			vol_id = UBI_SUMMARY_VOLUME_ID;
+			break;
+		default:
+			if (!find_vol(vols, vol_count, vol_id))
+				goto bad;
+		}
+
+		if (pnum >= count)
+			continue;
+
+		/* One of the first PEBs, make sure it is as summarized */
+		if (p->vol_id != UBI_SUM_PEB_BAD && p->vol_id != PROBE_UNKNOWN &&
+		    p->vol_id != UBI_SUM_PEB_FREE && p->sqnum > max_sqnum) {
+			dbg_bld("PEB %d was written after the summary", pnum);
+			goto stale;
+		}
+		if (vol_id == UBI_SUM_PEB_ALIEN)
+			continue;
+		if (p->vol_id != vol_id)
+			goto stale;
+		if (vol_id == UBI_SUM_PEB_BAD)
+			continue;
+		if (p->ec != ec)
+			goto stale;
+		if (vol_id != UBI_SUM_PEB_FREE && p->lnum != lnum)
+			goto stale;
+	}
+
+	/* The summary has to own the PEBs it is stored in */
+	for (i = 0; i < be32_to_cpu(hdr->leb_count); i++) {
+		pnum = be32_to_cpu(hdr->pnum[i]);
+		if (be32_to_cpu(pebs[pnum].vol_id) != UBI_SUM_PEB_SELF ||
+		    be32_to_cpu(pebs[pnum].lnum) != i)
+			goto bad;
+	}
+
+	return 0;
+
+bad:
+	ubi_warn("bad record for PEB %d in scan summary", pnum);
+	return 1;
+
+stale:
+	ubi_warn("scan summary does not match PEB %d", pnum);
+	return 1;
+}
+
+/**
+ * add_summary - fill scanning information from the summary.
+ * @ubi: UBI device description object
+ * @si: scanning information to fill
+ * @buf: the summary
+ *
+ * Returns zero in case of success and a negative error code in case of
+ * failure.
+ */
+static int add_summary(struct ubi_device *ubi, struct ubi_scan_info *si,
+		       const void *buf)
+{
+	int err, pnum;
+	const struct ubi_sum_hdr *hdr = buf;
+	const struct ubi_sum_vol *vols = buf + sizeof(struct ubi_sum_hdr);
+	int vol_count = be32_to_cpu(hdr->vol_count);
+	const struct ubi_sum_peb *pebs = (const void *)(vols + vol_count);
+	struct ubi_vid_hdr *vidh;
+
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vidh)
+		return -ENOMEM;
+
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		uint32_t vol_id = be32_to_cpu(pebs[pnum].vol_id);
+		uint32_t lnum = be32_to_cpu(pebs[pnum].lnum);
+		int ec = be32_to_cpu(pebs[pnum].ec);
+		const struct ubi_sum_vol *sv;
+
+		switch (vol_id) {
+		case UBI_SUM_PEB_BAD:
+			si->bad_peb_count += 1;
+			continue;
+
+		case UBI_SUM_PEB_ALIEN:
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->alien);
+			si->alien_peb_count += 1;
+			break;
+
+		case UBI_SUM_PEB_FREE:
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->free);
+			break;
+
+		case UBI_SUM_PEB_SELF:
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->summary);
+			break;
+
+		default:
+			/*
+			 * Feed the scanning code the VID header it would have
+			 * read from the flash.
+			 */
+			sv = find_vol(vols, vol_count, vol_id);
+			memset(vidh, 0, sizeof(struct ubi_vid_hdr));
+			vidh->vol_type = sv->vol_type;
+			vidh->compat = sv->compat;
+			vidh->vol_id = sv->vol_id;
+			vidh->lnum = cpu_to_be32(lnum & ~UBI_SUM_PEB_SCRUB);
+			vidh->used_ebs = sv->used_ebs;
+			vidh->data_size = sv->last_data_size;
+			vidh->data_pad = sv->data_pad;
+			err = ubi_scan_add_used(ubi, si, pnum, ec, vidh,
+						!!(lnum & UBI_SUM_PEB_SCRUB));
+			break;
+		}
+		if (err)
+			goto out;
+
+		if (vol_id != UBI_SUM_PEB_ALIEN) {
+			si->ec_sum += ec;
+			si->ec_count += 1;
+			if (ec > si->max_ec)
+				si->max_ec = ec;
+			if (ec < si->min_ec)
+				si->min_ec = ec;
+		}
+	}
+
+	si->is_empty = 0;
+	si->max_sqnum = be64_to_cpu(hdr->max_sqnum);
+
+out:
+	ubi_free_vid_hdr(ubi, vidh);
+	return err;
+}
+
+/**
+ * ubi_sum_scan - get scanning information from the scan summary.
+ * @ubi: UBI device description object
+ * @si: empty scanning information to fill
+ *
+ * This function looks for a scan summary and, if a valid one is found, fills
+ * @si the way scanning the whole device would. Returns zero in case of
+ * success, %1 if there is no usable summary and the device has to be scanned,
+ * and a negative error code in case of failure.
+ */
+int ubi_sum_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
+{
+	int err, i, count, anchor = -1;
+	struct sum_probe *probe;
+	const struct ubi_sum_hdr *hdr;
+	const struct ubi_sum_peb *pebs;
+	void *buf;
+
+	count = min_t(int, ubi->peb_count, UBI_SUM_MAX_START);
+	probe = kmalloc(count * sizeof(struct sum_probe), GFP_KERNEL);
+	if (!probe)
+		return -ENOMEM;
+
+	err = probe_pebs(ubi, probe, count);
+	if (err)
+		goto out_probe;
+
+	for (i = 0; i < count; i++)
+		if (probe[i].vol_id == UBI_SUMMARY_VOLUME_ID &&
+		    probe[i].lnum == 0 &&
+		    (anchor < 0 || probe[i].sqnum > probe[anchor].sqnum))
+			anchor = i;
+
+	err = 1;
+	if (anchor < 0) {
+		dbg_bld("no scan summary found");
+		goto out_probe;
+	}
+
+	err = read_summary(ubi, anchor, &buf);
+	if (err)
+		goto out_probe;
+
+	err = check_summary(ubi, buf, probe, count);
+	if (err)
+		goto out_buf;
+
+	err = add_summary(ubi, si, buf);
+	if (err)
+		goto out_buf;
+
+	hdr = buf;
+	pebs = buf + sizeof(struct ubi_sum_hdr) +
+	       be32_to_cpu(hdr->vol_count) * sizeof(struct ubi_sum_vol);
+	ubi->sum_count = be32_to_cpu(hdr->leb_count);
+	for (i = 0; i < ubi->sum_count; i++) {
+		int pnum = be32_to_cpu(hdr->pnum[i]);
+
+		ubi->sum_pnum[i] = pnum;
+		ubi->sum_ec[i] = be32_to_cpu(pebs[pnum].ec);
+	}
+	ubi->sum_valid = 1;
+	ubi_msg("attaching from the scan summary in PEB %d", anchor);
+
+out_buf:
+	vfree(buf);
+out_probe:
+	kfree(probe);
+	return err;
+}
+
+/* Size of a summary of a device with @vol_count volumes, in bytes */
+static int sum_size(struct ubi_device *ubi, int vol_count)
+{
+	return sizeof(struct ubi_sum_hdr) +
+	       vol_count * sizeof(struct ubi_sum_vol) +
+	       ubi->peb_count * sizeof(struct ubi_sum_peb);
+}
+
+/**
+ * ubi_sum_reserve - reserve physical eraseblocks for the scan summary.
+ * @ubi: UBI device description object
+ *
+ * This function reserves as many PEBs as a summary with every volume table
+ * slot in use needs, the way the EBA unit reserves its PEBs for atomic LEB
+ * change. If there are not enough, no summary is written on this device.
+ */
+void ubi_sum_reserve(struct ubi_device *ubi)
+{
+	int need = DIV_ROUND_UP(sum_size(ubi, ubi->vtbl_slots +
+					       UBI_INT_VOL_COUNT),
+				ubi->leb_size);
+
+	ubi->sum_rsvd_pebs = 0;
+	if (need > UBI_SUM_MAX_LEBS) {
+		ubi_warn("device too big for a scan summary");
+		return;
+	}
+	if (ubi->avail_pebs < need) {
+		ubi_warn("no enough physical eraseblocks for a scan summary "
+			 "(%d, need %d)", ubi->avail_pebs, need);
+		return;
+	}
+
+	ubi->avail_pebs -= need;
+	ubi->rsvd_pebs += need;
+	ubi->sum_rsvd_pebs = need;
+}
+
+/**
+ * erase_peb - erase a physical eraseblock owned by the summary.
+ * @ubi: UBI device description object
+ * @idx: index of the physical eraseblock in @ubi->sum_pnum
+ *
+ * This function erases the physical eraseblock and writes a fresh EC header
+ * to it. Returns zero in case of success and a negative error code in case of
+ * failure.
+ */
+static int erase_peb(struct ubi_device *ubi, int idx)
+{
+	int err;
+	struct ubi_ec_hdr *ech;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_NOFS);
+	if (!ech)
+		return -ENOMEM;
+
+	err = ubi_io_sync_erase(ubi, ubi->sum_pnum[idx], 0);
+	if (err < 0)
+		goto out_free;
+
+	ubi->sum_ec[idx] += err;
+	if (ubi->sum_ec[idx] > UBI_MAX_ERASECOUNTER) {
+		ubi_err("erase counter overflow at PEB %d",
+			ubi->sum_pnum[idx]);
+		err = -EINVAL;
+		goto out_free;
+	}
+
+	ech->ec = cpu_to_be64(ubi->sum_ec[idx]);
+	err = ubi_io_write_ec_hdr(ubi, ubi->sum_pnum[idx], ech);
+
+out_free:
+	kfree(ech);
+	return err;
+}
+
+/**
+ * get_pebs - make the summary own exactly the PEBs it needs.
+ * @ubi: UBI device description object
+ * @leb_count: how many PEBs the summary needs
+ *
+ * PEBs the summary no longer needs are given back to the WL unit and missing
+ * ones are taken from it, the first one among the first %UBI_SUM_MAX_START
+ * PEBs. All of them are erased and carry an EC header afterwards. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+static int get_pebs(struct ubi_device *ubi, int leb_count)
+{
+	int err, i, pnum, ec, old_count = ubi->sum_count;
+
+	while (ubi->sum_count > leb_count) {
+		i = ubi->sum_count - 1;
+		err = erase_peb(ubi, i);
+		if (err)
+			return err;
+		err = ubi_wl_give_peb(ubi, ubi->sum_pnum[i], ubi->sum_ec[i]);
+		if (err)
+			return err;
+		ubi->sum_count -= 1;
+		old_count = ubi->sum_count;
+	}
+
+	while (ubi->sum_count < leb_count) {
+		i = ubi->sum_count;
+		pnum = ubi_wl_take_peb(ubi, i ? ubi->peb_count :
+					  UBI_SUM_MAX_START, &ec);
+		if (pnum < 0) {
+			if (i == 0)
+				ubi_warn("no free PEB among the first %d",
+					 UBI_SUM_MAX_START);
+			return pnum;
+		}
+		ubi->sum_pnum[i] = pnum;
+		ubi->sum_ec[i] = ec;
+		ubi->sum_count += 1;
+	}
+
+	/* PEBs from the WL unit are clean, the old ones hold the old summary */
+	for (i = 0; i < old_count; i++) {
+		err = erase_peb(ubi, i);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/**
+ * ubi_sum_write - write a new scan summary.
+ * @ubi: UBI device description object
+ *
+ * This function writes a summary of the current state of the device, unless
+ * the one on the flash is still valid or the device is read-only. Without
+ * reserved PEBs it gives back any the summary holds and fails. Returns zero
+ * in case of success and a negative error code in case of failure.
+ */
+int ubi_sum_write(struct ubi_device *ubi)
+{
+	int err, i, idx, pnum, lnum, len, size, leb_count, vol_count = 0;
+	unsigned long long sqnum[UBI_SUM_MAX_LEBS];
+	struct ubi_sum_hdr *hdr;
+	struct ubi_sum_vol *svol;
+	struct ubi_sum_peb *pebs;
+	struct ubi_vid_hdr *vidh;
+	struct ubi_volume *vol;
+	struct ubi_wl_entry *e;
+	struct rb_node *rb;
+	void *buf;
+
+	if (ubi->ro_mode)
+		return 0;
+
+	if (!ubi->sum_rsvd_pebs) {
+		/* An attach from the summary may have left us some */
+		if (ubi->sum_count) {
+			ubi->sum_valid = 0;
+			err = get_pebs(ubi, 0);
+			if (err)
+				return err;
+		}
+		return -ENOSPC;
+	}
+
+	if (ubi->sum_valid)
+		return 0;
+
+	/* Let pending erasures finish, the summary has to see their result */
+	err = ubi_wl_flush(ubi);
+	if (err)
+		return err;
+
+	for (idx = 0; idx < ubi->vtbl_slots + UBI_INT_VOL_COUNT; idx++)
+		if (ubi->volumes[idx])
+			vol_count += 1;
+
+	size = sum_size(ubi, vol_count);
+	leb_count = DIV_ROUND_UP(size, ubi->leb_size);
+
+	err = get_pebs(ubi, leb_count);
+	if (err)
+		return err;
+
+	buf = vmalloc(leb_count * ubi->leb_size);
+	if (!buf)
+		return -ENOMEM;
+	memset(buf, 0, leb_count * ubi->leb_size);
+
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_NOFS);
+	if (!vidh) {
+		err = -ENOMEM;
+		goto out_buf;
+	}
+
+	hdr = buf;
+	svol = buf + sizeof(struct ubi_sum_hdr);
+	pebs = (void *)(svol + vol_count);
+
+	for (idx = 0; idx < ubi->vtbl_slots + UBI_INT_VOL_COUNT; idx++) {
+		vol = ubi->volumes[idx];
+		if (!vol)
+			continue;
+
+		svol->vol_id = cpu_to_be32(vol->vol_id);
+		svol->data_pad = cpu_to_be32(vol->data_pad);
+		if (vol->vol_type == UBI_STATIC_VOLUME) {
+			svol->vol_type = UBI_VID_STATIC;
+			svol->used_ebs = cpu_to_be32(vol->used_ebs);
+			svol->last_data_size = cpu_to_be32(vol->last_eb_bytes);
+		} else
+			svol->vol_type = UBI_VID_DYNAMIC;
+		if (vol->vol_id == UBI_LAYOUT_VOLUME_ID)
+			svol->compat = UBI_LAYOUT_VOLUME_COMPAT;
+		svol += 1;
+	}
+
+	/*
+	 * Every PEB WL knows about is free unless a volume maps it. Those WL
+	 * does not know about are bad, alien or our own.
+	 */
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		e = ubi->lookuptbl[pnum];
+		if (e) {
+			pebs[pnum].ec = cpu_to_be32(e->ec);
+			pebs[pnum].vol_id = cpu_to_be32(UBI_SUM_PEB_FREE);
+			continue;
+		}
+
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			goto out_vidh;
+		pebs[pnum].vol_id = cpu_to_be32(err ? UBI_SUM_PEB_BAD :
+						      UBI_SUM_PEB_ALIEN);
+	}
+
+	for (idx = 0; idx < ubi->vtbl_slots + UBI_INT_VOL_COUNT; idx++) {
+		vol = ubi->volumes[idx];
+		if (!vol)
+			continue;
+
+		for (lnum = 0; lnum < vol->reserved_pebs; lnum++) {
+			pnum = vol->eba_tbl[lnum];
+			if (pnum < 0)
+				continue;
+			pebs[pnum].vol_id = cpu_to_be32(vol->vol_id);
+			pebs[pnum].lnum = cpu_to_be32(lnum);
+		}
+	}
+
+	ubi_rb_for_each_entry(rb, e, &ubi->scrub, rb)
+		pebs[e->pnum].lnum |= cpu_to_be32(UBI_SUM_PEB_SCRUB);
+
+	for (i = 0; i < leb_count; i++) {
+		pnum = ubi->sum_pnum[i];
+		pebs[pnum].ec = cpu_to_be32(ubi->sum_ec[i]);
+		pebs[pnum].vol_id = cpu_to_be32(UBI_SUM_PEB_SELF);
+		pebs[pnum].lnum = cpu_to_be32(i);
+		sqnum[i] = ubi_next_sqnum(ubi);
+	}
+
+	hdr->magic = cpu_to_be32(UBI_SUM_HDR_MAGIC);
+	hdr->version = UBI_SUM_VERSION;
+	hdr->peb_count = cpu_to_be32(ubi->peb_count);
+	hdr->vol_count = cpu_to_be32(vol_count);
+	hdr->leb_count = cpu_to_be32(leb_count);
+	hdr->data_size = cpu_to_be32(size - sizeof(struct ubi_sum_hdr));
+	hdr->data_crc = cpu_to_be32(crc32(UBI_CRC32_INIT,
+					  buf + sizeof(struct ubi_sum_hdr),
+					  size - sizeof(struct ubi_sum_hdr)));
+	hdr->max_sqnum = cpu_to_be64(sqnum[leb_count - 1]);
+	for (i = 0; i < leb_count; i++)
+		hdr->pnum[i] = cpu_to_be32(ubi->sum_pnum[i]);
+	hdr->hdr_crc = cpu_to_be32(crc32(UBI_CRC32_INIT, hdr,
+					 UBI_SUM_HDR_SIZE_CRC));
+
+	/* LEB 0 goes last, the summary only counts once it is there */
+	for (i = leb_count - 1; i >= 0; i--) {
+		pnum = ubi->sum_pnum[i];
+
+		vidh->vol_type = UBI_SUMMARY_VOLUME_TYPE;
+		vidh->compat = UBI_SUMMARY_VOLUME_COMPAT;
+		vidh->vol_id = cpu_to_be32(UBI_SUMMARY_VOLUME_ID);
+		vidh->lnum = cpu_to_be32(i);
+		vidh->sqnum = cpu_to_be64(sqnum[i]);
+		err = ubi_io_write_vid_hdr(ubi, pnum, vidh);
+		if (err)
+			goto out_vidh;
+
+		len = min_t(int, ubi->leb_size, size - i * ubi->leb_size);
+		err = ubi_io_write_data(ubi, buf + i * ubi->leb_size, pnum, 0,
+					ALIGN(len, ubi->min_io_size));
+		if (err)
+			goto out_vidh;
+	}
+
+	ubi->sum_valid = 1;
+	dbg_msg("scan summary written to PEB %d", ubi->sum_pnum[0]);
+
+out_vidh:
+	ubi_free_vid_hdr(ubi, vidh);
+out_buf:
+	vfree(buf);
+	return err;
+}
+
+/**
+ * ubi_sum_invalidate - invalidate the scan summary.
+ * @ubi: UBI device description object
+ *
+ * The I/O unit calls this function before anything is written to or erased
+ * on the device while the on-flash summary is valid. It erases LEB 0 of the
+ * summary, so it is not used on the next attach. Returns zero in case of
+ * success and a negative error code in case of failure.
+ */
+int ubi_sum_invalidate(struct ubi_device *ubi)
+{
+	int err;
+
+	ubi->sum_valid = 0;
+	dbg_msg("invalidate scan summary in PEB %d", ubi->sum_pnum[0]);
+
+	err = ubi_io_sync_erase(ubi, ubi->sum_pnum[0], 0);
+	if (err < 0) {
+		ubi_err("cannot invalidate scan summary, error %d", err);
+		ubi_ro_mode(ubi);
+		return err;
+	}
+
+	ubi->sum_ec[0] += err;
+	return 0;
+}
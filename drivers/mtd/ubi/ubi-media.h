@@ -306,6 +306,15 @@ struct ubi_vid_hdr {
 #define UBI_LAYOUT_VOLUME_NAME   "layout volume"
 #define UBI_LAYOUT_VOLUME_COMPAT UBI_COMPAT_REJECT
 
+/*
+ * The summary volume holds a snapshot of the scanning information. It is
+ * "delete" compatible, so implementations which do not know it simply erase
+ * it when they scan the device.
+ */
+#define UBI_SUMMARY_VOLUME_ID     (UBI_INTERNAL_VOL_START + 16)
+#define UBI_SUMMARY_VOLUME_TYPE   UBI_VID_DYNAMIC
+#define UBI_SUMMARY_VOLUME_COMPAT UBI_COMPAT_DELETE
+
 /* The maximum number of volumes per one UBI device */
 #define UBI_MAX_VOLUMES 128
 
@@ -369,4 +378,109 @@ struct ubi_vtbl_record {
 	__be32  crc;
 } __attribute__ ((packed));
 
+/* The summary header magic number ("UBSM") */
+#define UBI_SUM_HDR_MAGIC   0x5542534D
+
+/* Summary format version */
+#define UBI_SUM_VERSION     1
+
+/* LEB 0 of the summary volume lives in one of the first PEBs of the device */
+#define UBI_SUM_MAX_START   64
+
+/* The maximum number of LEBs a summary may take */
+#define UBI_SUM_MAX_LEBS    32
+
+/* Special @vol_id values of a summary PEB record */
+#define UBI_SUM_PEB_FREE    0xFFFFFFF0U
+#define UBI_SUM_PEB_BAD     0xFFFFFFF1U
+#define UBI_SUM_PEB_ALIEN   0xFFFFFFF2U
+#define UBI_SUM_PEB_SELF    0xFFFFFFF3U
+
+/* Set in the @lnum field of a summary PEB record if the PEB needs scrubbing */
+#define UBI_SUM_PEB_SCRUB   0x80000000U
+
+/* Size of the summary header without the ending CRC */
+#define UBI_SUM_HDR_SIZE_CRC (sizeof(struct ubi_sum_hdr) - sizeof(__be32))
+
+/**
+ * struct ubi_sum_hdr - scan summary header.
+ * @magic: summary header magic number (%UBI_SUM_HDR_MAGIC)
+ * @version: summary format version (%UBI_SUM_VERSION)
+ * @padding1: reserved for future, zeroes
+ * @peb_count: count of physical eraseblocks the summary describes
+ * @vol_count: count of volume records
+ * @leb_count: count of logical eraseblocks the summary takes
+ * @data_size: size of the volume and PEB records following the header
+ * @data_crc: CRC32 checksum of the volume and PEB records
+ * @max_sqnum: highest sequence number in use when the summary was written
+ * @pnum: physical eraseblocks holding the summary LEBs
+ * @padding2: reserved for future, zeroes
+ * @hdr_crc: summary header CRC checksum
+ *
+ * The summary is a snapshot of what scanning the whole device would find. It
+ * is stored in the summary volume, starting at offset 0 of LEB 0 with this
+ * header, which is followed by @vol_count &struct ubi_sum_vol records and
+ * @peb_count &struct ubi_sum_peb records. The records continue from one LEB
+ * to the next, @pnum lists the PEBs in LEB order.
+ *
+ * LEB 0 is always placed within the first %UBI_SUM_MAX_START PEBs, so it is
+ * found by looking at those only. The summary is only valid as long as
+ * nothing else is written to the device, so UBI erases LEB 0 before its first
+ * write or erase.
+ */
+struct ubi_sum_hdr {
+	__be32  magic;
+	__u8    version;
+	__u8    padding1[3];
+	__be32  peb_count;
+	__be32  vol_count;
+	__be32  leb_count;
+	__be32  data_size;
+	__be32  data_crc;
+	__be64  max_sqnum;
+	__be32  pnum[UBI_SUM_MAX_LEBS];
+	__u8    padding2[24];
+	__be32  hdr_crc;
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_sum_vol - volume record of the scan summary.
+ * @vol_id: volume ID
+ * @used_ebs: number of used logical eraseblocks (static volumes only)
+ * @data_pad: how many bytes at the end of each eraseblock are not used
+ * @last_data_size: amount of data in the last logical eraseblock (static
+ *                  volumes only)
+ * @vol_type: volume type (%UBI_VID_DYNAMIC or %UBI_VID_STATIC)
+ * @compat: compatibility of this volume
+ * @padding: reserved for future, zeroes
+ *
+ * These are the fields UBI would otherwise take from the VID headers of the
+ * volume.
+ */
+struct ubi_sum_vol {
+	__be32  vol_id;
+	__be32  used_ebs;
+	__be32  data_pad;
+	__be32  last_data_size;
+	__u8    vol_type;
+	__u8    compat;
+	__u8    padding[2];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_sum_peb - PEB record of the scan summary.
+ * @ec: erase counter
+ * @vol_id: ID of the volume the PEB belongs to, or one of the
+ *          %UBI_SUM_PEB_FREE, %UBI_SUM_PEB_BAD, %UBI_SUM_PEB_ALIEN and
+ *          %UBI_SUM_PEB_SELF values
+ * @lnum: logical eraseblock number, possibly ORed with %UBI_SUM_PEB_SCRUB
+ *
+ * Record number N describes PEB N.
+ */
+struct ubi_sum_peb {
+	__be32  ec;
+	__be32  vol_id;
+	__be32  lnum;
+} __attribute__ ((packed));
+
 #endif /* !__UBI_MEDIA_H__ */
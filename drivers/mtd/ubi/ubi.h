@@ -315,6 +315,14 @@ struct ubi_wl_entry;
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
  *
+ * @sum_pnum: physical eraseblocks owned by the scan summary, these are not
+ *            known to the WL unit
+ * @sum_ec: erase counters of the @sum_pnum physical eraseblocks
+ * @sum_count: count of PEBs in @sum_pnum
+ * @sum_valid: if the on-flash scan summary matches the device contents
+ * @sum_rsvd_pebs: how many physical eraseblocks are reserved for the scan
+ *                 summary, %0 if there were not enough to write one
+ *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
  * @peb_size: physical eraseblock size
@@ -397,6 +405,15 @@ struct ubi_device {
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
 
+#ifdef CONFIG_MTD_UBI_SUMMARY
+	/* Scan summary stuff */
+	int sum_pnum[UBI_SUM_MAX_LEBS];
+	int sum_ec[UBI_SUM_MAX_LEBS];
+	int sum_count;
+	int sum_valid;
+	int sum_rsvd_pebs;
+#endif
+
 	/* I/O unit's stuff */
 	long long flash_size;
 	int peb_count;
@@ -477,6 +494,7 @@ static inline int ubi_destroy_gluebi(struct ubi_volume *vol)
 #endif
 
 /* eba.c */
+unsigned long long ubi_next_sqnum(struct ubi_device *ubi);
 int ubi_eba_unmap_leb(struct ubi_device *ubi, struct ubi_volume *vol,
 		      int lnum);
 int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
@@ -495,6 +513,8 @@ void ubi_eba_close(const struct ubi_device *ubi);
 
 /* wl.c */
 int ubi_wl_get_peb(struct ubi_device *ubi, int dtype);
+int ubi_wl_take_peb(struct ubi_device *ubi, int max_pnum, int *ec);
+int ubi_wl_give_peb(struct ubi_device *ubi, int pnum, int ec);
 int ubi_wl_put_peb(struct ubi_device *ubi, int pnum, int torture);
 int ubi_wl_flush(struct ubi_device *ubi);
 int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum);
@@ -519,6 +539,16 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
 
+/* summary.c */
+#ifdef CONFIG_MTD_UBI_SUMMARY
+int ubi_sum_scan(struct ubi_device *ubi, struct ubi_scan_info *si);
+int ubi_sum_write(struct ubi_device *ubi);
+int ubi_sum_invalidate(struct ubi_device *ubi);
+void ubi_sum_reserve(struct ubi_device *ubi);
+#else
+static inline int ubi_sum_write(struct ubi_device *ubi) { return 0; }
+#endif
+
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset);
 int ubi_detach_mtd_dev(int ubi_num, int anyway);
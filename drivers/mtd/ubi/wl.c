@@ -539,6 +539,77 @@ retry:
 	return e->pnum;
 }
 
+/**
+ * ubi_wl_take_peb - take a free physical eraseblock away from WL.
+ * @ubi: UBI device description object
+ * @max_pnum: the returned physical eraseblock number is below this
+ * @ec: the erase counter of the physical eraseblock is returned here
+ *
+ * This function removes the free physical eraseblock with the lowest erase
+ * counter among those numbered below @max_pnum from the WL unit, which forgets
+ * about it until it is given back with 'ubi_wl_give_peb()'. The scan summary
+ * keeps its physical eraseblocks this way, out of reach of wear-leveling.
+ * Returns the physical eraseblock number in case of success and %-ENOSPC if
+ * there is no suitable free physical eraseblock.
+ */
+int ubi_wl_take_peb(struct ubi_device *ubi, int max_pnum, int *ec)
+{
+	int pnum;
+	struct ubi_wl_entry *e;
+	struct rb_node *p;
+
+	spin_lock(&ubi->wl_lock);
+	ubi_rb_for_each_entry(p, e, &ubi->free, rb) {
+		if (e->pnum < max_pnum)
+			break;
+	}
+	if (!p) {
+		spin_unlock(&ubi->wl_lock);
+		return -ENOSPC;
+	}
+
+	rb_erase(&e->rb, &ubi->free);
+	ubi->lookuptbl[e->pnum] = NULL;
+	spin_unlock(&ubi->wl_lock);
+
+	dbg_wl("take PEB %d EC %d", e->pnum, e->ec);
+	pnum = e->pnum;
+	*ec = e->ec;
+	kmem_cache_free(ubi_wl_entry_slab, e);
+	return pnum;
+}
+
+/**
+ * ubi_wl_give_peb - give a physical eraseblock to WL.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to give
+ * @ec: its erase counter
+ *
+ * This function adds physical eraseblock @pnum, which has to be erased and
+ * have a valid EC header, to the free tree. Returns zero in case of success
+ * and %-ENOMEM in case of failure.
+ */
+int ubi_wl_give_peb(struct ubi_device *ubi, int pnum, int ec)
+{
+	struct ubi_wl_entry *e;
+
+	e = kmem_cache_alloc(ubi_wl_entry_slab, GFP_NOFS);
+	if (!e)
+		return -ENOMEM;
+
+	dbg_wl("give PEB %d EC %d", pnum, ec);
+	e->pnum = pnum;
+	e->ec = ec;
+
+	spin_lock(&ubi->wl_lock);
+	if (e->ec > ubi->max_ec)
+		ubi->max_ec = e->ec;
+	wl_tree_add(e, &ubi->free);
+	ubi->lookuptbl[pnum] = e;
+	spin_unlock(&ubi->wl_lock);
+	return 0;
+}
+
 /**
  * prot_tree_del - remove a physical eraseblock from the protection trees
  * @ubi: UBI device description object
@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox SPI bus with a W25Q128 SPI NOR flash on bus 0, chip select 0,
+ * kept in a file on the host (--spi_sf). The controller moves data on up
+ * to four wires; --spi_sf_wires limits that, so the flash code can be
+ * made to fall back to the slower read commands.
+ *
+ * Every byte is checked against the phase of the command in progress:
+ * a transfer on more wires than the controller has, or on a different
+ * number of wires than the command uses for that phase, fails instead of
+ * returning data a real device would have garbled.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <os.h>
+#include <spi.h>
+#include <asm/getopt.h>
+#include <asm/state.h>
+
+#define SANDBOX_SF_SIZE		(16 << 20)
+#define SANDBOX_SF_PAGE		256
+
+/* Status register bits */
+#define SF_SR1_WIP		0x01
+#define SF_SR1_WEL		0x02
+#define SF_SR2_QE		0x02
+
+static const u8 sandbox_sf_id[] = { 0xef, 0x40, 0x18 };
+
+enum {
+	SF_IDLE,		/* waiting for a command byte */
+	SF_ADDR,		/* address, mode and dummy bytes */
+	SF_DATA,
+	SF_BAD,			/* unknown command, ignore the rest */
+};
+
+static const struct sandbox_sf_cmd {
+	u8 cmd;
+	u8 addr_len;		/* address, mode and dummy bytes */
+	u8 addr_wires;
+	u8 data_wires;
+	u8 quad;		/* needs SF_SR2_QE */
+} sandbox_sf_cmds[] = {
+	{ 0x01, 0, 1, 1, 0 },	/* write status */
+	{ 0x02, 3, 1, 1, 0 },	/* page program */
+	{ 0x03, 3, 1, 1, 0 },	/* read */
+	{ 0x04, 0, 1, 1, 0 },	/* write disable */
+	{ 0x05, 0, 1, 1, 0 },	/* read status */
+	{ 0x06, 0, 1, 1, 0 },	/* write enable */
+	{ 0x0b, 4, 1, 1, 0 },	/* fast read */
+	{ 0x20, 3, 1, 1, 0 },	/* erase 4 KiB */
+	{ 0x35, 0, 1, 1, 0 },	/* read status 2 */
+	{ 0x3b, 4, 1, 2, 0 },	/* fast read dual output */
+	{ 0x6b, 4, 1, 4, 1 },	/* fast read quad output */
+	{ 0x9f, 0, 1, 1, 0 },	/* read id */
+	{ 0xbb, 4, 2, 2, 0 },	/* fast read dual I/O */
+	{ 0xc7, 0, 1, 1, 0 },	/* chip erase */
+	{ 0xd8, 3, 1, 1, 0 },	/* erase 64 KiB */
+	{ 0xeb, 6, 4, 4, 1 },	/* fast read quad I/O */
+};
+
+struct sandbox_sf {
+	struct spi_slave slave;
+	int fd;
+	int users;		/* sf probe sets up the new slave first */
+	const struct sandbox_sf_cmd *cmd;
+	int state;
+	u8 addr_buf[6];
+	unsigned int pos;	/* bytes of the current phase done */
+	u32 addr;
+	u8 sr[2];
+	u8 wires;		/* data wires of the controller */
+};
+
+static struct sandbox_sf sandbox_sf = {
+	.fd = -1,
+	.wires = 4,
+};
+
+static int sb_cmdline_cb_spi_sf(struct sandbox_state *state, const char *arg)
+{
+	state->spi_sf = arg;
+	return 0;
+}
+SB_CMDLINE_OPT(spi_sf, 1, "Host file backing the SPI flash");
+
+static int sb_cmdline_cb_spi_sf_wires(struct sandbox_state *state,
+				      const char *arg)
+{
+	int wires = simple_strtoul(arg, NULL, 0);
+
+	if (wires != 1 && wires != 2 && wires != 4)
+		return 1;
+	sandbox_sf.wires = wires;
+	return 0;
+}
+SB_CMDLINE_OPT(spi_sf_wires, 1, "Data wires of the SPI controller: 1, 2, 4");
+
+static int sandbox_sf_seek(struct sandbox_sf *sf, u32 addr)
+{
+	return os_lseek(sf->fd, addr, OS_SEEK_SET) == addr ? 0 : -1;
+}
+
+/* Read len bytes from addr on, wrapping at the end of the device */
+static int sandbox_sf_read(struct sandbox_sf *sf, u8 *buf, unsigned int len)
+{
+	unsigned int n;
+
+	while (len) {
+		n = min(len, SANDBOX_SF_SIZE - sf->addr);
+		if (sandbox_sf_seek(sf, sf->addr))
+			return -1;
+		if (buf) {
+			/* past the end of a short file the flash is erased */
+			ssize_t got = os_read(sf->fd, buf, n);
+
+			if (got < 0)
+				return -1;
+			memset(buf + got, 0xff, n - got);
+			buf += n;
+		}
+		sf->addr = (sf->addr + n) % SANDBOX_SF_SIZE;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* Program: bits can only go from 1 to 0, wrapping inside the page */
+static int sandbox_sf_program(struct sandbox_sf *sf, const u8 *buf,
+			      unsigned int len)
+{
+	u8 page[SANDBOX_SF_PAGE];
+	u32 start;
+	unsigned int i, n;
+
+	while (len) {
+		start = sf->addr;
+		n = min(len, SANDBOX_SF_PAGE - start % SANDBOX_SF_PAGE);
+		if (sandbox_sf_read(sf, page, n))
+			return -1;
+		for (i = 0; i < n; i++)
+			page[i] &= buf ? buf[i] : 0;
+		if (sandbox_sf_seek(sf, start) ||
+		    os_write(sf->fd, page, n) != n)
+			return -1;
+		sf->addr = start - start % SANDBOX_SF_PAGE +
+			(start + n) % SANDBOX_SF_PAGE;
+		if (buf)
+			buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int sandbox_sf_erase(struct sandbox_sf *sf, u32 addr, u32 size)
+{
+	u8 ff[4096];
+
+	memset(ff, 0xff, sizeof(ff));
+	addr -= addr % size;
+	for (; size; addr += sizeof(ff), size -= sizeof(ff)) {
+		if (sandbox_sf_seek(sf, addr) ||
+		    os_write(sf->fd, ff, sizeof(ff)) != sizeof(ff))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Carry out the command when chip select goes away */
+static int sandbox_sf_end(struct sandbox_sf *sf)
+{
+	const struct sandbox_sf_cmd *cmd = sf->cmd;
+	int wel = sf->sr[0] & SF_SR1_WEL;
+	int ret = 0;
+
+	if (sf->state == SF_IDLE || sf->state == SF_BAD) {
+		sf->state = SF_IDLE;
+		return 0;
+	}
+	sf->state = SF_IDLE;
+
+	switch (cmd->cmd) {
+	case 0x04:
+		sf->sr[0] &= ~SF_SR1_WEL;
+		break;
+	case 0x06:
+		sf->sr[0] |= SF_SR1_WEL;
+		break;
+	case 0x01:
+	case 0x02:
+		sf->sr[0] &= ~SF_SR1_WEL;
+		break;
+	case 0x20:
+	case 0xd8:
+	case 0xc7:
+		if (sf->pos != cmd->addr_len && cmd->addr_len) {
+			printf("sandbox_spi: erase %02x without address\n",
+			       cmd->cmd);
+			return -1;
+		}
+		if (wel)
+			ret = sandbox_sf_erase(sf, sf->addr,
+					cmd->cmd == 0x20 ? 4096 :
+					cmd->cmd == 0xd8 ? 65536 :
+					SANDBOX_SF_SIZE);
+		sf->sr[0] &= ~SF_SR1_WEL;
+		break;
+	}
+
+	return ret;
+}
+
+/* Run len bytes, sent on the given number of wires, past the device */
+static int sandbox_sf_xfer(struct sandbox_sf *sf, const u8 *dout, u8 *din,
+			   unsigned int len, int wires)
+{
+	const struct sandbox_sf_cmd *cmd;
+	unsigned int i, n;
+
+	for (i = 0; i < len; i += n) {
+		n = 1;
+		if (din)
+			din[i] = 0xff;
+
+		switch (sf->state) {
+		case SF_IDLE:
+			sf->cmd = NULL;
+			for (cmd = sandbox_sf_cmds;
+			     cmd < sandbox_sf_cmds + ARRAY_SIZE(sandbox_sf_cmds);
+			     cmd++) {
+				if (cmd->cmd == (dout ? dout[i] : 0))
+					sf->cmd = cmd;
+			}
+			if (!sf->cmd) {
+				printf("sandbox_spi: unknown command %02x\n",
+				       dout ? dout[i] : 0);
+				sf->state = SF_BAD;
+				break;
+			}
+			if (wires != 1) {
+				printf("sandbox_spi: command %02x sent on %d "
+				       "wires\n", sf->cmd->cmd, wires);
+				return -1;
+			}
+			if (sf->cmd->quad && !(sf->sr[1] & SF_SR2_QE)) {
+				printf("sandbox_spi: command %02x needs "
+				       "quad enable\n", sf->cmd->cmd);
+				return -1;
+			}
+			sf->pos = 0;
+			sf->state = sf->cmd->addr_len ? SF_ADDR : SF_DATA;
+			break;
+
+		case SF_ADDR:
+			cmd = sf->cmd;
+			if (wires != cmd->addr_wires) {
+				printf("sandbox_spi: command %02x address on "
+				       "%d wires, expected %d\n", cmd->cmd,
+				       wires, cmd->addr_wires);
+				return -1;
+			}
+			sf->addr_buf[sf->pos++] = dout ? dout[i] : 0;
+			if (sf->pos == cmd->addr_len) {
+				sf->addr = sf->addr_buf[0] << 16 |
+					sf->addr_buf[1] << 8 | sf->addr_buf[2];
+				sf->addr %= SANDBOX_SF_SIZE;
+				sf->state = SF_DATA;
+			}
+			break;
+
+		case SF_DATA:
+			cmd = sf->cmd;
+			if (wires != cmd->data_wires) {
+				printf("sandbox_spi: command %02x data on %d "
+				       "wires, expected %d\n", cmd->cmd,
+				       wires, cmd->data_wires);
+				return -1;
+			}
+			switch (cmd->cmd) {
+			case 0x01:
+				if (sf->pos < 2 && (sf->sr[0] & SF_SR1_WEL))
+					sf->sr[sf->pos] = (dout ? dout[i] : 0) &
+						~(SF_SR1_WIP | SF_SR1_WEL);
+				sf->pos++;
+				break;
+			case 0x02:
+				if (!(sf->sr[0] & SF_SR1_WEL))
+					break;
+				n = len - i;
+				if (sandbox_sf_program(sf, dout ? dout + i :
+						       NULL, n))
+					return -1;
+				break;
+			case 0x03:
+			case 0x0b:
+			case 0x3b:
+			case 0x6b:
+			case 0xbb:
+			case 0xeb:
+				n = len - i;
+				if (sandbox_sf_read(sf, din ? din + i : NULL,
+						    n))
+					return -1;
+				break;
+			case 0x05:
+			case 0x35:
+				if (din)
+					din[i] = sf->sr[cmd->cmd == 0x35];
+				break;
+			case 0x9f:
+				if (din && sf->pos < sizeof(sandbox_sf_id))
+					din[i] = sandbox_sf_id[sf->pos];
+				sf->pos++;
+				break;
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+void spi_init(void)
+{
+}
+
+int spi_cs_is_valid(unsigned int bus, unsigned int cs)
+{
+	return bus == 0 && cs == 0;
+}
+
+struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
+		unsigned int max_hz, unsigned int mode)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sandbox_sf *sf = &sandbox_sf;
+
+	if (!spi_cs_is_valid(bus, cs))
+		return NULL;
+
+	if (!state->spi_sf) {
+		printf("sandbox_spi: no flash file, use --spi_sf <file>\n");
+		return NULL;
+	}
+
+	if (sf->fd < 0) {
+		sf->fd = os_open(state->spi_sf, OS_O_RDWR);
+		if (sf->fd < 0) {
+			printf("sandbox_spi: cannot open '%s'\n",
+			       state->spi_sf);
+			return NULL;
+		}
+	}
+
+	sf->users++;
+	sf->slave.bus = bus;
+	sf->slave.cs = cs;
+	sf->state = SF_IDLE;
+
+	return &sf->slave;
+}
+
+void spi_free_slave(struct spi_slave *slave)
+{
+	struct sandbox_sf *sf = &sandbox_sf;
+
+	if (--sf->users == 0) {
+		os_close(sf->fd);
+		sf->fd = -1;
+	}
+}
+
+int spi_claim_bus(struct spi_slave *slave)
+{
+	return 0;
+}
+
+void spi_release_bus(struct spi_slave *slave)
+{
+}
+
+unsigned int spi_xfer_caps(struct spi_slave *slave)
+{
+	switch (sandbox_sf.wires) {
+	case 4:
+		return SPI_CAP_RX_QUAD | SPI_CAP_TX_QUAD |
+			SPI_CAP_RX_DUAL | SPI_CAP_TX_DUAL;
+	case 2:
+		return SPI_CAP_RX_DUAL | SPI_CAP_TX_DUAL;
+	default:
+		return 0;
+	}
+}
+
+int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
+		void *din, unsigned long flags)
+{
+	struct sandbox_sf *sf = &sandbox_sf;
+	int wires = 1;
+	int ret = 0;
+
+	if (bitlen % 8) {
+		printf("sandbox_spi: %u bit transfer\n", bitlen);
+		return -1;
+	}
+
+	if (flags & SPI_XFER_QUAD)
+		wires = 4;
+	else if (flags & SPI_XFER_DUAL)
+		wires = 2;
+	if (wires > sf->wires) {
+		printf("sandbox_spi: %d wire transfer, controller has %d\n",
+		       wires, sf->wires);
+		return -1;
+	}
+
+	if (flags & SPI_XFER_BEGIN)
+		sf->state = SF_IDLE;
+
+	if (bitlen)
+		ret = sandbox_sf_xfer(sf, dout, din, bitlen / 8, wires);
+
+	if (flags & SPI_XFER_END) {
+		if (ret)
+			sf->state = SF_IDLE;
+		else
+			ret = sandbox_sf_end(sf);
+	}
+
+	return ret;
+}
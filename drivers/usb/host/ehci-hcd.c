@@ -910,6 +910,15 @@ int usb_lowlevel_init(int index, void **controller)
 	return 0;
 }
 
+/*
+ * ehci_submit_async() chains as many qTDs as the transfer needs, so the only
+ * limit is the free heap space for them.
+ */
+unsigned int usb_max_bulk_xfer(void)
+{
+	return 0x7fffffff;
+}
+
 int
 submit_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 		int length)
@@ -1581,6 +1581,12 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 	return 0;
 }
 
+/* sohci_submit_job() needs one TD per 4096 bytes, see N_URB_TD */
+unsigned int usb_max_bulk_xfer(void)
+{
+	return (N_URB_TD - 2) * 4096;
+}
+
 /* submit routines called from usb.c */
 int submit_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 		int transfer_len)
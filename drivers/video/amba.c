@@ -25,6 +25,7 @@
 #include <common.h>
 #include <asm/io.h>
 #include <lcd.h>
+#include <video_font.h>
 #include <amba_clcd.h>
 
 /* These variables are required by lcd.c -- although it sets them by itself */
@@ -71,9 +72,24 @@ void lcd_ctrl_init(void *lcdbase)
 	writel(cntl | CNTL_LCDEN, &regs->cntl);
 }
 
+/* Scanout starts at the upper panel base address */
+int lcd_pan(void *start)
+{
+	struct clcd_config *config = panel_info.priv;
+
+	writel((u32)start, &config->address->ubas);
+	return 0;
+}
+
 /* This is trivial, and copied from atmel_lcdfb.c */
 ulong calc_fbsize(void)
 {
-	return ((panel_info.vl_col * panel_info.vl_row *
+	int rows = panel_info.vl_row;
+
+#ifdef CONFIG_LCD_PAN_ROWS
+	/* Spare rows lcd_pan() scrolls into, as in lcd_setmem() */
+	rows += CONFIG_LCD_PAN_ROWS * VIDEO_FONT_HEIGHT;
+#endif
+	return ((panel_info.vl_col * rows *
 		NBITS(panel_info.vl_bpix)) / 8) + PAGE_SIZE;
 }
@@ -92,28 +92,23 @@ void put_ext4(uint64_t off, void *buf, uint32_t size)
 
 	if (remainder) {
 		if (fs->dev_desc->block_read) {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			blkcache_read(fs->dev_desc, startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy((temp_ptr + remainder),
 			       (unsigned char *)buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1, sec_buf);
+			blkcache_write(fs->dev_desc, startblock, 1, sec_buf);
 		}
 	} else {
 		if (size / SECTOR_SIZE != 0) {
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock,
-						  size / SECTOR_SIZE,
-						  (unsigned long *)buf);
+			blkcache_write(fs->dev_desc, startblock,
+				       size / SECTOR_SIZE,
+				       (unsigned long *)buf);
 		} else {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			blkcache_read(fs->dev_desc, startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy(temp_ptr, buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1,
-						  (unsigned long *)sec_buf);
+			blkcache_write(fs->dev_desc, startblock, 1,
+				       (unsigned long *)sec_buf);
 		}
 	}
 }
@@ -1497,6 +1492,169 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * Scratch block used to descend the extent tree. It is allocated on first
+ * use and kept until ext4fs_close(), so lookups don't malloc/free per block.
+ */
+static char *ext4fs_extent_buf;
+static int ext4fs_extent_bufsz;
+
+/* Extent runs cached for the node most recently read by ext4fs_read_file */
+static struct ext2fs_node *ext4fs_run_node;
+static int ext4fs_run_ino;
+static struct ext4_extent_run ext4fs_runs[EXT4_EXTENT_RUN_CACHE];
+static int ext4fs_run_count;
+static int ext4fs_run_next;
+
+static char *ext4fs_get_extent_buf(void)
+{
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+
+	if (ext4fs_extent_buf != NULL && ext4fs_extent_bufsz != blksz) {
+		free(ext4fs_extent_buf);
+		ext4fs_extent_buf = NULL;
+	}
+	if (ext4fs_extent_buf == NULL) {
+		ext4fs_extent_buf = zalloc(blksz);
+		if (ext4fs_extent_buf == NULL)
+			return NULL;
+		ext4fs_extent_bufsz = blksz;
+	}
+
+	return ext4fs_extent_buf;
+}
+
+/*
+ * Find the extent covering fileblock and return it as a whole run. A block
+ * that falls between two extents is returned as a hole (pblock 0) that
+ * reaches up to the next extent of the leaf.
+ */
+static int ext4fs_lookup_extent_run(struct ext2_inode *inode,
+				    uint32_t fileblock,
+				    struct ext4_extent_run *run)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	uint32_t ee_block, ee_len;
+	int entries;
+	char *buf;
+	int i = -1;
+
+	buf = ext4fs_get_extent_buf();
+	if (!buf)
+		return -ENOMEM;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root, buf,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock,
+					    LOG2_EXT2_BLOCK_SIZE(ext4fs_root));
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+	entries = le16_to_cpu(ext_block->eh_entries);
+
+	do {
+		i++;
+		if (i >= entries)
+			break;
+	} while (fileblock >= le32_to_cpu(extent[i].ee_block));
+	if (--i < 0) {
+		printf("Extent Error\n");
+		return -EINVAL;
+	}
+
+	ee_block = le32_to_cpu(extent[i].ee_block);
+	ee_len = le16_to_cpu(extent[i].ee_len);
+	if (fileblock - ee_block >= ee_len) {
+		run->lblock = fileblock;
+		run->pblock = 0;
+		if (i + 1 < entries)
+			run->len = le32_to_cpu(extent[i + 1].ee_block) -
+				   fileblock;
+		else
+			run->len = 1;
+		return 0;
+	}
+
+	run->lblock = ee_block;
+	run->pblock = le16_to_cpu(extent[i].ee_start_hi);
+	run->pblock = (run->pblock << 32) + le32_to_cpu(extent[i].ee_start_lo);
+	run->len = ee_len;
+
+	return 0;
+}
+
+/*
+ * Return the run of contiguous blocks of node starting at or containing
+ * fileblock. Extent-mapped runs are served from a small per-node cache;
+ * for indirect-mapped inodes, up to maxblocks contiguous blocks are merged.
+ */
+int ext4fs_get_extent_run(struct ext2fs_node *node, uint32_t fileblock,
+			  uint32_t maxblocks, struct ext4_extent_run *run)
+{
+	struct ext2_inode *inode = &node->inode;
+	long int blknr;
+	int i, ret;
+
+	if (!(le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)) {
+		blknr = read_allocated_block(inode, fileblock);
+		if (blknr < 0)
+			return blknr;
+
+		run->lblock = fileblock;
+		run->pblock = blknr;
+		run->len = 1;
+		while (run->len < maxblocks) {
+			blknr = read_allocated_block(inode,
+						     fileblock + run->len);
+			if (blknr < 0)
+				return blknr;
+			if (blknr != (run->pblock ? run->pblock + run->len : 0))
+				break;
+			run->len++;
+		}
+		return 0;
+	}
+
+	if (ext4fs_run_node != node || ext4fs_run_ino != node->ino) {
+		ext4fs_run_node = node;
+		ext4fs_run_ino = node->ino;
+		ext4fs_run_count = 0;
+		ext4fs_run_next = 0;
+	}
+
+	for (i = 0; i < ext4fs_run_count; i++) {
+		if (fileblock - ext4fs_runs[i].lblock < ext4fs_runs[i].len) {
+			*run = ext4fs_runs[i];
+			return 0;
+		}
+	}
+
+	ret = ext4fs_lookup_extent_run(inode, fileblock, run);
+	if (ret)
+		return ret;
+
+	ext4fs_runs[ext4fs_run_next] = *run;
+	ext4fs_run_next = (ext4fs_run_next + 1) % EXT4_EXTENT_RUN_CACHE;
+	if (ext4fs_run_count < EXT4_EXTENT_RUN_CACHE)
+		ext4fs_run_count++;
+
+	return 0;
+}
+
+void ext4fs_drop_extent_runs(struct ext2fs_node *node)
+{
+	if (node == NULL || node == ext4fs_run_node) {
+		ext4fs_run_node = NULL;
+		ext4fs_run_count = 0;
+		ext4fs_run_next = 0;
+	}
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 {
 	long int blknr;
@@ -1506,52 +1664,19 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_EXT2_BLOCK_SIZE(ext4fs_root);
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i = -1;
-		ext_block = ext4fs_get_extent_block(ext4fs_root, buf,
-						    (struct ext4_extent_header
-						     *)inode->b.
-						    blocks.dir_blocks,
-						    fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			free(buf);
-			return -EINVAL;
-		}
+		struct ext4_extent_run run;
 
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		do {
-			i++;
-			if (i >= le32_to_cpu(ext_block->eh_entries))
-				break;
-		} while (fileblock >= le32_to_cpu(extent[i].ee_block));
-		if (--i >= 0) {
-			fileblock -= le32_to_cpu(extent[i].ee_block);
-			if (fileblock >= le32_to_cpu(extent[i].ee_len)) {
-				free(buf);
-				return 0;
-			}
-
-			start = le32_to_cpu(extent[i].ee_start_hi);
-			start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-			free(buf);
-			return fileblock + start;
-		}
+		status = ext4fs_lookup_extent_run(inode, fileblock, &run);
+		if (status)
+			return status;
+		if (!run.pblock)
+			return 0;
 
-		printf("Extent Error\n");
-		free(buf);
-		return -1;
+		return run.pblock + (fileblock - run.lblock);
 	}
 
 	/* Direct blocks. */
@@ -1848,6 +1973,12 @@ void ext4fs_close(void)
 		free(ext4fs_root);
 		ext4fs_root = NULL;
 	}
+	ext4fs_drop_extent_runs(NULL);
+	if (ext4fs_extent_buf != NULL) {
+		free(ext4fs_extent_buf);
+		ext4fs_extent_buf = NULL;
+		ext4fs_extent_bufsz = 0;
+	}
 	if (ext4fs_indir1_block != NULL) {
 		free(ext4fs_indir1_block);
 		ext4fs_indir1_block = NULL;
@@ -55,6 +55,16 @@
 #define SUPERBLOCK_SIZE	1024
 #define F_FILE			1
 
+/* Number of extent runs remembered for the file being read */
+#define EXT4_EXTENT_RUN_CACHE	16
+
+/* A run of blocks that is contiguous both in the file and on disk */
+struct ext4_extent_run {
+	uint32_t lblock;	/* first logical block of the run */
+	uint64_t pblock;	/* first physical block, 0 for a hole */
+	uint32_t len;		/* number of blocks in the run */
+};
+
 static inline void *zalloc(size_t size)
 {
 	void *p = memalign(ARCH_DMA_MINALIGN, size);
@@ -70,6 +80,9 @@ int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 			struct ext2fs_node **foundnode, int expecttype);
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
+int ext4fs_get_extent_run(struct ext2fs_node *node, uint32_t fileblock,
+			  uint32_t maxblocks, struct ext4_extent_run *run);
+void ext4fs_drop_extent_runs(struct ext2fs_node *node);
 
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
@@ -52,116 +52,71 @@ struct ext_filesystem *get_fs(void)
 
 void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 {
-	if ((node != &ext4fs_root->diropen) && (node != currroot))
+	if ((node != &ext4fs_root->diropen) && (node != currroot)) {
+		ext4fs_drop_extent_runs(node);
 		free(node);
+	}
 }
 
 /*
- * Taken from openmoko-kernel mailing list: By Andy green
- * Optimized read file API : collects and defers contiguous sector
- * reads into one potentially more efficient larger sequential read action
+ * Read len bytes at pos. Each extent run is fetched with one
+ * ext4fs_devread(), holes are zero filled.
  */
 int ext4fs_read_file(struct ext2fs_node *node, int pos,
 		unsigned int len, char *buf)
 {
-	int i;
-	int blockcnt;
+	struct ext4_extent_run run;
+	uint32_t i, n;
+	uint32_t blockcnt;
 	int log2blocksize = LOG2_EXT2_BLOCK_SIZE(node->data);
 	int blocksize = 1 << (log2blocksize + DISK_SECTOR_BITS);
 	unsigned int filesize = __le32_to_cpu(node->inode.size);
-	int previous_block_number = -1;
-	int delayed_start = 0;
-	int delayed_extent = 0;
-	int delayed_skipfirst = 0;
-	int delayed_next = 0;
-	char *delayed_buf = NULL;
-	short status;
+	int status;
 
 	/* Adjust len so it we can't read past the end of the file. */
-	if (len > filesize)
-		len = filesize;
+	if (pos >= filesize)
+		return 0;
+	if (len > filesize - pos)
+		len = filesize - pos;
 
 	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
 
-	for (i = pos / blocksize; i < blockcnt; i++) {
-		int blknr;
-		int blockoff = pos % blocksize;
-		int blockend = blocksize;
+	for (i = pos / blocksize; i < blockcnt; i += n) {
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
-		if (blknr < 0)
+		int blockend;
+		int nbytes;
+
+		status = ext4fs_get_extent_run(node, i, blockcnt - i, &run);
+		if (status < 0)
 			return -1;
 
-		blknr = blknr << log2blocksize;
+		n = run.len - (i - run.lblock);
+		if (n > blockcnt - i)
+			n = blockcnt - i;
 
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) % blocksize;
+		/* First block. */
+		if (i == pos / blocksize)
+			skipfirst = pos % blocksize;
 
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		nbytes = n * blocksize - skipfirst;
 
-		/* First block. */
-		if (i == pos / blocksize) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
+		/* Last block. */
+		if (i + n == blockcnt) {
+			blockend = (len + pos) % blocksize;
+			if (blockend)
+				nbytes -= blocksize - blockend;
 		}
-		if (blknr) {
-			int status;
 
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> SECTOR_BITS;
-				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-					if (status == 0)
-						return -1;
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> SECTOR_BITS);
-				}
-			} else {
-				previous_block_number = blknr;
-				delayed_start = blknr;
-				delayed_extent = blockend;
-				delayed_skipfirst = skipfirst;
-				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> SECTOR_BITS);
-			}
+		if (run.pblock) {
+			status = ext4fs_devread((run.pblock + (i - run.lblock))
+						<< log2blocksize, skipfirst,
+						nbytes, buf);
+			if (status == 0)
+				return -1;
 		} else {
-			if (previous_block_number != -1) {
-				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-				if (status == 0)
-					return -1;
-				previous_block_number = -1;
-			}
-			memset(buf, 0, blocksize - skipfirst);
+			memset(buf, 0, nbytes);
 		}
-		buf += blocksize - skipfirst;
-	}
-	if (previous_block_number != -1) {
-		/* spill */
-		status = ext4fs_devread(delayed_start,
-					delayed_skipfirst, delayed_extent,
-					delayed_buf);
-		if (status == 0)
-			return -1;
-		previous_block_number = -1;
+		buf += nbytes;
 	}
 
 	return len;
@@ -196,6 +151,14 @@ int ext4fs_read(char *buf, unsigned len)
 	return ext4fs_read_file(ext4fs_file, 0, len, buf);
 }
 
+int ext4fs_read_at(char *buf, unsigned pos, unsigned len)
+{
+	if (ext4fs_root == NULL || ext4fs_file == NULL)
+		return 0;
+
+	return ext4fs_read_file(ext4fs_file, pos, len, buf);
+}
+
 #if defined(CONFIG_EXT4_WRITE)
 static void ext4fs_update(void)
 {
@@ -935,8 +898,10 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 	char *delayed_buf = NULL;
 
 	/* Adjust len so it we can't read past the end of the file. */
-	if (len > filesize)
-		len = filesize;
+	if (pos >= filesize)
+		return 0;
+	if (len > filesize - pos)
+		len = filesize - pos;
 
 	blockcnt = ((len + pos) + fs->blksz - 1) / fs->blksz;
 
@@ -57,8 +57,8 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	if (!cur_dev || !cur_dev->block_read)
 		return -1;
 
-	return cur_dev->block_read(cur_dev->dev,
-			cur_part_info.start + block, nr_blocks, buf);
+	return blkcache_read(cur_dev, cur_part_info.start + block,
+			nr_blocks, buf);
 }
 
 int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
@@ -260,6 +260,32 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	return ret;
 }
 
+/*
+ * Count how many clusters from 'clust' on are stored one after the other,
+ * looking at no more than 'max' of them, and store the cluster following
+ * the run in '*next' if the run ends before that.
+ * Return the length of the run.
+ */
+static __u32 get_run(fsdata *mydata, __u32 clust, __u32 max, __u32 *next)
+{
+	__u32 len = 1, newclust;
+
+	while (len < max) {
+		newclust = get_fatent(mydata, clust + len - 1);
+		if (newclust != clust + len ||
+		    CHECK_CLUST(newclust, mydata->fatsize)) {
+			*next = newclust;
+			break;
+		}
+		len++;
+	}
+
+	return len;
+}
+
+__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
 /*
  * Read at most 'size' bytes from the specified cluster into 'buffer'.
  * Return 0 on success, -1 otherwise.
@@ -281,20 +307,25 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		__u8 *tmpbuf = get_contents_vfatname_block;
 
 		printf("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* Bounce as many sectors at a time as the block holds */
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min(size, (unsigned long)MAX_CLUSTSIZE) /
+				mydata->sect_size;
+			ret = disk_read(startsect, idx, tmpbuf);
+			if (ret != idx) {
 				debug("Error reading data (got %d)\n", ret);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			memcpy(buffer, tmpbuf, idx);
+			buffer += idx;
+			size -= idx;
 		}
 	} else {
 		idx = size / mydata->sect_size;
@@ -323,23 +354,29 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/* A cluster of a file and the file offset its data starts at */
+struct fat_cursor {
+	__u32 clust;
+	unsigned long pos;
+};
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
+ * With 'cur' given, the cluster chain is followed from there rather than from
+ * the start of the file if it is not past 'pos', and 'cur' is left at the last
+ * cluster read, so that reading a file in order walks its chain only once.
  * Return the number of bytes read or -1 on fatal errors.
  */
-__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
-	__aligned(ARCH_DMA_MINALIGN);
-
 static long
 get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
-	     __u8 *buffer, unsigned long maxsize)
+	     __u8 *buffer, unsigned long maxsize, struct fat_cursor *cur)
 {
 	unsigned long filesize = FAT2CPU32(dentptr->size), gotsize = 0;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
-	unsigned long actsize;
+	__u32 nclust, newclust;
+	unsigned long actsize, clustpos = 0;
 
 	debug("Filesize: %ld bytes\n", filesize);
 
@@ -353,7 +390,11 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 
 	debug("%ld bytes\n", filesize);
 
-	actsize = bytesperclust;
+	if (cur && cur->pos <= pos) {
+		curclust = cur->clust;
+		clustpos = cur->pos;
+	}
+	actsize = clustpos + bytesperclust;
 
 	/* go to cluster at pos */
 	while (actsize <= pos) {
@@ -368,6 +409,7 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 
 	/* actsize > pos */
 	actsize -= bytesperclust;
+	clustpos = actsize;
 	filesize -= actsize;
 	pos -= actsize;
 
@@ -384,10 +426,11 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 		memcpy(buffer, get_contents_vfatname_block + pos, actsize);
 		gotsize += actsize;
 		if (!filesize)
-			return gotsize;
+			goto done;
 		buffer += actsize;
 
 		curclust = get_fatent(mydata, curclust);
+		clustpos += bytesperclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			debug("Invalid FAT entry\n");
@@ -395,50 +438,69 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return gotsize;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
+	/* read each run of consecutive clusters with a single disk read */
+	while (1) {
+		nclust = DIV_ROUND_UP(filesize, bytesperclust);
+		nclust = get_run(mydata, curclust, nclust, &newclust);
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		actsize = min(filesize, (unsigned long)nclust * bytesperclust);
+		if (get_cluster(mydata, curclust, buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		gotsize += actsize;
-		return gotsize;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		gotsize += (int)actsize;
 		filesize -= actsize;
+		if (!filesize) {
+			/* the run is contiguous, step to its last cluster */
+			nclust = (actsize - 1) / bytesperclust;
+			curclust += nclust;
+			clustpos += nclust * bytesperclust;
+			goto done;
+		}
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
+		curclust = newclust;
+		clustpos += actsize;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return gotsize;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+done:
+	if (cur) {
+		cur->clust = curclust;
+		cur->pos = clustpos;
+	}
+
+	return gotsize;
+}
+
+/*
+ * Find where the file associated with 'dentptr' is stored, for reading it
+ * straight from the device. Only files held in a single run of clusters can
+ * be read that way.
+ * Return the file size, with its first block on the device in '*blk', or -1
+ * if the file is fragmented.
+ */
+static long
+get_extent(fsdata *mydata, dir_entry *dentptr, lbaint_t *blk)
+{
+	unsigned long filesize = FAT2CPU32(dentptr->size);
+	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
+	__u32 clust = START(dentptr), next;
+	__u32 nclust = DIV_ROUND_UP(filesize, bytesperclust);
+
+	if (filesize && get_run(mydata, clust, nclust, &next) != nclust) {
+		debug("%lu byte file is fragmented\n", filesize);
+		return -1;
+	}
+
+	*blk = cur_part_info.start + mydata->data_begin +
+		clust * mydata->clust_size;
+
+	return filesize;
 }
 
 #ifdef CONFIG_SUPPORT_VFAT
@@ -569,9 +631,9 @@ static __u8 mkcksum(const char name[8], const char ext[3])
 
 	__u8 ret = 0;
 
-	for (i = 0; i < sizeof(name); i++)
+	for (i = 0; i < 8; i++)
 		ret = (((ret & 1) << 7) | ((ret & 0xfe) >> 1)) + name[i];
-	for (i = 0; i < sizeof(ext); i++)
+	for (i = 0; i < 3; i++)
 		ret = (((ret & 1) << 7) | ((ret & 0xfe) >> 1)) + ext[i];
 
 	return ret;
@@ -818,16 +880,28 @@ exit:
 __u8 do_fat_read_at_block[MAX_CLUSTSIZE]
 	__aligned(ARCH_DMA_MINALIGN);
 
-long
-do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
-	       unsigned long maxsize, int dols)
+/* File kept open by file_fat_open(), its FAT buffer is allocated while open */
+static struct {
+	fsdata data;
+	dir_entry dent;
+	struct fat_cursor cur;
+} fat_open_file;
+
+/*
+ * Look up 'filename' and read it, list it (dols), with 'blk' given, find
+ * where it lies on the device (see get_extent()) or, with 'keep' set, keep
+ * it open in fat_open_file and return its size.
+ */
+static long
+do_fat_lookup(const char *filename, unsigned long pos, void *buffer,
+	      unsigned long maxsize, int dols, lbaint_t *blk, int keep)
 {
 	char fnamecopy[2048];
 	boot_sector bs;
 	volume_info volinfo;
 	fsdata datablock;
 	fsdata *mydata = &datablock;
-	dir_entry *dentptr = NULL;
+	dir_entry dent, *dentptr = NULL;
 	__u16 prevcksum = 0xffff;
 	char *subname = "";
 	__u32 cursect;
@@ -1126,11 +1200,13 @@ rootdir_done:
 	while (isdir) {
 		int startsect = mydata->data_begin
 			+ START(dentptr) * mydata->clust_size;
-		dir_entry dent;
 		char *nextname = NULL;
 
-		dent = *dentptr;
-		dentptr = &dent;
+		/* keep the entry, the directory block it is in gets reused */
+		if (dentptr != &dent) {
+			dent = *dentptr;
+			dentptr = &dent;
+		}
 
 		idx = dirdelim(subname);
 
@@ -1164,7 +1240,20 @@ rootdir_done:
 			subname = nextname;
 	}
 
-	ret = get_contents(mydata, dentptr, pos, buffer, maxsize);
+	if (blk) {
+		ret = get_extent(mydata, dentptr, blk);
+		goto exit;
+	}
+
+	if (keep) {
+		fat_open_file.data = *mydata;
+		fat_open_file.dent = *dentptr;
+		fat_open_file.cur.clust = START(dentptr);
+		fat_open_file.cur.pos = 0;
+		return FAT2CPU32(dentptr->size);
+	}
+
+	ret = get_contents(mydata, dentptr, pos, buffer, maxsize, NULL);
 	debug("Size: %d, got: %ld\n", FAT2CPU32(dentptr->size), ret);
 
 exit:
@@ -1172,6 +1261,13 @@ exit:
 	return ret;
 }
 
+long
+do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
+	       unsigned long maxsize, int dols)
+{
+	return do_fat_lookup(filename, pos, buffer, maxsize, dols, NULL, 0);
+}
+
 long
 do_fat_read(const char *filename, void *buffer, unsigned long maxsize, int dols)
 {
@@ -1256,3 +1352,46 @@ long file_fat_read(const char *filename, void *buffer, unsigned long maxsize)
 {
 	return file_fat_read_at(filename, 0, buffer, maxsize);
 }
+
+/*
+ * Return the size of 'filename' and store its first block on the device in
+ * '*blk' if the file is contiguous, so it can be read with one block read;
+ * return -1 if it cannot be found or is fragmented.
+ */
+long file_fat_map(const char *filename, lbaint_t *blk)
+{
+	return do_fat_lookup(filename, 0, NULL, 0, LS_NO, blk, 0);
+}
+
+/*
+ * Open 'filename' for reading it in pieces with file_fat_read_open(), which
+ * does not look it up again. Return its size, or -1 if it cannot be found.
+ */
+long file_fat_open(const char *filename)
+{
+	file_fat_close();
+
+	return do_fat_lookup(filename, 0, NULL, 0, LS_NO, NULL, 1);
+}
+
+/*
+ * Read at most 'maxsize' bytes from 'pos' in the file opened by
+ * file_fat_open(). Reading in order follows the cluster chain only once.
+ * Return the number of bytes read or -1 on errors.
+ */
+long file_fat_read_open(unsigned long pos, void *buffer, unsigned long maxsize)
+{
+	fsdata *mydata = &fat_open_file.data;
+
+	if (!mydata->fatbuf)
+		return -1;
+
+	return get_contents(mydata, &fat_open_file.dent, pos, buffer, maxsize,
+			    &fat_open_file.cur);
+}
+
+void file_fat_close(void)
+{
+	free(fat_open_file.data.fatbuf);
+	fat_open_file.data.fatbuf = NULL;
+}
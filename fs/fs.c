@@ -20,6 +20,7 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <image.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -40,6 +41,18 @@ static inline int fs_read_unsupported(const char *filename, ulong addr,
 	return -1;
 }
 
+static inline int fs_open_unsupported(const char *filename)
+{
+	printf("** Unrecognized filesystem type **\n");
+	return -1;
+}
+
+static inline int fs_read_at_unsupported(const char *filename, void *buf,
+					 int pos, int len)
+{
+	return -1;
+}
+
 #ifdef CONFIG_FS_FAT
 static int fs_probe_fat(void)
 {
@@ -48,6 +61,7 @@ static int fs_probe_fat(void)
 
 static void fs_close_fat(void)
 {
+	file_fat_close();
 }
 
 #define fs_ls_fat file_fat_ls
@@ -65,6 +79,23 @@ static int fs_read_fat(const char *filename, ulong addr, int offset, int len)
 
 	return len_read;
 }
+
+#ifdef CONFIG_CMD_LOADZ
+static int fs_open_fat(const char *filename)
+{
+	if (file_fat_open(filename) < 0) {
+		printf("** File not found %s **\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int fs_read_at_fat(const char *filename, void *buf, int pos, int len)
+{
+	return file_fat_read_open(pos, buf, len);
+}
+#endif
 #else
 static inline int fs_probe_fat(void)
 {
@@ -77,6 +108,8 @@ static inline void fs_close_fat(void)
 
 #define fs_ls_fat fs_ls_unsupported
 #define fs_read_fat fs_read_unsupported
+#define fs_open_fat fs_open_unsupported
+#define fs_read_at_fat fs_read_at_unsupported
 #endif
 
 #ifdef CONFIG_FS_EXT4
@@ -129,6 +162,23 @@ static int fs_read_ext(const char *filename, ulong addr, int offset, int len)
 
 	return len_read;
 }
+
+#ifdef CONFIG_CMD_LOADZ
+static int fs_open_ext(const char *filename)
+{
+	if (ext4fs_open(filename) < 0) {
+		printf("** File not found %s **\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int fs_read_at_ext(const char *filename, void *buf, int pos, int len)
+{
+	return ext4fs_read_at(buf, pos, len);
+}
+#endif
 #else
 static inline int fs_probe_ext(void)
 {
@@ -141,6 +191,8 @@ static inline void fs_close_ext(void)
 
 #define fs_ls_ext fs_ls_unsupported
 #define fs_read_ext fs_read_unsupported
+#define fs_open_ext fs_open_unsupported
+#define fs_read_at_ext fs_read_at_unsupported
 #endif
 
 static struct {
@@ -247,6 +299,103 @@ int fs_read(const char *filename, ulong addr, int offset, int len)
 	return ret;
 }
 
+#ifdef CONFIG_CMD_LOADZ
+/* File being streamed by fs_read_decomp() */
+struct fs_stream {
+	const char *filename;
+	int pos;
+};
+
+static int fs_stream_read(void *priv, void *buf, int len)
+{
+	struct fs_stream *s = priv;
+	int ret;
+
+	switch (fs_type) {
+	case FS_TYPE_FAT:
+		ret = fs_read_at_fat(s->filename, buf, s->pos, len);
+		break;
+	case FS_TYPE_EXT:
+		ret = fs_read_at_ext(s->filename, buf, s->pos, len);
+		break;
+	default:
+		ret = fs_read_at_unsupported(s->filename, buf, s->pos, len);
+		break;
+	}
+	if (ret < 0) {
+		printf("** Unable to read file %s **\n", s->filename);
+		return -1;
+	}
+	s->pos += ret;
+
+	return ret;
+}
+
+int fs_read_decomp(const char *filename, ulong addr, int comp, ulong *lenp)
+{
+	struct fs_stream s;
+	int ret;
+
+	switch (fs_type) {
+	case FS_TYPE_FAT:
+		ret = fs_open_fat(filename);
+		break;
+	case FS_TYPE_EXT:
+		ret = fs_open_ext(filename);
+		break;
+	default:
+		ret = fs_open_unsupported(filename);
+		break;
+	}
+
+	if (!ret) {
+		s.filename = filename;
+		s.pos = 0;
+		ret = bootm_load_stream(addr, fs_stream_read, &s, comp, lenp);
+	}
+
+	fs_close();
+
+	return ret;
+}
+
+int do_loadz(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+		int fstype)
+{
+	unsigned long addr;
+	const char *filename;
+	ulong len;
+	int comp = -1;
+	char buf[12];
+
+	if (argc < 5 || argc > 6)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[3], NULL, 16);
+	filename = argv[4];
+	if (argc == 6) {
+		comp = genimg_get_comp_id(argv[5]);
+		if (comp < 0) {
+			printf("** Unknown compression type %s **\n", argv[5]);
+			return CMD_RET_USAGE;
+		}
+	}
+
+	if (fs_set_blk_dev(argv[1], argv[2], fstype))
+		return 1;
+
+	if (fs_read_decomp(filename, addr, comp, &len))
+		return 1;
+
+	printf("%lu bytes uncompressed\n", len);
+
+	sprintf(buf, "0x%lx", len);
+	setenv("filesize", buf);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_LOADZ */
+
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype, int cmdline_base)
 {
@@ -92,13 +92,12 @@
  * - implemented fragment sorting to ensure that the newest data is copied
  *   if there are multiple copies of fragments for a certain file offset.
  *
- * The fragment sorting feature must be enabled by CONFIG_SYS_JFFS2_SORT_FRAGMENTS.
- * Sorting is done while adding fragments to the lists, which is more or less a
- * bubble sort. This takes a lot of time, and is most probably not an issue if
- * the boot filesystem is always mounted readonly.
- *
- * You should define it if the boot filesystem is mounted writable, and updates
- * to the boot files are done by copying files to that filesystem.
+ * Fragments and directory entries are now kept in red-black trees ordered by
+ * inode (parent inode for directory entries) and version, so they are always
+ * sorted and CONFIG_SYS_JFFS2_SORT_FRAGMENTS is no longer needed. A lookup
+ * only reads the nodes of the inode or directory it is after, and the scan
+ * result is kept across commands for as long as the last node and the free
+ * space following it in every erase block are unchanged.
  *
  *
  * There's a big issue left: endianess is completely ignored in this code. Duh!
@@ -541,117 +540,110 @@ add_node(struct b_list *list)
 }
 
 static struct b_node *
-insert_node(struct b_list *list, u32 offset)
+insert_node(struct b_list *list, u32 offset, u32 ino, u32 version)
 {
-	struct b_node *new;
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-	struct b_node *b, *prev;
-#endif
+	struct rb_node **p = &list->root.rb_node;
+	struct rb_node *parent = NULL;
+	struct b_node *new, *b;
 
 	if (!(new = add_node(list))) {
 		putstr("add_node failed!\r\n");
 		return NULL;
 	}
 	new->offset = offset;
+	new->ino = ino;
+	new->version = version;
+	new->datacrc = CRC_UNKNOWN;
 
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-	if (list->listTail != NULL && list->listCompare(new, list->listTail))
-		prev = list->listTail;
-	else if (list->listLast != NULL && list->listCompare(new, list->listLast))
-		prev = list->listLast;
-	else
-		prev = NULL;
-
-	for (b = (prev ? prev->next : list->listHead);
-	     b != NULL && list->listCompare(new, b);
-	     prev = b, b = b->next) {
-		list->listLoops++;
-	}
-	if (b != NULL)
-		list->listLast = prev;
-
-	if (b != NULL) {
-		new->next = b;
-		if (prev != NULL)
-			prev->next = new;
+	/* Keep each inode's nodes together, with the latest version last,
+	 * so that if there is overlapping data the latest version is used.
+	 */
+	while (*p) {
+		parent = *p;
+		b = rb_entry(parent, struct b_node, rb);
+		if (ino < b->ino || (ino == b->ino && (version < b->version ||
+		    (version == b->version && offset < b->offset))))
+			p = &parent->rb_left;
 		else
-			list->listHead = new;
-	} else
-#endif
-	{
-		new->next = (struct b_node *) NULL;
-		if (list->listTail != NULL) {
-			list->listTail->next = new;
-			list->listTail = new;
-		} else {
-			list->listTail = list->listHead = new;
-		}
+			p = &parent->rb_right;
 	}
+	rb_link_node(&new->rb, parent, p);
+	rb_insert_color(&new->rb, &list->root);
 
 	return new;
 }
 
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-/* Sort data entries with the latest version last, so that if there
- * is overlapping data the latest version will be used.
- */
-static int compare_inodes(struct b_node *new, struct b_node *old)
+static inline struct b_node *
+next_node(struct b_node *b)
 {
-	struct jffs2_raw_inode ojNew;
-	struct jffs2_raw_inode ojOld;
-	struct jffs2_raw_inode *jNew =
-		(struct jffs2_raw_inode *)get_fl_mem(new->offset, sizeof(ojNew), &ojNew);
-	struct jffs2_raw_inode *jOld =
-		(struct jffs2_raw_inode *)get_fl_mem(old->offset, sizeof(ojOld), &ojOld);
-
-	return jNew->version > jOld->version;
+	struct rb_node *n = rb_next(&b->rb);
+
+	return n ? rb_entry(n, struct b_node, rb) : NULL;
 }
 
-/* Sort directory entries so all entries in the same directory
- * with the same name are grouped together, with the latest version
- * last. This makes it easy to eliminate all but the latest version
- * by marking the previous version dead by setting the inode to 0.
- */
-static int compare_dirents(struct b_node *new, struct b_node *old)
+static inline struct b_node *
+first_node(struct b_list *list)
 {
-	struct jffs2_raw_dirent ojNew;
-	struct jffs2_raw_dirent ojOld;
-	struct jffs2_raw_dirent *jNew =
-		(struct jffs2_raw_dirent *)get_fl_mem(new->offset, sizeof(ojNew), &ojNew);
-	struct jffs2_raw_dirent *jOld =
-		(struct jffs2_raw_dirent *)get_fl_mem(old->offset, sizeof(ojOld), &ojOld);
-	int cmp;
-
-	/* ascending sort by pino */
-	if (jNew->pino != jOld->pino)
-		return jNew->pino > jOld->pino;
-
-	/* pino is the same, so use ascending sort by nsize, so
-	 * we don't do strncmp unless we really must.
-	 */
-	if (jNew->nsize != jOld->nsize)
-		return jNew->nsize > jOld->nsize;
+	struct rb_node *n = rb_first(&list->root);
 
-	/* length is also the same, so use ascending sort by name
-	 */
-	cmp = strncmp((char *)jNew->name, (char *)jOld->name, jNew->nsize);
-	if (cmp != 0)
-		return cmp > 0;
+	return n ? rb_entry(n, struct b_node, rb) : NULL;
+}
 
-	/* we have duplicate names in this directory, so use ascending
-	 * sort by version
-	 */
-	if (jNew->version > jOld->version) {
-		/* since jNew is newer, we know jOld is not valid, so
-		 * mark it with inode 0 and it will not be used
-		 */
-		jOld->ino = 0;
-		return 1;
+/* Find the oldest node of an inode (or the oldest entry of a directory) */
+static struct b_node *
+find_first_node(struct b_list *list, u32 ino)
+{
+	struct rb_node *n = list->root.rb_node;
+	struct b_node *b, *found = NULL;
+
+	while (n) {
+		b = rb_entry(n, struct b_node, rb);
+		if (b->ino >= ino) {
+			found = b;
+			n = n->rb_left;
+		} else {
+			n = n->rb_right;
+		}
 	}
 
-	return 0;
+	return (found && found->ino == ino) ? found : NULL;
+}
+
+/* Find the latest node of an inode */
+static struct b_node *
+find_last_node(struct b_list *list, u32 ino)
+{
+	struct rb_node *n = list->root.rb_node;
+	struct b_node *b, *found = NULL;
+
+	while (n) {
+		b = rb_entry(n, struct b_node, rb);
+		if (b->ino <= ino) {
+			found = b;
+			n = n->rb_right;
+		} else {
+			n = n->rb_left;
+		}
+	}
+
+	return (found && found->ino == ino) ? found : NULL;
+}
+
+/* Index a node found at a partition offset, noting it in its erase block */
+static struct b_node *
+index_node(struct part_info *part, struct b_list *list, u32 ofs, u32 ino,
+	   u32 version)
+{
+	struct b_lists *pL = (struct b_lists *)part->jffs2_priv;
+	struct b_stamp *st = &pL->stamps[ofs / part->sector_size];
+	struct b_node *b;
+
+	b = insert_node(list, (u32)part->offset + ofs, ino, version);
+	if (b && (!st->last || b->offset > st->last->offset))
+		st->last = b;
+
+	return b;
 }
-#endif
 
 void
 jffs2_free_cache(struct part_info *part)
@@ -662,8 +654,10 @@ jffs2_free_cache(struct part_info *part)
 		pL = (struct b_lists *)part->jffs2_priv;
 		free_nodes(&pL->frag);
 		free_nodes(&pL->dir);
+		free(pL->stamps);
 		free(pL->readbuf);
 		free(pL);
+		part->jffs2_priv = NULL;
 	}
 }
 
@@ -678,10 +672,6 @@ jffs_init_1pass_list(struct part_info *part)
 		pL = (struct b_lists *)part->jffs2_priv;
 
 		memset(pL, 0, sizeof(*pL));
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-		pL->dir.listCompare = compare_dirents;
-		pL->frag.listCompare = compare_inodes;
-#endif
 	}
 	return 0;
 }
@@ -693,12 +683,11 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 	struct b_node *b;
 	struct jffs2_raw_inode *jNode;
 	u32 totalSize = 0;
-	u32 latestVersion = 0;
 	uchar *lDest;
 	uchar *src;
 	int i;
 	u32 counter = 0;
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
+
 	/* Find file size before loading any data, so fragments that
 	 * start past the end of file can be ignored. A fragment
 	 * that is partially in the file is loaded, so extra data may
@@ -706,21 +695,17 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 	 * This shouldn't cause trouble when loading kernel images, so
 	 * we will live with it.
 	 */
-	for (b = pL->frag.listHead; b != NULL; b = b->next) {
+	b = find_last_node(&pL->frag, inode);
+	if (b) {
 		jNode = (struct jffs2_raw_inode *) get_fl_mem(b->offset,
 			sizeof(struct jffs2_raw_inode), pL->readbuf);
-		if ((inode == jNode->ino)) {
-			/* get actual file length from the newest node */
-			if (jNode->version >= latestVersion) {
-				totalSize = jNode->isize;
-				latestVersion = jNode->version;
-			}
-		}
+		/* get actual file length from the newest node */
+		totalSize = jNode->isize;
 		put_fl_mem(jNode, pL->readbuf);
 	}
-#endif
 
-	for (b = pL->frag.listHead; b != NULL; b = b->next) {
+	for (b = find_first_node(&pL->frag, inode); b && b->ino == inode;
+	     b = next_node(b)) {
 		jNode = (struct jffs2_raw_inode *) get_node_mem(b->offset,
 								pL->readbuf);
 		if ((inode == jNode->ino)) {
@@ -737,14 +722,6 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 			putLabeledWord("read_inode: flags = ", jNode->flags);
 #endif
 
-#ifndef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-			/* get actual file length from the newest node */
-			if (jNode->version >= latestVersion) {
-				totalSize = jNode->isize;
-				latestVersion = jNode->version;
-			}
-#endif
-
 			if(dest) {
 				src = ((uchar *) jNode) + sizeof(struct jffs2_raw_inode);
 				/* ignore data behind latest known EOF */
@@ -826,8 +803,11 @@ jffs2_1pass_find_inode(struct b_lists * pL, const char *name, u32 pino)
 	len = strlen(name);
 
 	counter = 0;
-	/* we need to search all and return the inode with the highest version */
-	for(b = pL->dir.listHead; b; b = b->next, counter++) {
+	/* we need to search the directory and return the inode with the
+	 * highest version
+	 */
+	for (b = find_first_node(&pL->dir, pino); b && b->ino == pino;
+	     b = next_node(b), counter++) {
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if ((pino == jDir->pino) && (len == jDir->nsize) &&
@@ -949,32 +929,20 @@ jffs2_1pass_list_inodes(struct b_lists * pL, u32 pino)
 	struct b_node *b;
 	struct jffs2_raw_dirent *jDir;
 
-	for (b = pL->dir.listHead; b; b = b->next) {
+	for (b = find_first_node(&pL->dir, pino); b && b->ino == pino;
+	     b = next_node(b)) {
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if ((pino == jDir->pino) && (jDir->ino)) { /* ino=0 -> unlink */
-			u32 i_version = 0;
-			struct jffs2_raw_inode ojNode;
-			struct jffs2_raw_inode *jNode, *i = NULL;
-			struct b_node *b2 = pL->frag.listHead;
-
-			while (b2) {
-				jNode = (struct jffs2_raw_inode *)
-					get_fl_mem(b2->offset, sizeof(ojNode), &ojNode);
-				if (jNode->ino == jDir->ino && jNode->version >= i_version) {
-					i_version = jNode->version;
-					if (i)
-						put_fl_mem(i, NULL);
-
-					if (jDir->type == DT_LNK)
-						i = get_node_mem(b2->offset,
-								 NULL);
-					else
-						i = get_fl_mem(b2->offset,
-							       sizeof(*i),
-							       NULL);
-				}
-				b2 = b2->next;
+			struct jffs2_raw_inode *i = NULL;
+			struct b_node *b2 = find_last_node(&pL->frag, jDir->ino);
+
+			if (b2) {
+				if (jDir->type == DT_LNK)
+					i = get_node_mem(b2->offset, NULL);
+				else
+					i = get_fl_mem(b2->offset, sizeof(*i),
+						       NULL);
 			}
 
 			dump_inode(pL, jDir, i);
@@ -1057,7 +1025,7 @@ jffs2_1pass_resolve_inode(struct b_lists * pL, u32 ino)
 	unsigned char *src;
 
 	/* we need to search all and return the inode with the highest version */
-	for(b = pL->dir.listHead; b; b = b->next) {
+	for (b = first_node(&pL->dir); b; b = next_node(b)) {
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if (ino == jDir->ino) {
@@ -1086,25 +1054,20 @@ jffs2_1pass_resolve_inode(struct b_lists * pL, u32 ino)
 		return jDirFoundIno;
 
 	/* it's a soft link so we follow it again. */
-	b2 = pL->frag.listHead;
-	while (b2) {
+	b2 = find_last_node(&pL->frag, jDirFoundIno);
+	if (b2) {
 		jNode = (struct jffs2_raw_inode *) get_node_mem(b2->offset,
 								pL->readbuf);
-		if (jNode->ino == jDirFoundIno) {
-			src = (unsigned char *)jNode + sizeof(struct jffs2_raw_inode);
+		src = (unsigned char *)jNode + sizeof(struct jffs2_raw_inode);
 
 #if 0
-			putLabeledWord("\t\t dsize = ", jNode->dsize);
-			putstr("\t\t target = ");
-			putnstr(src, jNode->dsize);
-			putstr("\r\n");
+		putLabeledWord("\t\t dsize = ", jNode->dsize);
+		putstr("\t\t target = ");
+		putnstr(src, jNode->dsize);
+		putstr("\r\n");
 #endif
-			strncpy(tmp, (char *)src, jNode->dsize);
-			tmp[jNode->dsize] = '\0';
-			put_fl_mem(jNode, pL->readbuf);
-			break;
-		}
-		b2 = b2->next;
+		strncpy(tmp, (char *)src, jNode->dsize);
+		tmp[jNode->dsize] = '\0';
 		put_fl_mem(jNode, pL->readbuf);
 	}
 	/* ok so the name of the new file to find is in tmp */
@@ -1168,9 +1131,12 @@ jffs2_1pass_search_list_inodes(struct b_lists * pL, const char *fname, u32 pino)
 unsigned char
 jffs2_1pass_rescan_needed(struct part_info *part)
 {
-	struct b_node *b;
-	struct jffs2_unknown_node onode;
-	struct jffs2_unknown_node *node;
+	struct b_stamp *st;
+	struct jffs2_raw_dirent onode;
+	struct jffs2_raw_dirent *node;
+	u32 oword;
+	u32 *word;
+	u32 i;
 	struct b_lists *pL = (struct b_lists *)part->jffs2_priv;
 
 	if (part->jffs2_priv == 0){
@@ -1184,17 +1150,35 @@ jffs2_1pass_rescan_needed(struct part_info *part)
 		return 1;
 	}
 
-	/* but suppose someone reflashed a partition at the same offset... */
-	b = pL->dir.listHead;
-	while (b) {
-		node = (struct jffs2_unknown_node *) get_fl_mem(b->offset,
-			sizeof(onode), &onode);
-		if (node->nodetype != JFFS2_NODETYPE_DIRENT) {
-			DEBUGF ("rescan: fs changed beneath me? (%lx)\n",
-					(unsigned long) b->offset);
-			return 1;
+	/* but suppose someone reflashed a partition at the same offset,
+	 * or wrote to it since it was scanned. Either changes the last
+	 * node in an erase block or the space following it.
+	 */
+	for (i = 0; i < pL->nr_stamps; i++) {
+		st = &pL->stamps[i];
+		if (st->last) {
+			/* ino of an inode node sits where a dirent has pino */
+			node = (struct jffs2_raw_dirent *) get_fl_mem(
+				st->last->offset, sizeof(onode), &onode);
+			if (node->magic != JFFS2_MAGIC_BITMASK ||
+			    node->pino != st->last->ino ||
+			    node->version != st->last->version) {
+				DEBUGF ("rescan: fs changed beneath me? (%lx)\n",
+					(unsigned long) st->last->offset);
+				return 1;
+			}
+		}
+		if (st->end < part->sector_size) {
+			word = (u32 *) get_fl_mem((u32)part->offset +
+				i * part->sector_size + st->end,
+				sizeof(oword), &oword);
+			if (*word != st->end_word) {
+				DEBUGF ("rescan: fs written beneath me? (%lx)\n",
+					(unsigned long) (i * part->sector_size +
+							 st->end));
+				return 1;
+			}
 		}
-		b = b->next;
 	}
 	return 0;
 }
@@ -1247,11 +1231,14 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 					if (pass) {
 						spi = sp;
 
-						ret = insert_node(&pL->frag,
-							(u32)part->offset +
-							offset +
+						ret = index_node(part,
+							&pL->frag, offset +
+							sum_get_unaligned32(
+								&spi->offset),
 							sum_get_unaligned32(
-								&spi->offset));
+								&spi->inode),
+							sum_get_unaligned32(
+								&spi->version));
 						if (ret == NULL)
 							return -1;
 					}
@@ -1264,11 +1251,14 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 					struct jffs2_sum_dirent_flash *spd;
 					spd = sp;
 					if (pass) {
-						ret = insert_node(&pL->dir,
-							(u32) part->offset +
-							offset +
+						ret = index_node(part,
+							&pL->dir, offset +
+							sum_get_unaligned32(
+								&spd->offset),
 							sum_get_unaligned32(
-								&spd->offset));
+								&spd->pino),
+							sum_get_unaligned32(
+								&spd->version));
 						if (ret == NULL)
 							return -1;
 					}
@@ -1369,7 +1359,7 @@ dump_fragments(struct b_lists *pL)
 	struct jffs2_raw_inode *jNode;
 
 	putstr("\r\n\r\n******The fragment Entries******\r\n");
-	b = pL->frag.listHead;
+	b = first_node(&pL->frag);
 	while (b) {
 		jNode = (struct jffs2_raw_inode *) get_fl_mem(b->offset,
 			sizeof(ojNode), &ojNode);
@@ -1386,7 +1376,7 @@ dump_fragments(struct b_lists *pL)
 		putLabeledWord("\tbuild_list: usercompr = ", jNode->usercompr);
 		putLabeledWord("\tbuild_list: flags = ", jNode->flags);
 		putLabeledWord("\tbuild_list: offset = ", b->offset);	/* FIXME: ? [RS] */
-		b = b->next;
+		b = next_node(b);
 	}
 }
 #endif
@@ -1399,7 +1389,7 @@ dump_dirents(struct b_lists *pL)
 	struct jffs2_raw_dirent *jDir;
 
 	putstr("\r\n\r\n******The directory Entries******\r\n");
-	b = pL->dir.listHead;
+	b = first_node(&pL->dir);
 	while (b) {
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
@@ -1417,7 +1407,7 @@ dump_dirents(struct b_lists *pL)
 		putLabeledWord("\tbuild_list: node_crc = ", jDir->node_crc);
 		putLabeledWord("\tbuild_list: name_crc = ", jDir->name_crc);
 		putLabeledWord("\tbuild_list: offset = ", b->offset);	/* FIXME: ? [RS] */
-		b = b->next;
+		b = next_node(b);
 		put_fl_mem(jDir, pL->readbuf);
 	}
 }
@@ -1455,6 +1445,15 @@ jffs2_1pass_build_lists(struct part_info * part)
 	/* if we are building a list we need to refresh the cache. */
 	jffs_init_1pass_list(part);
 	pL = (struct b_lists *)part->jffs2_priv;
+	if (pL == NULL)
+		return 0;
+	pL->stamps = malloc(nr_sectors * sizeof(struct b_stamp));
+	if (pL->stamps == NULL) {
+		jffs2_free_cache(part);
+		return 0;
+	}
+	memset(pL->stamps, 0, nr_sectors * sizeof(struct b_stamp));
+	pL->nr_stamps = nr_sectors;
 	buf = malloc(buf_size);
 	puts ("Scanning JFFS2 FS:   ");
 
@@ -1464,6 +1463,8 @@ jffs2_1pass_build_lists(struct part_info * part)
 		uint32_t buf_ofs = sector_ofs;
 		uint32_t buf_len;
 		uint32_t ofs, prevofs;
+		uint32_t end;
+		struct b_stamp *st = &pL->stamps[i];
 #ifdef CONFIG_JFFS2_SUMMARY
 		struct jffs2_sum_marker *sm;
 		void *sumptr = NULL;
@@ -1522,8 +1523,11 @@ jffs2_1pass_build_lists(struct part_info * part)
 				jffs2_free_cache(part);
 				return 0;
 			}
-			if (ret)
+			if (ret) {
+				/* nothing gets added after the summary */
+				st->end = part->sector_size;
 				continue;
+			}
 
 		}
 #endif /* CONFIG_JFFS2_SUMMARY */
@@ -1540,11 +1544,15 @@ jffs2_1pass_build_lists(struct part_info * part)
 				*(uint32_t *)(&buf[ofs]) == 0xFFFFFFFF)
 			ofs += 4;
 
-		if (ofs == EMPTY_SCAN_SIZE(part->sector_size))
+		if (ofs == EMPTY_SCAN_SIZE(part->sector_size)) {
+			st->end = 0;
+			st->end_word = 0xFFFFFFFF;
 			continue;
+		}
 
 		ofs += sector_ofs;
 		prevofs = ofs - 1;
+		end = ofs;
 
 	scan_more:
 		while (ofs < sector_ofs + part->sector_size) {
@@ -1633,8 +1641,11 @@ jffs2_1pass_build_lists(struct part_info * part)
 				if (!inode_crc((struct jffs2_raw_inode *) node))
 				       break;
 
-				if (insert_node(&pL->frag, (u32) part->offset +
-						ofs) == NULL) {
+				if (index_node(part, &pL->frag, ofs,
+					       ((struct jffs2_raw_inode *)
+						node)->ino,
+					       ((struct jffs2_raw_inode *)
+						node)->version) == NULL) {
 					free(buf);
 					jffs2_free_cache(part);
 					return 0;
@@ -1663,8 +1674,11 @@ jffs2_1pass_build_lists(struct part_info * part)
 					break;
 				if (! (counterN%100))
 					puts ("\b\b.  ");
-				if (insert_node(&pL->dir, (u32) part->offset +
-						ofs) == NULL) {
+				if (index_node(part, &pL->dir, ofs,
+					       ((struct jffs2_raw_dirent *)
+						node)->pino,
+					       ((struct jffs2_raw_dirent *)
+						node)->version) == NULL) {
 					free(buf);
 					jffs2_free_cache(part);
 					return 0;
@@ -1695,8 +1709,18 @@ jffs2_1pass_build_lists(struct part_info * part)
 					node->totlen, ofs);
 			}
 			ofs += ((node->totlen + 3) & ~3);
+			end = ofs;
 			counterF++;
 		}
+
+		/* remember what follows the last node, to notice appends */
+		st->end = end - sector_ofs;
+		if (st->end < part->sector_size) {
+			uint32_t oword;
+
+			st->end_word = *(uint32_t *)get_fl_mem((u32)part->offset
+						+ end, sizeof(oword), &oword);
+		}
 	}
 
 	free(buf);
@@ -1747,7 +1771,7 @@ jffs2_1pass_fill_info(struct b_lists * pL, struct b_jffs2_info * piL)
 		piL->compr_info[i].decompr_sum = 0;
 	}
 
-	b = pL->frag.listHead;
+	b = first_node(&pL->frag);
 	while (b) {
 		jNode = (struct jffs2_raw_inode *) get_fl_mem(b->offset,
 			sizeof(ojNode), &ojNode);
@@ -1756,7 +1780,7 @@ jffs2_1pass_fill_info(struct b_lists * pL, struct b_jffs2_info * piL)
 			piL->compr_info[jNode->compr].compr_sum += jNode->csize;
 			piL->compr_info[jNode->compr].decompr_sum += jNode->dsize;
 		}
-		b = b->next;
+		b = next_node(b);
 	}
 	return 0;
 }
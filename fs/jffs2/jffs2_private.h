@@ -2,29 +2,39 @@
 #define jffs2_private_h
 
 #include <jffs2/jffs2.h>
+#include <linux/rbtree.h>
 
 
 struct b_node {
+	struct rb_node rb;
 	u32 offset;
-	struct b_node *next;
+	u32 ino;		/* inode, or parent inode for a dirent */
+	u32 version;
 	enum { CRC_UNKNOWN = 0, CRC_OK, CRC_BAD } datacrc;
 };
 
+/* Nodes sorted by (ino, version, offset) */
 struct b_list {
-	struct b_node *listTail;
-	struct b_node *listHead;
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-	struct b_node *listLast;
-	int (*listCompare)(struct b_node *new, struct b_node *node);
-	u32 listLoops;
-#endif
+	struct rb_root root;
 	u32 listCount;
 	struct mem_block *listMemBase;
 };
 
+/*
+ * What an erase block looked like when it was scanned, so a later command
+ * can tell whether the cached lists still describe the flash.
+ */
+struct b_stamp {
+	struct b_node *last;	/* last inode or dirent indexed in the block */
+	u32 end;		/* offset just past the last node seen */
+	u32 end_word;		/* flash contents at that offset */
+};
+
 struct b_lists {
 	struct b_list dir;
 	struct b_list frag;
+	struct b_stamp *stamps;	/* one per erase block */
+	u32 nr_stamps;
 	void *readbuf;
 };
 
@@ -37,8 +37,13 @@ DECLARE_GLOBAL_DATA_PTR;
 static int gzip_decompress(const unsigned char *in, size_t in_len,
 			   unsigned char *out, size_t *out_len)
 {
-	return zunzip(out, *out_len, (unsigned char *)in,
-		      (unsigned long *)out_len, 0, 0);
+	unsigned long len = *out_len;
+	int err;
+
+	err = zunzip(out, len, (unsigned char *)in, &len, 0, 0);
+	*out_len = len;
+
+	return err;
 }
 
 /* Fake description object for the "none" compressor */
@@ -82,6 +87,7 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 		     int *out_len, int compr_type)
 {
 	int err;
+	size_t len;
 	struct ubifs_compressor *compr;
 
 	if (unlikely(compr_type < 0 || compr_type >= UBIFS_COMPR_TYPES_CNT)) {
@@ -102,7 +108,10 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 		return 0;
 	}
 
-	err = compr->decompress(in_buf, in_len, out_buf, (size_t *)out_len);
+	/* @out_len is an int, the decompressors store a size_t */
+	len = *out_len;
+	err = compr->decompress(in_buf, in_len, out_buf, &len);
+	*out_len = len;
 	if (err)
 		ubifs_err("cannot decompress %d bytes, compressor %s, "
 			  "error %d", in_len, compr->name, err);
@@ -519,23 +528,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+static int decompress_block(struct ubifs_info *c, struct inode *inode,
+			    void *addr, unsigned int block,
+			    struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -566,6 +565,74 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decompress_block(c, inode, addr, block, dn);
+}
+
+/*
+ * Fill up to @count whole blocks starting at @block from the data nodes which
+ * follow each other in the same LEB, reading them all with one ubi_read().
+ * Returns the number of blocks filled, or 0 if @block should be read on its
+ * own (single node, error, or nothing to gather).
+ */
+static int do_bulk_read(struct ubifs_info *c, struct inode *inode,
+			struct bu_info *bu, void *addr, unsigned int block,
+			unsigned int count)
+{
+	unsigned int next, last;
+	void *buf;
+	int err, n;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return 0;
+
+	/* Do not read nodes beyond the blocks asked for */
+	while (bu->cnt &&
+	       key_block(c, &bu->zbranch[bu->cnt - 1].key) >= block + count)
+		bu->cnt -= 1;
+	if (bu->cnt < 2)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return 0;
+
+	buf = bu->buf;
+	last = key_block(c, &bu->zbranch[bu->cnt - 1].key);
+	for (next = block, n = 0; next <= last; next++) {
+		if (key_block(c, &bu->zbranch[n].key) != next) {
+			/* Not in the run, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		} else {
+			err = decompress_block(c, inode, addr, next, buf);
+			if (err)
+				return 0;
+			buf += ALIGN(bu->zbranch[n].len, 8);
+			n++;
+		}
+		addr += UBIFS_BLOCK_SIZE;
+	}
+
+	return last - block + 1;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -677,14 +744,14 @@ error:
 	return err;
 }
 
-int ubifs_load(char *filename, u32 addr, u32 size)
+int ubifs_load(char *filename, ulong addr, u32 size)
 {
 	struct ubifs_info *c = ubifs_sb->s_fs_info;
 	unsigned long inum;
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 	char buf [10];
@@ -716,27 +783,49 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 		size = inode->i_size;
 
 	count = (size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
-	printf("Loading file '%s' to addr 0x%08x with size %d (0x%08x)...\n",
+	printf("Loading file '%s' to addr 0x%08lx with size %d (0x%08x)...\n",
 	       filename, addr, size, size);
 
+	/*
+	 * Without memory for the bulk-read buffer every block is simply
+	 * read on its own
+	 */
+	c->bu.buf = malloc(c->max_bu_buf_len);
+	c->bu.buf_len = c->max_bu_buf_len;
+
 	page.addr = (void *)addr;
 	page.index = 0;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count; i += n) {
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
 		if (((i + 1) == count) && (size < inode->i_size))
 			last_block_size = size - (i * PAGE_SIZE);
 
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
+		/*
+		 * All but the last block are whole, and can be read in runs
+		 * of data nodes. The last one may be partial and must not
+		 * be padded in the destination.
+		 */
+		n = 0;
+		if (c->bu.buf && i + 1 < count)
+			n = do_bulk_read(c, inode, &c->bu, page.addr, i,
+					 count - 1 - i);
+		if (!n) {
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
+	free(c->bu.buf);
+	c->bu.buf = NULL;
+
 	if (err)
 		printf("Error reading file '%s'\n", filename);
 	else {
@@ -113,6 +113,14 @@ typedef volatile unsigned char	vu_char;
 #include <asm/arch/hardware.h>
 #endif
 
+/*
+ * Source of a compressed stream for the *_stream() decompressors: fill
+ * "buf" with up to "len" bytes and return the number of bytes read. Fewer
+ * than "len" bytes are returned only at the end of the stream, a negative
+ * value on error.
+ */
+typedef int (*stream_read_fn)(void *priv, void *buf, int len);
+
 #include <part.h>
 #include <flash.h>
 #include <image.h>
@@ -708,6 +716,10 @@ void mii_init (void);
 
 /* $(CPU)/.../lcd.c */
 ulong	lcd_setmem (ulong);
+#ifdef CONFIG_LCD_SHADOW
+void	lcd_sync (void);
+void	lcd_poll (void);
+#endif
 
 /* $(CPU)/.../video.c */
 ulong	video_setmem (ulong);
@@ -733,6 +745,8 @@ int	init_timebase (void);
 
 /* lib/gunzip.c */
 int gunzip(void *, int, unsigned char *, unsigned long *);
+int gunzip_stream(void *dst, int dstlen, stream_read_fn read, void *priv,
+		  unsigned long *lenp);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
 
@@ -30,18 +30,55 @@
 
 #define CONFIG_OF_CONTROL
 #define CONFIG_OF_LIBFDT
+#define CONFIG_FIT
+#define CONFIG_FIT_PARALLEL_VERIFY
+#define CONFIG_SANDBOX_JOB_CORES	4
 #define CONFIG_LMB
 
 #define CONFIG_SYS_VSNPRINTF
 
 #define CONFIG_CMD_GPIO
+#define CONFIG_CMD_HOST
+#define CONFIG_CMD_TIME
+#define CONFIG_CMD_MEMBENCH
+#define CONFIG_CMD_CRC32_BENCH
+#define CONFIG_CRC32_SLICE8
 #define CONFIG_SANDBOX_GPIO
 #define CONFIG_SANDBOX_GPIO_COUNT	20
 
+#define CONFIG_SANDBOX_SPI
+#define CONFIG_SPI_FLASH
+#define CONFIG_SPI_FLASH_WINBOND
+#define CONFIG_CMD_SF
+
+/* NAND chip in a host file, with UBI and UBIFS on top */
+#define CONFIG_CMD_NAND
+#define CONFIG_NAND_SANDBOX
+#define CONFIG_CMD_NANDSIM
+#define CONFIG_CMD_ECCBENCH
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+#define CONFIG_SYS_NAND_BASE		0
+#define CONFIG_SYS_NAND_ONFI_DETECTION
+#define CONFIG_NAND_BBT_STASH
+#define CONFIG_SYS_NAND_BBT_STASH_OFFS	0
+#define CONFIG_SYS_NAND_BBT_STASH_SIZE	(512 << 10)
+#define CONFIG_NAND_ECC_BCH
+#define CONFIG_BCH
+#define CONFIG_MTD_DEVICE
+#define CONFIG_MTD_PARTITIONS
+#define CONFIG_CMD_MTDPARTS
+#define MTDIDS_DEFAULT			"nand0=nand0"
+#define MTDPARTS_DEFAULT		"mtdparts=nand0:512k(bbt)ro,-(ubi)"
+#define CONFIG_CMD_UBI
+#define CONFIG_MTD_UBI_SUMMARY
+#define CONFIG_CMD_UBIFS
+#define CONFIG_RBTREE
+#define CONFIG_LZO
+
 /*
- * Size of malloc() pool, although we don't actually use this yet.
+ * Size of malloc() pool, large enough for UBI and UBIFS on the NAND chip
  */
-#define CONFIG_SYS_MALLOC_LEN		(4 << 20)	/* 4MB  */
+#define CONFIG_SYS_MALLOC_LEN		(32 << 20)	/* 32MB  */
 
 #define CONFIG_SYS_PROMPT		"=>"	/* Command Prompt */
 #define CONFIG_SYS_HUSH_PARSER
@@ -85,6 +122,17 @@
 #undef CONFIG_CMD_NET
 #undef CONFIG_CMD_NFS
 
+/* Filesystems and partitions, on host devices */
+#define CONFIG_DOS_PARTITION
+#define CONFIG_EFI_PARTITION
+#define CONFIG_CMD_FAT
+#define CONFIG_CMD_EXT4
+#define CONFIG_CMD_FS_GENERIC
+#define CONFIG_BLOCK_CACHE
+#define CONFIG_CMD_BLKCACHE
+#define CONFIG_CMD_LOADZ
+#define CONFIG_LZMA
+
 #define CONFIG_BOOTARGS ""
 
 #define CONFIG_EXTRA_ENV_SETTINGS	"stdin=serial\0" \
@@ -53,6 +53,17 @@ int fs_ls(const char *dirname);
  */
 int fs_read(const char *filename, ulong addr, int offset, int len);
 
+/*
+ * Read file "filename" from the partition previously set by fs_set_blk_dev()
+ * and uncompress it to address "addr" while it is being read. "comp" is the
+ * IH_COMP_* type of a raw compressed file, or -1 if the file is a legacy
+ * uImage, whose header then gives the compression type. The number of bytes
+ * stored at "addr" is returned in "lenp".
+ *
+ * Returns 0 on success. Returns non-zero on error.
+ */
+int fs_read_decomp(const char *filename, ulong addr, int comp, ulong *lenp);
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
@@ -61,5 +72,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype, int cmdline_base);
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
+int do_loadz(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+		int fstype);
 
 #endif /* _FS_H */
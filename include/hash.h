@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <u-boot/md5.h>
+#include <sha1.h>
+#include <sha256.h>
+
+/* Largest digest produced by any registered algorithm (SHA-256) */
+#define HASH_MAX_DIGEST_SIZE	32
+
+/* Running state of any of the registered algorithms */
+union hash_ctx {
+	uint32_t crc32;
+	struct MD5Context md5;
+	sha1_context sha1;
+	sha256_context sha256;
+};
+
+struct hash_algo {
+	const char *name;		/* name used in the FIT "algo" property */
+	int digest_size;		/* digest length in bytes */
+	unsigned int chunk_size;	/* bytes hashed between watchdog kicks */
+	void (*init)(union hash_ctx *ctx);
+	void (*update)(union hash_ctx *ctx, const uint8_t *buf,
+		       unsigned int len);
+	void (*finish)(union hash_ctx *ctx, uint8_t *digest);
+};
+
+/*
+ * Look up a hash algorithm by name.
+ *
+ * Returns the algorithm, or NULL if it is not supported.
+ */
+const struct hash_algo *hash_lookup_algo(const char *name);
+
+/*
+ * Hash "len" bytes at "data" with "algo", kicking the watchdog every
+ * algo->chunk_size bytes, and store the algo->digest_size bytes long
+ * result in "digest".
+ */
+void hash_block(const struct hash_algo *algo, const void *data,
+		unsigned int len, uint8_t *digest);
+
+#endif /* _HASH_H */
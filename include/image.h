@@ -57,6 +57,7 @@
 #include <fdt_support.h>
 #define CONFIG_MD5		/* FIT images need MD5 support */
 #define CONFIG_SHA1		/* and SHA1 */
+#define CONFIG_SHA256		/* and SHA256 */
 #endif
 
 /*
@@ -293,6 +294,10 @@ extern bootm_headers_t images;
 #define CHUNKSZ_SHA1 (64 * 1024)
 #endif
 
+#ifndef CHUNKSZ_SHA256
+#define CHUNKSZ_SHA256 (64 * 1024)
+#endif
+
 #define uimage_to_cpu(x)		be32_to_cpu(x)
 #define cpu_to_uimage(x)		cpu_to_be32(x)
 
@@ -361,6 +366,10 @@ int boot_get_cmdline(struct lmb *lmb, ulong *cmd_start, ulong *cmd_end);
 #ifdef CONFIG_SYS_BOOT_GET_KBD
 int boot_get_kbd(struct lmb *lmb, bd_t **kbd);
 #endif /* CONFIG_SYS_BOOT_GET_KBD */
+#ifdef CONFIG_CMD_LOADZ
+int bootm_load_stream(ulong addr, stream_read_fn read, void *priv, int comp,
+		      ulong *lenp);
+#endif /* CONFIG_CMD_LOADZ */
 #endif /* !USE_HOSTCC */
 
 /*******************************************************************/
@@ -531,7 +540,7 @@ static inline int image_check_target_arch(const image_header_t *hdr)
 #define FIT_FDT_PROP		"fdt"
 #define FIT_DEFAULT_PROP	"default"
 
-#define FIT_MAX_HASH_LEN	20	/* max(crc32_len(4), sha1_len(20)) */
+#define FIT_MAX_HASH_LEN	32	/* max(crc32_len(4), sha256_len(32)) */
 
 /* cmdline argument format parsing */
 int fit_parse_conf(const char *spec, ulong addr_curr,
@@ -644,4 +653,18 @@ static inline int fit_image_check_target_arch(const void *fdt, int node)
 #endif /* CONFIG_FIT_VERBOSE */
 #endif /* CONFIG_FIT */
 
+#if defined(CONFIG_FIT) && defined(CONFIG_FIT_PARALLEL_VERIFY) && \
+	!defined(USE_HOSTCC)
+void fit_prepare_hashes(const void *fit, const int *noffsets, int count);
+void fit_drop_hashes(void);
+#else
+static inline void fit_prepare_hashes(const void *fit, const int *noffsets,
+				      int count)
+{
+}
+static inline void fit_drop_hashes(void)
+{
+}
+#endif
+
 #endif	/* __IMAGE_H__ */
@@ -48,6 +48,13 @@ extern struct vidinfo panel_info;
 extern void lcd_ctrl_init (void *lcdbase);
 extern void lcd_enable (void);
 
+/*
+ * Start scanning the panel out from 'start', which lies inside the
+ * framebuffer memory. Returns 0 on success, or -1 if the controller cannot
+ * pan; the weak default always fails.
+ */
+extern int lcd_pan(void *start);
+
 /* setcolreg used in 8bpp/16bpp; initcolregs used in monochrome */
 extern void lcd_setcolreg (ushort regno,
 				ushort red, ushort green, ushort blue);
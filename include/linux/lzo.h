@@ -31,6 +31,10 @@ int lzo1x_decompress_safe(const unsigned char *src, size_t src_len,
 int lzop_decompress(const unsigned char *src, size_t src_len,
 		    unsigned char *dst, size_t *dst_len);
 
+/* decompress lzop format fed in chunks by a callback */
+int lzop_decompress_stream(stream_read_fn read, void *priv,
+			   unsigned char *dst, size_t *dst_len);
+
 /*
  * Return values (< 0 = Error)
  */
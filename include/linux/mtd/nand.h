@@ -464,6 +464,9 @@ struct nand_buffers {
  * @bbt_td:		[REPLACEABLE] bad block table descriptor for flash
  *			lookup.
  * @bbt_md:		[REPLACEABLE] bad block table mirror descriptor
+ * @bbt_stash_gen:	[INTERN] generation of the newest stashed bbt
+ * @bbt_stash_block:	[INTERN] eraseblock holding the newest stashed bbt,
+ *			-1 if there is none
  * @badblock_pattern:	[REPLACEABLE] bad block scan pattern used for initial
  *			bad block scan.
  * @controller:		[REPLACEABLE] a pointer to a hardware controller
@@ -538,6 +541,10 @@ struct nand_chip {
 	uint8_t *bbt;
 	struct nand_bbt_descr *bbt_td;
 	struct nand_bbt_descr *bbt_md;
+#ifdef CONFIG_NAND_BBT_STASH
+	uint32_t bbt_stash_gen;
+	int bbt_stash_block;
+#endif
 
 	struct nand_bbt_descr *badblock_pattern;
 
@@ -593,6 +600,11 @@ extern const struct nand_manufacturers nand_manuf_ids[];
 
 extern int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd);
 extern int nand_update_bbt(struct mtd_info *mtd, loff_t offs);
+#ifdef CONFIG_NAND_BBT_STASH
+extern int nand_update_bbt_stash(struct mtd_info *mtd);
+extern int nand_erase_bbt_stash(struct mtd_info *mtd);
+extern int nand_recheck_bbt_stash(struct mtd_info *mtd, loff_t offs);
+#endif
 extern int nand_default_bbt(struct mtd_info *mtd);
 extern int nand_isbad_bbt(struct mtd_info *mtd, loff_t offs, int allowbbt);
 extern int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
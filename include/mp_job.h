@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _MP_JOB_H
+#define _MP_JOB_H
+
+/* Largest number of cores, including the boot CPU, jobs are spread on */
+#define MP_JOB_MAX_CORES	8
+
+struct mp_job {
+	void (*fn)(void *arg);
+	void *arg;
+	ulong weight;		/* relative cost, used to balance the cores */
+};
+
+/*
+ * Run "njobs" independent jobs, spread over the boot CPU and the secondary
+ * cores that cpu_job_cores() reports, and return when all of them are
+ * done. Jobs must not print or use the console, and only the boot CPU
+ * may kick the watchdog (see cpu_job_current()).
+ */
+void mp_run_jobs(struct mp_job *jobs, int njobs);
+
+/*
+ * Hooks implemented by SoCs that can run jobs on their secondary cores.
+ *
+ * cpu_job_cores() returns the number of cores available, boot CPU
+ * included; the default of 1 runs every job on the boot CPU.
+ * cpu_start_job() makes core "nr" call fn(arg) and returns 0, or non-zero
+ * if the core cannot be used. cpu_wait_job() returns once fn() has returned
+ * on core "nr" and everything it wrote is visible to the boot CPU; it has
+ * to keep the watchdog alive while it waits. cpu_job_current() returns the
+ * number of the core it is called on, 0 for the boot CPU.
+ */
+int cpu_job_cores(void);
+int cpu_start_job(int nr, void (*fn)(void *arg), void *arg);
+void cpu_wait_job(int nr);
+int cpu_job_current(void);
+
+#endif /* _MP_JOB_H */
@@ -437,7 +437,7 @@ extern int		NetRestartWrap;		/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL
+	TFTPSRV, TFTPPUT, LINKLOCAL, TFTPPROBE
 };
 
 /* from net/net.c */
@@ -484,6 +484,22 @@ extern int NetLoop(enum proto_t);
 /* Shutdown adapters and cleanup */
 extern void	NetStop(void);
 
+#ifdef CONFIG_CMD_PXE
+/* Results of tftp_probe(), one per file */
+enum {
+	TFTP_PROBE_UNKNOWN,	/* no answer from the server */
+	TFTP_PROBE_FOUND,	/* the server started sending it */
+	TFTP_PROBE_MISSING,	/* the server refused it */
+};
+
+/*
+ * Ask the TFTP server for all of 'files' at once and fill 'result' in.
+ * Stops as soon as the first file not missing is known to exist. Returns 0
+ * on success, or -1 if the server never answered.
+ */
+extern int tftp_probe(const char * const files[], int *result, int count);
+#endif
+
 /* Load failed.	 Start again. */
 extern void	NetStartAgain(void);
 
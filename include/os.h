@@ -124,6 +124,30 @@ void os_usleep(unsigned long usec);
  */
 u64 os_get_nsec(void);
 
+/**
+ * Run a function in a new host thread
+ *
+ * \param id	Thread slot, from 0 to 7
+ * \param fn	Function to call in the thread
+ * \param arg	Argument passed to fn
+ * \return 0 on success, -1 on error
+ */
+int os_thread_start(int id, void (*fn)(void *arg), void *arg);
+
+/**
+ * Wait until the thread started in slot id has returned
+ *
+ * \param id	Thread slot passed to os_thread_start()
+ */
+void os_thread_join(int id);
+
+/**
+ * Find out which thread started by os_thread_start() this is
+ *
+ * \return The thread slot plus one, or 0 outside of these threads
+ */
+int os_thread_current(void);
+
 /**
  * Parse arguments and update sandbox state.
  *
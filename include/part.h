@@ -65,6 +65,7 @@ typedef struct block_dev_desc {
 #define IF_TYPE_MMC		6
 #define IF_TYPE_SD		7
 #define IF_TYPE_SATA		8
+#define IF_TYPE_HOST		9
 
 /* Part types */
 #define PART_TYPE_UNKNOWN	0x00
@@ -109,6 +110,7 @@ block_dev_desc_t* usb_stor_get_dev(int dev);
 block_dev_desc_t* mmc_get_dev(int dev);
 block_dev_desc_t* systemace_get_dev(int dev);
 block_dev_desc_t* mg_disk_get_dev(int dev);
+block_dev_desc_t *host_get_dev(int dev);
 
 /* disk/part.c */
 int get_partition_info (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
@@ -130,6 +132,7 @@ static inline block_dev_desc_t* usb_stor_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* mmc_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* systemace_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* mg_disk_get_dev(int dev) { return NULL; }
+static inline block_dev_desc_t *host_get_dev(int dev) { return NULL; }
 
 static inline int get_partition_info (block_dev_desc_t * dev_desc, int part,
 	disk_partition_t *info) { return -1; }
@@ -147,6 +150,35 @@ static inline int get_device_and_partition(const char *ifname,
 { *dev_desc = NULL; return -1; }
 #endif
 
+/* disk/blkcache.c */
+struct blkcache_stats {
+	unsigned long	hits;		/* reads served from the cache */
+	unsigned long	misses;		/* cacheable reads that hit the device */
+	int		entries;	/* number of cache entries */
+	int		used;		/* entries holding data */
+	int		max_blks;	/* longest read that is cached */
+};
+
+#ifdef CONFIG_BLOCK_CACHE
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, unsigned long start,
+			    lbaint_t blkcnt, void *buffer);
+unsigned long blkcache_write(block_dev_desc_t *dev_desc, unsigned long start,
+			     lbaint_t blkcnt, const void *buffer);
+void blkcache_invalidate(block_dev_desc_t *dev_desc);
+void blkcache_get_stats(struct blkcache_stats *stats);
+void blkcache_reset_stats(void);
+#else
+static inline unsigned long blkcache_read(block_dev_desc_t *dev_desc,
+					  unsigned long start,
+					  lbaint_t blkcnt, void *buffer)
+{ return dev_desc->block_read(dev_desc->dev, start, blkcnt, buffer); }
+static inline unsigned long blkcache_write(block_dev_desc_t *dev_desc,
+					   unsigned long start,
+					   lbaint_t blkcnt, const void *buffer)
+{ return dev_desc->block_write(dev_desc->dev, start, blkcnt, buffer); }
+static inline void blkcache_invalidate(block_dev_desc_t *dev_desc) {}
+#endif
+
 #ifdef CONFIG_MAC_PARTITION
 /* disk/part_mac.c */
 int get_partition_info_mac (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
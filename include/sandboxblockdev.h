@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __SANDBOX_BLOCK_DEV__
+#define __SANDBOX_BLOCK_DEV__
+
+#include <part.h>
+
+#ifndef CONFIG_HOST_MAX_DEVICES
+#define CONFIG_HOST_MAX_DEVICES	4
+#endif
+
+/* A block device backed by a file on the host */
+struct host_block_dev {
+	block_dev_desc_t blk_dev;
+	char *filename;
+	int fd;
+	unsigned long latency;	/* simulated time per I/O, in us */
+	unsigned long reads;	/* I/O statistics since bind */
+	unsigned long read_blks;
+	unsigned long writes;
+	unsigned long write_blks;
+};
+
+/*
+ * Attach 'filename' as host device 'dev', or detach it if 'filename' is
+ * NULL. Returns 0 on success, -1 on error.
+ */
+int host_dev_bind(int dev, const char *filename);
+
+/* Returns the state of host device 'dev', or NULL if out of range */
+struct host_block_dev *host_get_block_dev(int dev);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __SANDBOX_NAND_H
+#define __SANDBOX_NAND_H
+
+/* Timing model of the sandbox NAND chip */
+struct sandbox_nand_timing {
+	unsigned int t_r;	/* page read, in us */
+	unsigned int t_prog;	/* page program, in us */
+	unsigned int t_bers;	/* block erase, in us */
+	unsigned int t_rc;	/* bus cycle per byte, in ns */
+};
+
+/* Operations carried out since the last reset, and their modelled cost */
+struct sandbox_nand_stats {
+	unsigned long reads;	/* page reads into the page register */
+	unsigned long programs;
+	unsigned long erases;
+	unsigned long bitflips;	/* bits flipped by injection */
+	u64 bytes_out;		/* data bytes read over the bus */
+	u64 bytes_in;		/* data bytes written over the bus */
+	u64 array_ns;		/* time spent in tR, tPROG and tBERS */
+	u64 bus_ns;		/* time spent moving data over the bus */
+};
+
+/* Copy out the counters of the sandbox NAND chip */
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats);
+
+/* Clear the counters of the sandbox NAND chip */
+void sandbox_nand_reset_stats(void);
+
+/* Returns the timing model, which may be changed in place */
+struct sandbox_nand_timing *sandbox_nand_get_timing(void);
+
+/* Flip 'bits' random data bits in every page read from now on */
+void sandbox_nand_set_bitflips(unsigned int bits);
+
+/*
+ * Make 'block' behave like a factory bad block: it reads as zeroes and
+ * program and erase fail. Returns 0 on success, -1 if out of range.
+ */
+int sandbox_nand_mark_bad(unsigned int block);
+
+#endif
@@ -29,6 +29,9 @@
 #define	_SEARCH_H 1
 
 #include <stddef.h>
+#ifdef USE_HOSTCC
+#include <sys/types.h>	/* ssize_t */
+#endif
 
 #define __set_errno(val) do { errno = val; } while (0)
 
@@ -57,6 +60,7 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int *sorted;	/* indices in key order, or NULL */
 /*
  * Callback function which will check whether the given change for variable
  * "name" from "oldval" to "newval" may be applied or not, and possibly apply
@@ -41,6 +41,14 @@
 /* SPI transfer flags */
 #define SPI_XFER_BEGIN	0x01			/* Assert CS before transfer */
 #define SPI_XFER_END	0x02			/* Deassert CS after transfer */
+#define SPI_XFER_DUAL	0x04			/* Move data on two wires */
+#define SPI_XFER_QUAD	0x08			/* Move data on four wires */
+
+/* Multi-wire transfer capabilities, see spi_xfer_caps() */
+#define SPI_CAP_RX_DUAL	0x01			/* Receive on IO0-IO1 */
+#define SPI_CAP_RX_QUAD	0x02			/* Receive on IO0-IO3 */
+#define SPI_CAP_TX_DUAL	0x04			/* Send on IO0-IO1 */
+#define SPI_CAP_TX_QUAD	0x08			/* Send on IO0-IO3 */
 
 /*-----------------------------------------------------------------------
  * Representation of a SPI slave, i.e. what we're communicating with.
@@ -135,11 +143,27 @@ void spi_release_bus(struct spi_slave *slave);
  *   din:	Pointer to a string of bits that will be filled in.
  *   flags:	A bitwise combination of SPI_XFER_* flags.
  *
+ * SPI_XFER_DUAL and SPI_XFER_QUAD make the whole transfer move 2 or 4
+ * bits per clock in the direction given by dout/din. They may only be
+ * used when spi_xfer_caps() says the controller can do so.
+ *
  *   Returns: 0 on success, not 0 on failure
  */
 int  spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		void *din, unsigned long flags);
 
+/*-----------------------------------------------------------------------
+ * Find out which multi-wire transfers the controller can do for a slave.
+ *
+ * Controllers wired up for dual or quad I/O provide this. The default
+ * reports none, so only ordinary single-wire transfers are used.
+ *
+ *   slave:	The SPI slave
+ *
+ *   Returns: a bitwise combination of SPI_CAP_* flags
+ */
+unsigned int spi_xfer_caps(struct spi_slave *slave);
+
 /*-----------------------------------------------------------------------
  * Determine if a SPI chipselect is valid.
  * This function is provided by the board if the low-level SPI driver
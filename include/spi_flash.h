@@ -39,6 +39,14 @@ struct spi_flash {
 	/* Erase (sector) size */
 	u32		sector_size;
 
+	/* Multi-wire fast read picked by spi_flash_setup_read() */
+	u8		read_cmd;
+	/* Address, mode and dummy bytes sent after the command */
+	u8		read_addr_len;
+	/* SPI_XFER_DUAL/QUAD used for those bytes and for the data */
+	u8		read_addr_flags;
+	u8		read_data_flags;
+
 	int		(*read)(struct spi_flash *flash, u32 offset,
 				size_t len, void *buf);
 	int		(*write)(struct spi_flash *flash, u32 offset,
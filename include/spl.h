@@ -39,6 +39,7 @@ struct spl_image_info {
 	u32 entry_point;
 	u32 size;
 	u32 flags;
+	u8 comp;		/* IH_COMP_* of the payload */
 };
 
 #define SPL_COPY_PAYLOAD_ONLY	1
@@ -55,6 +56,11 @@ void spl_board_prepare_for_linux(void);
 void __noreturn jump_to_image_linux(void *arg);
 int spl_start_uboot(void);
 void spl_display_print(void);
+#ifdef CONFIG_SPL_LZO_SUPPORT
+void *spl_lzo_scratch(void);
+void spl_load_compressed(stream_read_fn read, void *priv);
+void spl_load_compressed_buf(const void *src, u32 len);
+#endif
 
 /* NAND SPL functions */
 void spl_nand_load_image(void);
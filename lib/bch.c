@@ -337,6 +337,7 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 	int i, j, s;
 	unsigned int m;
 	uint32_t poly;
+	const uint16_t *row;
 	const int t = GF_T(bch);
 
 	s = bch->ecc_bits;
@@ -347,19 +348,27 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 		ecc[s/32] &= ~((1u << (32-m))-1);
 	memset(syn, 0, 2*t*sizeof(*syn));
 
-	/* compute v(a^j) for j=1 .. 2t-1 */
+	/*
+	 * compute v(a^j) for j=1,3 .. 2t-1 into syn[0..t-1]: each set
+	 * remainder bit adds a precomputed row of t contributions
+	 */
 	do {
 		poly = *ecc++;
 		s -= 32;
 		while (poly) {
 			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
+			row = &bch->syn_tab[(i+s)*t];
+			for (j = 0; j < t; j++)
+				syn[j] ^= row[j];
 
 			poly ^= (1 << i);
 		}
 	} while (s > 0);
 
+	/* spread odd syndromes to their final slots, from the top down */
+	for (j = t-1; j > 0; j--)
+		syn[2*j] = syn[j];
+
 	/* v(a^(2j)) = v(a^j)^2 */
 	for (j = 0; j < t; j++)
 		syn[2*j+1] = gf_sqr(bch, syn[j]);
@@ -995,6 +1004,11 @@ int decode_bch(struct bch_control *bch, const uint8_t *data, unsigned int len,
 
 	/* if caller does not provide syndromes, compute them */
 	if (!syn) {
+		/* error-free codewords are by far the most common case */
+		if (recv_ecc && calc_ecc &&
+		    !memcmp(recv_ecc, calc_ecc, BCH_ECC_BYTES(bch)))
+			return 0;
+
 		if (!calc_ecc) {
 			/* compute received data ecc into an internal buffer */
 			if (!data || !recv_ecc)
@@ -1103,6 +1117,21 @@ static void build_mod8_tables(struct bch_control *bch, const uint32_t *g)
 	}
 }
 
+/*
+ * build syndrome tables: row i holds a^((2j+1)*i) for j=0..t-1, i.e. what
+ * remainder bit i contributes to each odd syndrome
+ */
+static void build_syndrome_tables(struct bch_control *bch)
+{
+	const unsigned int t = GF_T(bch);
+	unsigned int i, j;
+	uint16_t *row = bch->syn_tab;
+
+	for (i = 0; i < bch->ecc_bits; i++, row += t)
+		for (j = 0; j < t; j++)
+			row[j] = a_pow(bch, (2*j+1)*i);
+}
+
 /*
  * build a base for factoring degree 2 polynomials
  */
@@ -1320,6 +1349,12 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	build_mod8_tables(bch, genpoly);
 	kfree(genpoly);
 
+	bch->syn_tab = bch_alloc(bch->ecc_bits*t*sizeof(*bch->syn_tab), &err);
+	if (err)
+		goto fail;
+
+	build_syndrome_tables(bch);
+
 	err = build_deg2_base(bch);
 	if (err)
 		goto fail;
@@ -1343,6 +1378,7 @@ void free_bch(struct bch_control *bch)
 		kfree(bch->a_pow_tab);
 		kfree(bch->a_log_tab);
 		kfree(bch->mod8_tab);
+		kfree(bch->syn_tab);
 		kfree(bch->ecc_buf);
 		kfree(bch->ecc_buf2);
 		kfree(bch->xi_tab);
@@ -36,6 +36,9 @@
 #define RESERVED		0xe0
 #define DEFLATED		8
 
+/* Compressed bytes requested from the source per read() call */
+#define GUNZIP_STREAM_CHUNK	(64 << 10)
+
 void *gzalloc(void *x, unsigned items, unsigned size)
 {
 	void *p;
@@ -53,7 +56,11 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Return the length of the gzip header at src, or -1 if it is invalid or
+ * does not fit in the first len bytes.
+ */
+static int gzip_header_len(const unsigned char *src, unsigned long len)
 {
 	int i, flags;
 
@@ -67,21 +74,111 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	if ((flags & EXTRA_FIELD) != 0)
 		i = 12 + src[10] + (src[11] << 8);
 	if ((flags & ORIG_NAME) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & COMMENT) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
 
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gzip_header_len(src, *lenp);
+	if (i < 0)
+		return (-1);
+
 	return zunzip(dst, dstlen, src, lenp, 1, i);
 }
 
+/*
+ * Uncompress a gzip stream that is fed in chunks by the read() callback,
+ * so the compressed image never has to be held in memory as a whole.
+ */
+int gunzip_stream(void *dst, int dstlen, stream_read_fn read, void *priv,
+		  unsigned long *lenp)
+{
+	unsigned char *buf;
+	z_stream s;
+	int i, n, r;
+
+	buf = malloc(GUNZIP_STREAM_CHUNK);
+	if (!buf) {
+		puts ("Error: gunzip out of memory\n");
+		return -1;
+	}
+
+	n = read(priv, buf, GUNZIP_STREAM_CHUNK);
+	if (n < 10) {
+		puts ("Error: Bad gzipped data\n");
+		free(buf);
+		return -1;
+	}
+	i = gzip_header_len(buf, n);
+	if (i < 0) {
+		free(buf);
+		return -1;
+	}
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf ("Error: inflateInit2() returned %d\n", r);
+		free(buf);
+		return -1;
+	}
+	s.next_in = buf + i;
+	s.avail_in = n - i;
+	s.next_out = dst;
+	s.avail_out = dstlen;
+
+	for (;;) {
+		if (s.avail_in == 0) {
+			n = read(priv, buf, GUNZIP_STREAM_CHUNK);
+			if (n <= 0) {
+				if (n == 0)
+					puts ("Error: gunzip out of data\n");
+				r = -1;
+				break;
+			}
+			s.next_in = buf;
+			s.avail_in = n;
+		}
+		r = inflate(&s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			r = 0;
+			break;
+		}
+		if (r != Z_OK) {
+			printf("Error: inflate() returned %d\n", r);
+			r = -1;
+			break;
+		}
+		if (s.avail_out == 0) {
+			puts ("Error: gunzip output buffer too small\n");
+			r = -1;
+			break;
+		}
+		WATCHDOG_RESET();
+	}
+
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+	free(buf);
+
+	return r;
+}
+
 /*
  * Uncompress blocks compressed with zlib without headers
  */
@@ -30,6 +30,7 @@
 #include <malloc.h>
 
 #ifdef USE_HOSTCC		/* HOST build */
+# include <stdlib.h>
 # include <string.h>
 # include <assert.h>
 # include <ctype.h>
@@ -94,6 +95,16 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Round nel up to the next prime number */
+static unsigned int next_prime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -116,11 +127,7 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 		return 0;
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = next_prime(nel);
 	htab->filled = 0;
 
 	/* allocate memory and zero out */
@@ -128,6 +135,11 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table == NULL)
 		return 0;
 
+#ifdef CONFIG_ENV_SORTED_INDEX
+	/* without the index hexport_r() falls back to sorting */
+	htab->sorted = malloc(htab->size * sizeof(*htab->sorted));
+#endif
+
 	/* everything went alright */
 	return 1;
 }
@@ -165,6 +177,8 @@ void hdestroy_r(struct hsearch_data *htab, int do_apply)
 		}
 	}
 	free(htab->table);
+	free(htab->sorted);
+	htab->sorted = NULL;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -177,9 +191,14 @@ void hdestroy_r(struct hsearch_data *htab, int do_apply)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. Keys are hashed with 32 bit FNV-1a, which
+ * spreads the long, similar names typical for environments (bootcmd_a,
+ * bootcmd_b, ...) evenly over the table.
+ *
+ * Open addressing degrades quickly as the table fills up, so ENTER grows
+ * the table to about twice its size once it is three quarters full. This
+ * moves entries around: indices and ENTRY pointers returned earlier are
+ * invalid after the next ENTER.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
@@ -250,30 +269,181 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	return 0;
 }
 
+/* 32 bit FNV-1a hash of a NUL terminated key */
+static unsigned int hash_key(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* First hash function: simply take the modul but prevent zero. */
+static unsigned int hash_first(unsigned int hash, unsigned int size)
+{
+	hash %= size;
+
+	return hash ? hash : 1;
+}
+
+/* Second hash function: as suggested in [Knuth] */
+static unsigned int hash_step(unsigned int hash, unsigned int size)
+{
+	return 1 + hash % (size - 2);
+}
+
+#ifdef CONFIG_ENV_SORTED_INDEX
+/*
+ * htab->sorted lists the table indices of all used entries in ascending
+ * key order, so that hexport_r() does not need to sort the whole table on
+ * every "saveenv". Entries are kept in place with a binary search and a
+ * memmove(); importing an exported (and thus sorted) environment only
+ * ever appends.
+ */
+static unsigned int sorted_pos(struct hsearch_data *htab, const char *key)
+{
+	unsigned int lo = 0, hi = htab->filled;
+
+	/* shortcut for appending in order */
+	if (hi && strcmp(key, htab->table[htab->sorted[hi - 1]].entry.key) > 0)
+		return hi;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (strcmp(key, htab->table[htab->sorted[mid]].entry.key) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void sorted_insert(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos;
+
+	if (!htab->sorted)
+		return;
+
+	pos = sorted_pos(htab, htab->table[idx].entry.key);
+	memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+		(htab->filled - pos) * sizeof(*htab->sorted));
+	htab->sorted[pos] = idx;
+}
+
+static void sorted_remove(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos;
+
+	if (!htab->sorted)
+		return;
+
+	pos = sorted_pos(htab, htab->table[idx].entry.key);
+	if (pos >= htab->filled || htab->sorted[pos] != idx)
+		return;
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(*htab->sorted));
+}
+#else
+static inline void sorted_insert(struct hsearch_data *htab, unsigned int idx)
+{
+}
+
+static inline void sorted_remove(struct hsearch_data *htab, unsigned int idx)
+{
+}
+#endif
+
+/* Move entry idx of the current table into the (empty) table new */
+static unsigned int hrehash_entry(struct hsearch_data *htab, unsigned int idx,
+				  _ENTRY *new, unsigned int size)
+{
+	unsigned int hash = hash_key(htab->table[idx].entry.key);
+	unsigned int hval = hash_first(hash, size);
+	unsigned int hval2 = hash_step(hash, size);
+	unsigned int nidx = hval;
+
+	while (new[nidx].used) {
+		if (nidx <= hval2)
+			nidx = size + nidx - hval2;
+		else
+			nidx -= hval2;
+	}
+
+	new[nidx].used = hval;
+	new[nidx].entry = htab->table[idx].entry;
+
+	return nidx;
+}
+
+/*
+ * Grow the table to the next prime beyond twice its size. Deleted slots
+ * are dropped on the way. On allocation failure the old table is kept,
+ * it just stays slow.
+ */
+static void hgrow_r(struct hsearch_data *htab)
+{
+	unsigned int size = next_prime(2 * htab->size + 1);
+	unsigned int i;
+	_ENTRY *new;
+
+	new = calloc(size + 1, sizeof(_ENTRY));
+	if (new == NULL)
+		return;
+
+	debug("hgrow: %d/%d entries, new size %d\n",
+	      htab->filled, htab->size, size);
+
+#ifdef CONFIG_ENV_SORTED_INDEX
+	if (htab->sorted) {
+		unsigned int *sorted;
+
+		sorted = realloc(htab->sorted, size * sizeof(*sorted));
+		if (sorted) {
+			htab->sorted = sorted;
+			/* walk the index to update it in place */
+			for (i = 0; i < htab->filled; ++i)
+				sorted[i] = hrehash_entry(htab, sorted[i],
+							  new, size);
+			goto done;
+		}
+		free(htab->sorted);
+		htab->sorted = NULL;
+	}
+#endif
+	for (i = 1; i <= htab->size; ++i) {
+		if (htab->table[i].used > 0)
+			hrehash_entry(htab, i, new, size);
+	}
+
+#ifdef CONFIG_ENV_SORTED_INDEX
+done:
+#endif
+	free(htab->table);
+	htab->table = new;
+	htab->size = size;
+}
+
 int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	      struct hsearch_data *htab)
 {
+	unsigned int hash;
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
+	/* Keep the load factor below 3/4 */
+	if (action == ENTER && (htab->filled + 1) * 4 > htab->size * 3)
+		hgrow_r(htab);
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hash = hash_key(item.key);
+	hval = hash_first(hash, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -307,11 +477,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			return idx;
 		}
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
+		hval2 = hash_step(hash, htab->size);
 
 		do {
 			/*
@@ -330,6 +496,10 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			if (idx == hval)
 				break;
 
+			if (htab->table[idx].used == -1
+			    && !first_deleted)
+				first_deleted = idx;
+
 			/* If entry is found use it. */
 			if ((htab->table[idx].used == hval)
 			    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
@@ -381,6 +551,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			return 0;
 		}
 
+		sorted_insert(htab, idx);
 		++htab->filled;
 
 		/* return new entry */
@@ -422,6 +593,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int do_apply)
 	debug("hdelete: DELETING key \"%s\"\n", key);
 	if (do_apply && htab->apply != NULL)
 		htab->apply(ep->key, ep->data, NULL, H_FORCE);
+	sorted_remove(htab, idx);
 	free((void *)ep->key);
 	free(ep->data);
 	htab->table[idx].used = -1;
@@ -489,7 +661,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 	ENTRY *list[htab->size];
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	int i, k, n, count;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -501,10 +673,12 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 		"size = %zu\n", htab, htab->size, htab->filled, size);
 	/*
 	 * Pass 1:
-	 * search used entries,
+	 * search used entries (in key order if there is an index),
 	 * save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	count = htab->sorted ? htab->filled : htab->size;
+	for (k = 0, n = 0, totlen = 0; k < count; ++k) {
+		i = htab->sorted ? htab->sorted[k] : k + 1;
 
 		if (htab->table[i].used > 0) {
 			ENTRY *ep = &htab->table[i].entry;
@@ -550,7 +724,8 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 #endif
 
 	/* Sort list by keys */
-	qsort(list, n, sizeof(ENTRY *), cmpkey);
+	if (!htab->sorted)
+		qsort(list, n, sizeof(ENTRY *), cmpkey);
 
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
@@ -130,4 +130,115 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+/* Compressed bytes requested from the source per read() call */
+#define LZMA_STREAM_CHUNK (64 << 10)
+
+/*
+ * Same as lzmaBuffToBuffDecompress(), but the compressed data is fed in
+ * chunks by the read() callback. *uncompressedSize gives the room available
+ * at outStream on entry and returns the number of bytes decompressed.
+ */
+int lzmaStreamDecompress (unsigned char *outStream, SizeT *uncompressedSize,
+                  stream_read_fn read, void *priv)
+{
+    unsigned char *inBuf;
+    SizeT inPos, inSize;
+    SizeT outSizeFull, srcLen;
+    UInt32 outSize = 0, outSizeHigh = 0;
+    ELzmaStatus state;
+    ISzAlloc g_Alloc;
+    CLzmaDec p;
+    int res, n, i;
+
+    inBuf = malloc(LZMA_STREAM_CHUNK);
+    if (!inBuf)
+        return SZ_ERROR_MEM;
+
+    /*
+     * The header comes with the first chunk, so that the following reads
+     * stay aligned on chunk boundaries in the source
+     */
+    n = read(priv, inBuf, LZMA_STREAM_CHUNK);
+    if (n < (int)LZMA_DATA_OFFSET) {
+        free(inBuf);
+        return n < 0 ? SZ_ERROR_READ : SZ_ERROR_INPUT_EOF;
+    }
+    inPos = LZMA_DATA_OFFSET;
+    inSize = n;
+
+    for (i = 0; i < 8; i++) {
+        unsigned char b = inBuf[LZMA_SIZE_OFFSET + i];
+        if (i < 4)
+            outSize     += (UInt32)(b) << (i * 8);
+        else
+            outSizeHigh += (UInt32)(b) << ((i - 4) * 8);
+    }
+
+    /*
+     * An all-ones size means "unknown": decode up to the end mark. A known
+     * size that does not fit is an error rather than a truncated image.
+     */
+    outSizeFull = *uncompressedSize;
+    if (outSizeHigh == 0 && outSize <= outSizeFull) {
+        outSizeFull = outSize;
+    } else if (outSizeHigh != (UInt32)-1 || outSize != (UInt32)-1) {
+        free(inBuf);
+        return SZ_ERROR_OUTPUT_EOF;
+    }
+
+    debug("LZMA: Uncompresed size............ 0x%zx\n", outSizeFull);
+
+    g_Alloc.Alloc = SzAlloc;
+    g_Alloc.Free = SzFree;
+
+    LzmaDec_Construct(&p);
+    res = LzmaDec_AllocateProbs(&p, inBuf, LZMA_PROPS_SIZE, &g_Alloc);
+    if (res != SZ_OK) {
+        free(inBuf);
+        return res;
+    }
+    p.dic = outStream;
+    p.dicBufSize = outSizeFull;
+    LzmaDec_Init(&p);
+
+    for (;;) {
+        if (inPos == inSize) {
+            n = read(priv, inBuf, LZMA_STREAM_CHUNK);
+            if (n < 0) {
+                res = SZ_ERROR_READ;
+                break;
+            }
+            inPos = 0;
+            inSize = n;
+        }
+        srcLen = inSize - inPos;
+        res = LzmaDec_DecodeToDic(&p, outSizeFull, inBuf + inPos, &srcLen,
+                                  LZMA_FINISH_ANY, &state);
+        inPos += srcLen;
+        if (res != SZ_OK)
+            break;
+        if (state == LZMA_STATUS_FINISHED_WITH_MARK)
+            break;
+        if (p.dicPos == outSizeFull) {
+            /* with an unknown size, the output must end with the mark */
+            if (outSizeHigh != 0 &&
+                state != LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK)
+                res = SZ_ERROR_OUTPUT_EOF;
+            break;
+        }
+        if (inSize == 0) {
+            /* source ran dry before the end of the stream */
+            res = SZ_ERROR_INPUT_EOF;
+            break;
+        }
+        WATCHDOG_RESET();
+    }
+
+    *uncompressedSize = p.dicPos;
+    LzmaDec_FreeProbs(&p, &g_Alloc);
+    free(inBuf);
+
+    return res;
+}
+
 #endif
@@ -32,4 +32,6 @@
 
 extern int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
 			      unsigned char *inStream,  SizeT  length);
+extern int lzmaStreamDecompress (unsigned char *outStream, SizeT *uncompressedSize,
+			      stream_read_fn read, void *priv);
 #endif
@@ -12,6 +12,8 @@
  */
 
 #include <common.h>
+#include <malloc.h>
+#include <watchdog.h>
 #include <linux/lzo.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
@@ -110,6 +112,130 @@ int lzop_decompress(const unsigned char *src, size_t src_len,
 	return LZO_E_INPUT_OVERRUN;
 }
 
+static int lzop_read(stream_read_fn read, void *priv, void *buf, int len)
+{
+	return read(priv, buf, len) == len ? 0 : LZO_E_INPUT_OVERRUN;
+}
+
+/*
+ * Same as lzop_decompress(), but the compressed data is fed block by block
+ * by the read() callback. *dst_len gives the room available at dst on entry.
+ *
+ * SPL has no heap to spare for the compressed block, so there each block is
+ * read to the top of its own output area, which is stretched to
+ * lzo1x_worst_compress() of the block so the output never overtakes the
+ * input still to be decoded. The room must allow for that margin.
+ */
+int lzop_decompress_stream(stream_read_fn read, void *priv,
+			   unsigned char *dst, size_t *dst_len)
+{
+	unsigned char hdr[16 + 1 + 4 + 4 + 12 + 1 + 255 + 4];
+	unsigned char *start = dst, *end = dst + *dst_len;
+	unsigned char *src;
+#ifndef CONFIG_SPL_BUILD
+	unsigned char *buf = NULL;
+	size_t buf_len = 0;
+#endif
+	size_t tmp;
+	u32 slen, dlen, flags;
+	u16 version;
+	int hlen, n, r;
+
+	/* magic, version, library version, extract version and method */
+	hlen = 16;
+	if (lzop_read(read, priv, hdr, hlen))
+		return LZO_E_ERROR;
+	version = get_unaligned_be16(hdr + 9);
+	/* level, if present, and flags */
+	n = version >= 0x0940 ? 5 : 4;
+	if (lzop_read(read, priv, hdr + hlen, n))
+		return LZO_E_ERROR;
+	hlen += n;
+	flags = get_unaligned_be32(hdr + hlen - 4);
+	/* filter, mode, mtime and file name length */
+	n = 8 + 1;
+	if (flags & HEADER_HAS_FILTER)
+		n += 4;
+	if (version >= 0x0940)
+		n += 4;
+	if (lzop_read(read, priv, hdr + hlen, n))
+		return LZO_E_ERROR;
+	hlen += n;
+	/* file name and header checksum */
+	n = hdr[hlen - 1] + 4;
+	if (lzop_read(read, priv, hdr + hlen, n))
+		return LZO_E_ERROR;
+	hlen += n;
+
+	if (parse_header(hdr) != hdr + hlen)
+		return LZO_E_ERROR;
+
+	for (;;) {
+		/* uncompressed size, compressed size and block checksum */
+		r = lzop_read(read, priv, hdr, 4);
+		if (r)
+			break;
+		dlen = get_unaligned_be32(hdr);
+		if (dlen == 0) {
+			*dst_len = dst - start;
+			break;
+		}
+		r = lzop_read(read, priv, hdr, 8);
+		if (r)
+			break;
+		slen = get_unaligned_be32(hdr);
+
+		r = LZO_E_ERROR;
+		if (slen == 0 || slen > dlen)
+			break;
+		r = LZO_E_OUTPUT_OVERRUN;
+		if (dlen > end - dst)
+			break;
+
+		if (slen == dlen) {
+			/* block was stored uncompressed */
+			r = lzop_read(read, priv, dst, slen);
+			if (r)
+				break;
+		} else {
+#ifdef CONFIG_SPL_BUILD
+			if (lzo1x_worst_compress(dlen) > end - dst)
+				break;
+			src = dst + lzo1x_worst_compress(dlen) - slen;
+#else
+			if (slen > buf_len) {
+				free(buf);
+				buf = malloc(slen);
+				buf_len = buf ? slen : 0;
+				r = LZO_E_OUT_OF_MEMORY;
+				if (!buf)
+					break;
+			}
+			src = buf;
+#endif
+			r = lzop_read(read, priv, src, slen);
+			if (r)
+				break;
+
+			tmp = dlen;
+			r = lzo1x_decompress_safe(src, slen, dst, &tmp);
+			if (r != LZO_E_OK)
+				break;
+			r = LZO_E_ERROR;
+			if (dlen != tmp)
+				break;
+		}
+
+		dst += dlen;
+		WATCHDOG_RESET();
+	}
+#ifndef CONFIG_SPL_BUILD
+	free(buf);
+#endif
+
+	return r;
+}
+
 int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 			unsigned char *out, size_t *out_len)
 {
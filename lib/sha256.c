@@ -20,9 +20,12 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <linux/string.h>
+#else
+#include <stdint.h>
+#include <string.h>
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
-#include <linux/string.h>
 #include <sha256.h>
 
 /*
@@ -60,10 +63,15 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
-void sha256_process(sha256_context * ctx, uint8_t data[64])
+/*
+ * The 64 rounds are fully unrolled so the eight working variables rotate
+ * through the P() arguments instead of being moved, and the message
+ * schedule is kept in a 16-word ring expanded in place by R().
+ */
+static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 {
 	uint32_t temp1, temp2;
-	uint32_t W[64];
+	uint32_t W[16];
 	uint32_t A, B, C, D, E, F, G, H;
 
 	GET_UINT32_BE(W[0], data, 0);
@@ -95,10 +103,10 @@ void sha256_process(sha256_context * ctx, uint8_t data[64])
 #define F0(x,y,z) ((x & y) | (z & (x | y)))
 #define F1(x,y,z) (z ^ (x & (y ^ z)))
 
-#define R(t)					\
-(						\
-	W[t] = S1(W[t - 2]) + W[t - 7] +	\
-		S0(W[t - 15]) + W[t - 16]	\
+#define R(t)						\
+(								\
+	W[(t) & 15] += S1(W[((t) - 2) & 15]) + W[((t) - 7) & 15] +	\
+		S0(W[((t) - 15) & 15])				\
 )
 
 #define P(a,b,c,d,e,f,g,h,x,K) {		\
@@ -191,7 +199,7 @@ void sha256_process(sha256_context * ctx, uint8_t data[64])
 	ctx->state[7] += H;
 }
 
-void sha256_update(sha256_context * ctx, uint8_t * input, uint32_t length)
+void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
 
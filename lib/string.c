@@ -19,6 +19,7 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
 
 
 #if 0 /* not used - was: #ifndef __HAVE_ARCH_STRNICMP */
@@ -431,6 +432,153 @@ char *strswab(const char *s)
 }
 #endif
 
+#if !defined(__HAVE_ARCH_MEMCPY) || !defined(__HAVE_ARCH_MEMMOVE) || \
+	!defined(__HAVE_ARCH_BCOPY)
+#define MEM_WSIZE	sizeof(unsigned long)
+#define MEM_WMASK	(MEM_WSIZE - 1)
+
+/*
+ * Build a destination word from two consecutive aligned source words when
+ * source and destination are misaligned relative to each other; lo is the
+ * word at the lower address and sh the misalignment in bits.
+ */
+#ifdef __BIG_ENDIAN
+#define MEM_MERGE(lo, hi, sh)	\
+	(((lo) << (sh)) | ((hi) >> (8 * MEM_WSIZE - (sh))))
+#else
+#define MEM_MERGE(lo, hi, sh)	\
+	(((lo) >> (sh)) | ((hi) << (8 * MEM_WSIZE - (sh))))
+#endif
+
+/*
+ * Copy count bytes from s to d in ascending address order. All loads of a
+ * block happen before its stores, so this is also safe for overlapping
+ * areas as long as d < s.
+ */
+static void mem_copy_fwd(unsigned char *d, const unsigned char *s,
+			 size_t count)
+{
+	unsigned long *dl;
+	const unsigned long *sl;
+	unsigned long w0, w1, w2, w3;
+	unsigned int sh;
+	size_t n;
+
+	if (count >= 2 * MEM_WSIZE) {
+		/* align the destination */
+		while ((ulong)d & MEM_WMASK) {
+			*d++ = *s++;
+			count--;
+		}
+		dl = (unsigned long *)d;
+		n = count / MEM_WSIZE;
+		sh = 8 * ((ulong)s & MEM_WMASK);
+
+		if (!sh) {
+			sl = (const unsigned long *)s;
+			for (; n >= 4; n -= 4, dl += 4, sl += 4) {
+				w0 = sl[0];
+				w1 = sl[1];
+				w2 = sl[2];
+				w3 = sl[3];
+				dl[0] = w0;
+				dl[1] = w1;
+				dl[2] = w2;
+				dl[3] = w3;
+			}
+			while (n--)
+				*dl++ = *sl++;
+		} else {
+			/*
+			 * Every aligned word read here holds at least one byte
+			 * of the source area, so we never fault past its end.
+			 */
+			sl = (const unsigned long *)(s - sh / 8);
+			w0 = *sl++;
+			for (; n >= 4; n -= 4, dl += 4, sl += 4) {
+				w1 = sl[0];
+				w2 = sl[1];
+				w3 = sl[2];
+				dl[0] = MEM_MERGE(w0, w1, sh);
+				dl[1] = MEM_MERGE(w1, w2, sh);
+				w0 = sl[3];
+				dl[2] = MEM_MERGE(w2, w3, sh);
+				dl[3] = MEM_MERGE(w3, w0, sh);
+			}
+			while (n--) {
+				w1 = *sl++;
+				*dl++ = MEM_MERGE(w0, w1, sh);
+				w0 = w1;
+			}
+		}
+		s += (unsigned char *)dl - d;
+		count -= (unsigned char *)dl - d;
+		d = (unsigned char *)dl;
+	}
+
+	/* copy the rest one byte at a time */
+	while (count--)
+		*d++ = *s++;
+}
+
+/*
+ * Copy count bytes ending just below s to the area ending just below d, in
+ * descending address order. Safe for overlapping areas with d > s.
+ */
+static void mem_copy_bwd(unsigned char *d, const unsigned char *s,
+			 size_t count)
+{
+	unsigned long *dl;
+	const unsigned long *sl;
+	unsigned long w0, w1, w2, w3;
+	unsigned int sh;
+	size_t n;
+
+	if (count >= 2 * MEM_WSIZE) {
+		/* align the destination */
+		while ((ulong)d & MEM_WMASK) {
+			*--d = *--s;
+			count--;
+		}
+		dl = (unsigned long *)d;
+		n = count / MEM_WSIZE;
+		sh = 8 * ((ulong)s & MEM_WMASK);
+
+		if (!sh) {
+			sl = (const unsigned long *)s;
+			for (; n >= 4; n -= 4) {
+				dl -= 4;
+				sl -= 4;
+				w3 = sl[3];
+				w2 = sl[2];
+				w1 = sl[1];
+				w0 = sl[0];
+				dl[3] = w3;
+				dl[2] = w2;
+				dl[1] = w1;
+				dl[0] = w0;
+			}
+			while (n--)
+				*--dl = *--sl;
+		} else {
+			sl = (const unsigned long *)(s - sh / 8);
+			w1 = *sl;
+			while (n--) {
+				w0 = *--sl;
+				*--dl = MEM_MERGE(w0, w1, sh);
+				w1 = w0;
+			}
+		}
+		s -= d - (unsigned char *)dl;
+		count -= d - (unsigned char *)dl;
+		d = (unsigned char *)dl;
+	}
+
+	while (count--)
+		*--d = *--s;
+}
+#endif
+
 #ifndef __HAVE_ARCH_MEMSET
 /**
  * memset - Fill a region of memory with the given value
@@ -442,24 +590,38 @@ char *strswab(const char *s)
  */
 void * memset(void * s,int c,size_t count)
 {
-	unsigned long *sl = (unsigned long *) s;
+	unsigned long *sl;
 	unsigned long cl = 0;
-	char *s8;
+	char *s8 = (char *)s;
 	int i;
 
-	/* do it one word at a time (32 bits or 64 bits) while possible */
-	if ( ((ulong)s & (sizeof(*sl) - 1)) == 0) {
+	if (count >= 2 * sizeof(*sl)) {
+		/* fill up to the first word boundary */
+		while ((ulong)s8 & (sizeof(*sl) - 1)) {
+			*s8++ = c;
+			count--;
+		}
 		for (i = 0; i < sizeof(*sl); i++) {
 			cl <<= 8;
 			cl |= c & 0xff;
 		}
+		/* then four words (32 bits or 64 bits each) at a time */
+		sl = (unsigned long *)s8;
+		while (count >= 4 * sizeof(*sl)) {
+			sl[0] = cl;
+			sl[1] = cl;
+			sl[2] = cl;
+			sl[3] = cl;
+			sl += 4;
+			count -= 4 * sizeof(*sl);
+		}
 		while (count >= sizeof(*sl)) {
 			*sl++ = cl;
 			count -= sizeof(*sl);
 		}
+		s8 = (char *)sl;
 	}
 	/* fill 8 bits at a time */
-	s8 = (char *)sl;
 	while (count--)
 		*s8++ = c;
 
@@ -474,18 +636,23 @@ void * memset(void * s,int c,size_t count)
  * @dest: Where to copy to
  * @count: The size of the area.
  *
- * Note that this is the same as memcpy(), with the arguments reversed.
- * memcpy() is the standard, bcopy() is a legacy BSD function.
+ * Note that this is the same as memmove(), with the arguments reversed.
+ * memmove() is the standard, bcopy() is a legacy BSD function.
  *
  * You should not use this function to access IO space, use memcpy_toio()
  * or memcpy_fromio() instead.
  */
 char * bcopy(const char * src, char * dest, int count)
 {
-	char *tmp = dest;
+	if (src == dest || count <= 0)
+		return dest;
 
-	while (count--)
-		*tmp++ = *src++;
+	if (dest < src || dest >= src + count)
+		mem_copy_fwd((unsigned char *)dest,
+			     (const unsigned char *)src, count);
+	else
+		mem_copy_bwd((unsigned char *)dest + count,
+			     (const unsigned char *)src + count, count);
 
 	return dest;
 }
@@ -503,24 +670,10 @@ char * bcopy(const char * src, char * dest, int count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
-
 	if (src == dest)
 		return dest;
 
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
-		}
-	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
-	while (count--)
-		*d8++ = *s8++;
+	mem_copy_fwd(dest, src, count);
 
 	return dest;
 }
@@ -537,23 +690,14 @@ void * memcpy(void *dest, const void *src, size_t count)
  */
 void * memmove(void * dest,const void *src,size_t count)
 {
-	char *tmp, *s;
-
 	if (src == dest)
 		return dest;
 
-	if (dest <= src) {
-		tmp = (char *) dest;
-		s = (char *) src;
-		while (count--)
-			*tmp++ = *s++;
-		}
-	else {
-		tmp = (char *) dest + count;
-		s = (char *) src + count;
-		while (count--)
-			*--tmp = *--s;
-		}
+	if (dest < src || (const char *)dest >= (const char *)src + count)
+		mem_copy_fwd(dest, src, count);
+	else
+		mem_copy_bwd((unsigned char *)dest + count,
+			     (const unsigned char *)src + count, count);
 
 	return dest;
 }
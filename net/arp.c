@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 
 #include "arp.h"
 
@@ -26,13 +27,43 @@
 # define ARP_TIMEOUT_COUNT	CONFIG_NET_RETRY_COUNT
 #endif
 
-IPaddr_t	NetArpWaitPacketIP;
-static IPaddr_t	NetArpWaitReplyIP;
-/* MAC address of waiting packet's destination */
-uchar	       *NetArpWaitPacketMAC;
-int		NetArpWaitTxPacketSize;
-ulong		NetArpWaitTimerStart;
-int		NetArpWaitTry;
+#ifndef CONFIG_ARP_CACHE_SIZE
+# define ARP_CACHE_SIZE		8	/* # of neighbours remembered */
+#else
+# define ARP_CACHE_SIZE		CONFIG_ARP_CACHE_SIZE
+#endif
+
+#ifndef CONFIG_ARP_CACHE_TIMEOUT
+/* Milliseconds a resolved address is trusted for */
+# define ARP_CACHE_TIMEOUT	60000UL
+#else
+# define ARP_CACHE_TIMEOUT	CONFIG_ARP_CACHE_TIMEOUT
+#endif
+
+/*
+ * The neighbour table. An entry is keyed by the address we ARP for, which is
+ * the gateway for destinations off our subnet. It lives across NetLoop()
+ * calls, so a sequence of commands talking to the same server only resolves
+ * it once. While an entry is pending it holds the last packet sent to it,
+ * which goes out as soon as the reply arrives.
+ */
+#define ARP_FREE	0
+#define ARP_PENDING	1
+#define ARP_RESOLVED	2
+
+struct arp_entry {
+	int		state;
+	IPaddr_t	ip;		/* address being resolved */
+	uchar		ether[ARP_HLEN];
+	ulong		time;		/* when resolved, or last asked */
+	int		try;		/* requests sent while pending */
+	IPaddr_t	wait_ip;	/* destination of the waiting packet */
+	uchar		*wait_mac;	/* caller's copy of the address */
+	uchar		*wait_pkt;	/* the waiting packet, if any */
+	int		wait_len;
+};
+
+static struct arp_entry arp_cache[ARP_CACHE_SIZE];
 
 static uchar   *NetArpTxPacket;	/* THE ARP transmit packet */
 static uchar	NetArpPacketBuf[PKTSIZE_ALIGN + PKTALIGN];
@@ -40,14 +71,81 @@ static uchar	NetArpPacketBuf[PKTSIZE_ALIGN + PKTALIGN];
 void ArpInit(void)
 {
 	/* XXX problem with bss workaround */
-	NetArpWaitPacketMAC = NULL;
-	NetArpWaitPacketIP = 0;
-	NetArpWaitReplyIP = 0;
-	NetArpWaitTxPacketSize = 0;
+	memset(arp_cache, 0, sizeof(arp_cache));
 	NetArpTxPacket = &NetArpPacketBuf[0] + (PKTALIGN - 1);
 	NetArpTxPacket -= (ulong)NetArpTxPacket % PKTALIGN;
 }
 
+/* Drop the packet waiting on an entry */
+static void arp_drop_wait(struct arp_entry *e)
+{
+	free(e->wait_pkt);
+	e->wait_pkt = NULL;
+	e->wait_len = 0;
+	e->wait_mac = NULL;
+}
+
+static struct arp_entry *arp_lookup(IPaddr_t ip)
+{
+	int i;
+
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		struct arp_entry *e = &arp_cache[i];
+
+		if (e->state == ARP_FREE || e->ip != ip)
+			continue;
+
+		if (e->state == ARP_RESOLVED &&
+		    get_timer(0) - e->time > ARP_CACHE_TIMEOUT) {
+			e->state = ARP_FREE;
+			return NULL;
+		}
+
+		return e;
+	}
+
+	return NULL;
+}
+
+/* Find room for a new entry: a free one, else the oldest resolved one */
+static struct arp_entry *arp_alloc(IPaddr_t ip)
+{
+	struct arp_entry *e, *victim = NULL;
+	int i;
+
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		e = &arp_cache[i];
+
+		if (e->state == ARP_FREE) {
+			victim = e;
+			break;
+		}
+		if (victim == NULL || (victim->state == ARP_PENDING &&
+				       e->state == ARP_RESOLVED) ||
+		    (victim->state == e->state && e->time < victim->time))
+			victim = e;
+	}
+
+	arp_drop_wait(victim);
+	memset(victim, 0, sizeof(*victim));
+	victim->ip = ip;
+
+	return victim;
+}
+
+/* The address to ARP for to reach 'dest' */
+static IPaddr_t arp_next_hop(IPaddr_t dest)
+{
+	if ((dest & NetOurSubnetMask) != (NetOurIP & NetOurSubnetMask)) {
+		if (NetOurGatewayIP == 0)
+			puts("## Warning: gatewayip needed but not set\n");
+		else
+			return NetOurGatewayIP;
+	}
+
+	return dest;
+}
+
 void arp_raw_request(IPaddr_t sourceIP, const uchar *targetEther,
 	IPaddr_t targetIP)
 {
@@ -55,7 +153,7 @@ void arp_raw_request(IPaddr_t sourceIP, const uchar *targetEther,
 	struct arp_hdr *arp;
 	int eth_hdr_size;
 
-	debug_cond(DEBUG_DEV_PKT, "ARP broadcast %d\n", NetArpWaitTry);
+	debug_cond(DEBUG_DEV_PKT, "ARP broadcast for %pI4\n", &targetIP);
 
 	pkt = NetArpTxPacket;
 
@@ -78,50 +176,87 @@ void arp_raw_request(IPaddr_t sourceIP, const uchar *targetEther,
 	NetSendPacket(NetArpTxPacket, eth_hdr_size + ARP_HDR_SIZE);
 }
 
-void ArpRequest(void)
+static void arp_request(struct arp_entry *e)
 {
-	if ((NetArpWaitPacketIP & NetOurSubnetMask) !=
-	    (NetOurIP & NetOurSubnetMask)) {
-		if (NetOurGatewayIP == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			NetArpWaitReplyIP = NetArpWaitPacketIP;
-		} else {
-			NetArpWaitReplyIP = NetOurGatewayIP;
-		}
-	} else {
-		NetArpWaitReplyIP = NetArpWaitPacketIP;
+	e->time = get_timer(0);
+	arp_raw_request(NetOurIP, NetEtherNullAddr, e->ip);
+}
+
+int arp_send(IPaddr_t dest, uchar *ether, uchar *pkt, int len)
+{
+	IPaddr_t ip = arp_next_hop(dest);
+	struct arp_entry *e;
+
+	e = arp_lookup(ip);
+	if (e && e->state == ARP_RESOLVED) {
+		if (ether != NULL)
+			memcpy(ether, e->ether, ARP_HLEN);
+		memcpy(((struct ethernet_hdr *)pkt)->et_dest, e->ether,
+		       ARP_HLEN);
+		NetSendPacket(pkt, len);
+		return 0;	/* transmitted */
 	}
 
-	arp_raw_request(NetOurIP, NetEtherNullAddr, NetArpWaitReplyIP);
+	if (e == NULL) {
+		e = arp_alloc(ip);
+		e->state = ARP_PENDING;
+		e->try = 1;
+		arp_request(e);
+	}
+
+	/* keep only the latest packet for each destination */
+	arp_drop_wait(e);
+	e->wait_pkt = malloc(len);
+	if (e->wait_pkt != NULL) {
+		memcpy(e->wait_pkt, pkt, len);
+		e->wait_len = len;
+	}
+	e->wait_ip = dest;
+	e->wait_mac = ether;
+
+	return 1;	/* waiting */
 }
 
-void ArpTimeoutCheck(void)
+void arp_cancel(void)
 {
-	ulong t;
+	int i;
 
-	if (!NetArpWaitPacketIP)
-		return;
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		if (arp_cache[i].state == ARP_PENDING) {
+			arp_drop_wait(&arp_cache[i]);
+			arp_cache[i].state = ARP_FREE;
+		}
+	}
+}
+
+void ArpTimeoutCheck(void)
+{
+	ulong t = get_timer(0);
+	int i;
 
-	t = get_timer(0);
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		struct arp_entry *e = &arp_cache[i];
 
-	/* check for arp timeout */
-	if ((t - NetArpWaitTimerStart) > ARP_TIMEOUT) {
-		NetArpWaitTry++;
+		/* check for arp timeout */
+		if (e->state != ARP_PENDING || t - e->time <= ARP_TIMEOUT)
+			continue;
 
-		if (NetArpWaitTry >= ARP_TIMEOUT_COUNT) {
+		if (++e->try >= ARP_TIMEOUT_COUNT) {
 			puts("\nARP Retry count exceeded; starting again\n");
-			NetArpWaitTry = 0;
+			arp_drop_wait(e);
+			e->state = ARP_FREE;
 			NetStartAgain();
-		} else {
-			NetArpWaitTimerStart = t;
-			ArpRequest();
+			return;
 		}
+
+		arp_request(e);
 	}
 }
 
 void ArpReceive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 {
 	struct arp_hdr *arp;
+	struct arp_entry *e;
 	IPaddr_t reply_ip_addr;
 	uchar *pkt;
 	int eth_hdr_size;
@@ -161,6 +296,14 @@ void ArpReceive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 	case ARPOP_REQUEST:
 		/* reply with our IP address */
 		debug_cond(DEBUG_DEV_PKT, "Got ARP REQUEST, return our IP\n");
+
+		/* refresh what we know about the sender */
+		e = arp_lookup(NetReadIP(&arp->ar_spa));
+		if (e != NULL && e->state == ARP_RESOLVED) {
+			memcpy(e->ether, &arp->ar_sha, ARP_HLEN);
+			e->time = get_timer(0);
+		}
+
 		pkt = (uchar *)et;
 		eth_hdr_size = net_update_ether(et, et->et_src, PROT_ARP);
 		pkt += eth_hdr_size;
@@ -187,46 +330,42 @@ void ArpReceive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		return;
 
 	case ARPOP_REPLY:		/* arp reply */
-		/* are we waiting for a reply */
-		if (!NetArpWaitPacketIP)
+		reply_ip_addr = NetReadIP(&arp->ar_spa);
+
+		/* are we waiting for a reply from there */
+		e = arp_lookup(reply_ip_addr);
+		if (e == NULL || e->state != ARP_PENDING)
 			break;
 
+		debug_cond(DEBUG_DEV_PKT,
+			"Got ARP REPLY, set eth addr (%pM)\n",
+			arp->ar_data);
+
 #ifdef CONFIG_KEEP_SERVERADDR
-		if (NetServerIP == NetArpWaitPacketIP) {
+		if (NetServerIP == e->wait_ip) {
 			char buf[20];
 			sprintf(buf, "%pM", &arp->ar_sha);
 			setenv("serveraddr", buf);
 		}
 #endif
 
-		reply_ip_addr = NetReadIP(&arp->ar_spa);
-
-		/* matched waiting packet's address */
-		if (reply_ip_addr == NetArpWaitReplyIP) {
-			debug_cond(DEBUG_DEV_PKT,
-				"Got ARP REPLY, set eth addr (%pM)\n",
-				arp->ar_data);
-
-			/* save address for later use */
-			if (NetArpWaitPacketMAC != NULL)
-				memcpy(NetArpWaitPacketMAC,
-				       &arp->ar_sha, ARP_HLEN);
+		/* save address for later use */
+		memcpy(e->ether, &arp->ar_sha, ARP_HLEN);
+		e->state = ARP_RESOLVED;
+		e->time = get_timer(0);
+		if (e->wait_mac != NULL)
+			memcpy(e->wait_mac, &arp->ar_sha, ARP_HLEN);
 
-			net_get_arp_handler()((uchar *)arp, 0, reply_ip_addr,
-				0, len);
+		net_get_arp_handler()((uchar *)arp, 0, reply_ip_addr, 0, len);
 
-			/* set the mac address in the waiting packet's header
-			   and transmit it */
-			memcpy(((struct ethernet_hdr *)NetTxPacket)->et_dest,
+		/* set the mac address in the waiting packet's header
+		   and transmit it */
+		if (e->wait_pkt != NULL) {
+			memcpy(((struct ethernet_hdr *)e->wait_pkt)->et_dest,
 				&arp->ar_sha, ARP_HLEN);
-			NetSendPacket(NetTxPacket, NetArpWaitTxPacketSize);
-
-			/* no arp request pending now */
-			NetArpWaitPacketIP = 0;
-			NetArpWaitTxPacketSize = 0;
-			NetArpWaitPacketMAC = NULL;
-
+			NetSendPacket(e->wait_pkt, e->wait_len);
 		}
+		arp_drop_wait(e);
 		return;
 	default:
 		debug("Unexpected ARP opcode 0x%x\n",
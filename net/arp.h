@@ -13,17 +13,18 @@
 
 #include <common.h>
 
-extern IPaddr_t	NetArpWaitPacketIP;
-/* MAC address of waiting packet's destination */
-extern uchar *NetArpWaitPacketMAC;
-extern int NetArpWaitTxPacketSize;
-extern ulong NetArpWaitTimerStart;
-extern int NetArpWaitTry;
-
 void ArpInit(void);
-void ArpRequest(void);
 void arp_raw_request(IPaddr_t sourceIP, const uchar *targetEther,
 	IPaddr_t targetIP);
+/*
+ * Send 'pkt', built with a null destination MAC, to 'dest'. The MAC comes
+ * from the neighbour table; if it isn't known yet an ARP request goes out
+ * and the packet waits for the reply. 'ether', if not NULL, is filled in
+ * with the address once known. Returns 0 if sent, 1 if waiting.
+ */
+int arp_send(IPaddr_t dest, uchar *ether, uchar *pkt, int len);
+/* Forget the packets waiting for ARP replies */
+void arp_cancel(void);
 void ArpTimeoutCheck(void);
 void ArpReceive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len);
 
@@ -270,6 +270,8 @@ static void net_clear_handlers(void)
 
 static void net_cleanup_loop(void)
 {
+	/* cancel any ARP that may not have completed */
+	arp_cancel();
 	net_clear_handlers();
 }
 
@@ -362,6 +364,11 @@ restart:
 			TftpStartServer();
 			break;
 #endif
+#ifdef CONFIG_CMD_PXE
+		case TFTPPROBE:
+			TftpStartProbe();
+			break;
+#endif
 #if defined(CONFIG_CMD_DHCP)
 		case DHCP:
 			BootpTry = 0;
@@ -458,9 +465,6 @@ restart:
 		 *	Abort if ctrl-c was pressed.
 		 */
 		if (ctrlc()) {
-			/* cancel any ARP that may not have completed */
-			NetArpWaitPacketIP = 0;
-
 			net_cleanup_loop();
 			eth_halt();
 			/* Invalidate the last protocol */
@@ -697,22 +701,11 @@ int NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport,
 	net_set_udp_header(pkt, dest, dport, sport, payload_len);
 	pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 
-	/* if MAC address was not discovered yet, do an ARP request */
+	/* if MAC address was not discovered yet, ask the neighbour table */
 	if (memcmp(ether, NetEtherNullAddr, 6) == 0) {
-		debug_cond(DEBUG_DEV_PKT, "sending ARP for %pI4\n", &dest);
-
-		/* save the ip and eth addr for the packet to send after arp */
-		NetArpWaitPacketIP = dest;
-		NetArpWaitPacketMAC = ether;
-
-		/* size of the waiting packet */
-		NetArpWaitTxPacketSize = pkt_hdr_size + payload_len;
-
-		/* and do the ARP request */
-		NetArpWaitTry = 1;
-		NetArpWaitTimerStart = get_timer(0);
-		ArpRequest();
-		return 1;	/* waiting */
+		debug_cond(DEBUG_DEV_PKT, "resolving %pI4\n", &dest);
+		return arp_send(dest, ether, NetTxPacket,
+				pkt_hdr_size + payload_len);
 	} else {
 		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
 			&dest, ether);
@@ -1214,6 +1207,7 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 	case TFTPGET:
 	case TFTPPUT:
+	case TFTPPROBE:
 		if (NetServerIP == 0) {
 			puts("*** ERROR: `serverip' not set\n");
 			return 1;
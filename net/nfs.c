@@ -37,13 +37,31 @@
 # define NFS_TIMEOUT CONFIG_NFS_TIMEOUT
 #endif
 
+/* nfs_read_reply() and rpc_lookup_reply() results besides -NFSERR_* */
+#define NFS_RPC_ERR	1
+#define NFS_RPC_DROP	124	/* stale or foreign reply, ignore it */
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static int nfs_version;
+
+static char dirfh[NFS3_FHSIZE];	/* file handle of directory */
+static unsigned int dirfh3_length;
+static char filefh[NFS3_FHSIZE]; /* file handle of kernel image */
+static unsigned int filefh3_length;
 
-static char dirfh[NFS_FHSIZE];	/* file handle of directory */
-static char filefh[NFS_FHSIZE]; /* file handle of kernel image */
+/*
+ * READ requests in flight. Each has its own RPC id and file offset, so
+ * replies may arrive in any order; len is 0 for an unused slot.
+ */
+static struct nfs_read_slot {
+	unsigned long	id;
+	int		offset;
+	int		len;
+} nfs_reads[NFS_READ_WINDOW];
+static int nfs_next_offset;	/* first offset not requested yet */
+static int nfs_file_size;	/* -1 until the server told us */
+static int nfs_hashes;		/* progress indicator */
 
 static enum net_loop_state nfs_download_state;
 static IPaddr_t NfsServerIP;
@@ -184,7 +202,10 @@ rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 	pkt.u.call.type = htonl(MSG_CALL);
 	pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
 	pkt.u.call.prog = htonl(rpc_prog);
-	pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	if (rpc_prog == PROG_PORTMAP)
+		pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	else	/* MOUNT version 3 goes with NFS version 3 */
+		pkt.u.call.vers = htonl(nfs_version);
 	pkt.u.call.proc = htonl(rpc_proc);
 	p = (uint32_t *)&(pkt.u.call.data);
 
@@ -274,6 +295,24 @@ nfs_umountall_req(void)
 	rpc_req(PROG_MOUNT, MOUNT_UMOUNTALL, data, len);
 }
 
+/**************************************************************************
+NFS_ADD_FH - Add a file handle in the format of the protocol version
+**************************************************************************/
+static uint32_t *nfs_add_fh(uint32_t *p, const char *fh,
+			    unsigned int fh3_length)
+{
+	if (nfs_version == NFS_V2) {
+		memcpy(p, fh, NFS_FHSIZE);
+		return p + NFS_FHSIZE / 4;
+	}
+
+	*p++ = htonl(fh3_length);
+	if (fh3_length & 3)
+		*(p + fh3_length / 4) = 0;
+	memcpy(p, fh, fh3_length);
+	return p + (fh3_length + 3) / 4;
+}
+
 /***************************************************************************
  * NFS_READLINK (AH 2003-07-14)
  * This procedure is called when read of the first block fails -
@@ -291,8 +330,7 @@ nfs_readlink_req(void)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, filefh, filefh3_length);
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
@@ -315,8 +353,7 @@ nfs_lookup_req(char *fname)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, dirfh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, dirfh, dirfh3_length);
 	*p++ = htonl(fnamelen);
 	if (fnamelen & 3)
 		*(p + fnamelen / 4) = 0;
@@ -325,7 +362,10 @@ nfs_lookup_req(char *fname)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_LOOKUP, data, len);
+	if (nfs_version == NFS_V2)
+		rpc_req(PROG_NFS, NFS_LOOKUP, data, len);
+	else
+		rpc_req(PROG_NFS, NFS3PROC_LOOKUP, data, len);
 }
 
 /**************************************************************************
@@ -341,17 +381,99 @@ nfs_read_req(int offset, int readlen)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, filefh, filefh3_length);
+	if (nfs_version == NFS_V3)
+		*p++ = 0;		/* offset is 64 bit */
 	*p++ = htonl(offset);
 	*p++ = htonl(readlen);
-	*p++ = 0;
+	if (nfs_version == NFS_V2)
+		*p++ = 0;		/* totalcount, unused */
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+/* (Re)issue the READ of one slot under a fresh RPC id */
+static void
+nfs_read_send(struct nfs_read_slot *slot, int offset, int readlen)
+{
+	slot->offset = offset;
+	slot->len = readlen;
+	nfs_read_req(offset, readlen);
+	slot->id = rpc_id;
+}
+
+static struct nfs_read_slot *nfs_read_slot_free(void)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (!nfs_reads[i].len)
+			return &nfs_reads[i];
+
+	return NULL;
+}
+
+static int nfs_read_in_flight(void)
+{
+	int i, n = 0;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (nfs_reads[i].len)
+			n++;
+
+	return n;
+}
+
+static void nfs_read_reset(void)
+{
+	memset(nfs_reads, 0, sizeof(nfs_reads));
+	nfs_next_offset = 0;
+	nfs_file_size = -1;
+	nfs_hashes = 0;
+}
+
+/*
+ * Keep the window full. Until the first reply has told us the file size
+ * (or that this is not a regular file) only one READ is sent.
+ */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+
+	while ((slot = nfs_read_slot_free()) != NULL) {
+		if (nfs_file_size < 0 && nfs_read_in_flight())
+			break;
+		if (nfs_file_size >= 0 && nfs_next_offset >= nfs_file_size)
+			break;
+		nfs_read_send(slot, nfs_next_offset, NFS_READ_SIZE);
+		nfs_next_offset += NFS_READ_SIZE;
+	}
+}
+
+/* Timeout: send everything still outstanding again */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	if (!nfs_read_in_flight()) {
+		nfs_read_fill();
+		return;
+	}
+
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (nfs_reads[i].len)
+			nfs_read_send(&nfs_reads[i], nfs_reads[i].offset,
+				      nfs_reads[i].len);
+}
+
+static int nfs_read_done(void)
+{
+	return nfs_file_size >= 0 && nfs_next_offset >= nfs_file_size &&
+		!nfs_read_in_flight();
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -363,10 +485,10 @@ NfsSend(void)
 
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
-		rpc_lookup_req(PROG_MOUNT, 1);
+		rpc_lookup_req(PROG_MOUNT, nfs_version == NFS_V3 ? 3 : 1);
 		break;
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
-		rpc_lookup_req(PROG_NFS, 2);
+		rpc_lookup_req(PROG_NFS, nfs_version);
 		break;
 	case STATE_MOUNT_REQ:
 		nfs_mount_req(nfs_path);
@@ -378,7 +500,7 @@ NfsSend(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -400,12 +522,12 @@ rpc_lookup_reply(int prog, uchar *pkt, unsigned len)
 	debug("%s\n", __func__);
 
 	if (ntohl(rpc_pkt.u.reply.id) != rpc_id)
-		return -1;
+		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
 	    rpc_pkt.u.reply.astatus)
-		return -1;
+		return -NFS_RPC_ERR;
 
 	switch (prog) {
 	case PROG_MOUNT:
@@ -416,6 +538,10 @@ rpc_lookup_reply(int prog, uchar *pkt, unsigned len)
 		break;
 	}
 
+	/* port 0: the program is not registered in this version */
+	if (!rpc_pkt.u.reply.data[0])
+		return -NFS_RPC_ERR;
+
 	return 0;
 }
 
@@ -438,7 +564,14 @@ nfs_mount_reply(uchar *pkt, unsigned len)
 		return -1;
 
 	fs_mounted = 1;
-	memcpy(dirfh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	if (nfs_version == NFS_V2) {
+		memcpy(dirfh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	} else {
+		dirfh3_length = ntohl(rpc_pkt.u.reply.data[1]);
+		if (dirfh3_length > NFS3_FHSIZE)
+			dirfh3_length = NFS3_FHSIZE;
+		memcpy(dirfh, rpc_pkt.u.reply.data + 2, dirfh3_length);
+	}
 
 	return 0;
 }
@@ -484,7 +617,14 @@ nfs_lookup_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	if (nfs_version == NFS_V2) {
+		memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	} else {
+		filefh3_length = ntohl(rpc_pkt.u.reply.data[1]);
+		if (filefh3_length > NFS3_FHSIZE)
+			filefh3_length = NFS3_FHSIZE;
+		memcpy(filefh, rpc_pkt.u.reply.data + 2, filefh3_length);
+	}
 
 	return 0;
 }
@@ -493,6 +633,7 @@ static int
 nfs_readlink_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	uint32_t *path;
 	int rlen;
 
 	debug("%s\n", __func__);
@@ -508,34 +649,48 @@ nfs_readlink_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	rlen = ntohl(rpc_pkt.u.reply.data[1]); /* new path length */
+	/* NFSv3 puts the (optional) symlink attributes first */
+	path = &rpc_pkt.u.reply.data[1];
+	if (nfs_version == NFS_V3 && *path++)
+		path += NFS3_FATTR_WORDS;
+
+	rlen = ntohl(path[0]); /* new path length */
 
-	if (*((char *)&(rpc_pkt.u.reply.data[2])) != '/') {
+	if (*((char *)&path[1]) != '/') {
 		int pathlen;
 		strcat(nfs_path, "/");
 		pathlen = strlen(nfs_path);
-		memcpy(nfs_path + pathlen, (uchar *)&(rpc_pkt.u.reply.data[2]),
-			rlen);
+		memcpy(nfs_path + pathlen, (uchar *)&path[1], rlen);
 		nfs_path[pathlen + rlen] = 0;
 	} else {
-		memcpy(nfs_path, (uchar *)&(rpc_pkt.u.reply.data[2]), rlen);
+		memcpy(nfs_path, (uchar *)&path[1], rlen);
 		nfs_path[rlen] = 0;
 	}
 	return 0;
 }
 
 static int
-nfs_read_reply(uchar *pkt, unsigned len)
+nfs_read_reply(uchar *pkt, unsigned len, struct nfs_read_slot **slotp)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot = NULL;
+	uint32_t *data;
+	unsigned long id;
+	int i, rlen, eof = 0, size = -1;
+	unsigned pos;
 
 	debug("%s\n", __func__);
 
-	memcpy((uchar *)&rpc_pkt, pkt, sizeof(rpc_pkt.u.reply));
+	memcpy((uchar *)&rpc_pkt, pkt,
+	       min(len, (unsigned)sizeof(rpc_pkt.u.reply)));
 
-	if (ntohl(rpc_pkt.u.reply.id) != rpc_id)
-		return -1;
+	id = ntohl(rpc_pkt.u.reply.id);
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		if (nfs_reads[i].len && nfs_reads[i].id == id)
+			slot = &nfs_reads[i];
+	if (!slot)
+		return -NFS_RPC_DROP;
+	*slotp = slot;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -548,17 +703,44 @@ nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
+	data = rpc_pkt.u.reply.data;
+	if (nfs_version == NFS_V2) {
+		/* fattr follows the status, data follows the fattr */
+		size = ntohl(data[6]);
+		rlen = ntohl(data[18]);
+		data += 19;
+	} else {
+		/* post_op_attr, count, eof, opaque data */
+		data++;
+		if (*data++) {
+			if (!data[5])
+				size = ntohl(data[6]);
+			data += NFS3_FATTR_WORDS;
+		}
+		rlen = ntohl(data[0]);
+		eof = ntohl(data[1]);
+		data += 3;
+	}
+
+	pos = (uchar *)data - (uchar *)&rpc_pkt;
+	if (rlen > slot->len || pos + rlen > len)
+		return -9999;
+
+	/* Only a well-formed reply may tell the file size */
+	if (nfs_file_size < 0 && size >= 0)
+		nfs_file_size = size;
+
+	if (nfs_hashes && !(nfs_hashes % (5 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(nfs_hashes++ % 5))
 		putc('#');
 
-	rlen = ntohl(rpc_pkt.u.reply.data[18]);
-	if (store_block((uchar *)pkt + sizeof(rpc_pkt.u.reply),
-			nfs_offset, rlen))
+	if (store_block(pkt + pos, slot->offset, rlen))
 		return -9999;
 
+	if (eof)
+		nfs_file_size = slot->offset + rlen;
+
 	return rlen;
 }
 
@@ -579,9 +761,23 @@ NfsTimeout(void)
 	}
 }
 
+/*
+ * The server does not speak NFSv3 (or its MOUNT protocol): start over at
+ * the portmapper, asking for version 2 this time.
+ */
+static void
+nfs_fall_back_v2(void)
+{
+	debug("NFSv3 not available, falling back to NFSv2\n");
+	nfs_version = NFS_V2;
+	NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	NfsSend();
+}
+
 static void
 NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 {
+	struct nfs_read_slot *slot;
 	int rlen;
 
 	debug("%s\n", __func__);
@@ -591,19 +787,35 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
-		rpc_lookup_reply(PROG_MOUNT, pkt, len);
+		rlen = rpc_lookup_reply(PROG_MOUNT, pkt, len);
+		if (rlen == -NFS_RPC_DROP)
+			break;
+		if (rlen && nfs_version == NFS_V3) {
+			nfs_fall_back_v2();
+			break;
+		}
 		NfsState = STATE_PRCLOOKUP_PROG_NFS_REQ;
 		NfsSend();
 		break;
 
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
-		rpc_lookup_reply(PROG_NFS, pkt, len);
+		rlen = rpc_lookup_reply(PROG_NFS, pkt, len);
+		if (rlen == -NFS_RPC_DROP)
+			break;
+		if (rlen && nfs_version == NFS_V3) {
+			nfs_fall_back_v2();
+			break;
+		}
 		NfsState = STATE_MOUNT_REQ;
 		NfsSend();
 		break;
 
 	case STATE_MOUNT_REQ:
 		if (nfs_mount_reply(pkt, len)) {
+			if (nfs_version == NFS_V3 && !fs_mounted) {
+				nfs_fall_back_v2();
+				break;
+			}
 			puts("*** ERROR: Cannot mount\n");
 			/* just to be sure... */
 			NfsState = STATE_UMOUNT_REQ;
@@ -631,8 +843,7 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 			NfsSend();
 		} else {
 			NfsState = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_read_reset();
 			NfsSend();
 		}
 		break;
@@ -653,18 +864,38 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &slot);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		NetSetTimeout(NFS_TIMEOUT, NfsTimeout);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			NfsSend();
+		if (rlen >= 0) {
+			int offset = slot->offset;
+			int want = slot->len;
+
+			slot->len = 0;
+			if (rlen == 0) {
+				/* nothing (more) at this offset */
+				if (nfs_file_size < 0 || offset < nfs_file_size)
+					nfs_file_size = offset;
+			} else if (rlen < want && (nfs_file_size < 0 ||
+				   offset + rlen < nfs_file_size)) {
+				/* short read, ask for the rest */
+				nfs_read_send(slot, offset + rlen, want - rlen);
+			}
+
+			if (nfs_read_done()) {
+				nfs_download_state = NETLOOP_SUCCESS;
+				NfsState = STATE_UMOUNT_REQ;
+				NfsSend();
+			} else {
+				nfs_read_fill();
+			}
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
+			nfs_read_reset();
 			NfsState = STATE_READLINK_REQ;
 			NfsSend();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
 		}
@@ -743,6 +974,7 @@ NfsStart(void)
 
 	NfsTimeoutCount = 0;
 	NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	nfs_version = NFS_V3;
 
 	/*NfsOurPort = 4096 + (get_ticks() % 3072);*/
 	/*FIX ME !!!*/
@@ -28,7 +28,17 @@
 #define NFS_READLINK    5
 #define NFS_READ        6
 
+#define NFS3PROC_LOOKUP 3
+
 #define NFS_FHSIZE      32
+#define NFS3_FHSIZE     64
+
+/* Supported NFS protocol versions */
+#define NFS_V2          2
+#define NFS_V3          3
+
+/* Words of a fattr3 structure, as sent in a post_op_attr */
+#define NFS3_FATTR_WORDS 21
 
 #define NFSERR_PERM     1
 #define NFSERR_NOENT    2
@@ -36,17 +46,33 @@
 #define NFSERR_ISDIR    21
 #define NFSERR_INVAL    22
 
-/* Block size used for NFS read accesses.  A RPC reply packet (including  all
- * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, the config file may want to use a
- * bigger value. In any case, most NFS servers are optimized for a power of 2.
+/* Block size used for NFS read accesses.  Without CONFIG_IP_DEFRAG a RPC
+ * reply packet (including all headers) must fit within a single Ethernet
+ * frame. With it, default to 8 KiB: the most an NFSv2 server returns per
+ * READ, and well within the default CONFIG_NET_MAXDEFRAG. NFSv3 servers are
+ * only limited by their rsize, so the config file may want to go higher.
+ * In any case, most NFS servers are optimized for a power of 2.
  */
 #ifdef CONFIG_NFS_READ_SIZE
 #define NFS_READ_SIZE CONFIG_NFS_READ_SIZE
+#elif defined(CONFIG_IP_DEFRAG)
+#define NFS_READ_SIZE 8192
 #else
 #define NFS_READ_SIZE 1024 /* biggest power of two that fits Ether frame */
 #endif
 
+/*
+ * Number of READ requests kept in flight, each for its own file offset.
+ * By default as many as there are receive buffers, up to 4.
+ */
+#ifdef CONFIG_NFS_READ_WINDOW
+#define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+#elif PKTBUFSRX < 4
+#define NFS_READ_WINDOW PKTBUFSRX
+#else
+#define NFS_READ_WINDOW 4
+#endif
+
 #define NFS_MAXLINKDEPTH 16
 
 struct rpc_t {
@@ -68,7 +94,8 @@ struct rpc_t {
 			uint32_t verifier;
 			uint32_t v2;
 			uint32_t astatus;
-			uint32_t data[19];
+			/* large enough for an NFSv3 READ reply header */
+			uint32_t data[NFS3_FATTR_WORDS + 5];
 		} reply;
 	} u;
 };
@@ -43,25 +43,13 @@ static int ping_send(void)
 	uchar *pkt;
 	int eth_hdr_size;
 
-	/* XXX always send arp request */
-
-	debug_cond(DEBUG_DEV_PKT, "sending ARP for %pI4\n", &NetPingIP);
-
-	NetArpWaitPacketIP = NetPingIP;
-
 	eth_hdr_size = NetSetEther(NetTxPacket, NetEtherNullAddr, PROT_IP);
 	pkt = (uchar *)NetTxPacket + eth_hdr_size;
 
 	set_icmp_header(pkt, NetPingIP);
 
-	/* size of the waiting packet */
-	NetArpWaitTxPacketSize = eth_hdr_size + IP_ICMP_HDR_SIZE;
-
-	/* and do the ARP request */
-	NetArpWaitTry = 1;
-	NetArpWaitTimerStart = get_timer(0);
-	ArpRequest();
-	return 1;	/* waiting */
+	return arp_send(NetPingIP, NULL, NetTxPacket,
+			eth_hdr_size + IP_ICMP_HDR_SIZE);
 }
 
 static void ping_timeout(void)
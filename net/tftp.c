@@ -129,6 +129,24 @@ static char tftp_filename[MAX_LEN];
 static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
 static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize: the server sends this many blocks before waiting
+ * for an ACK. 1 is plain lock-step RFC 1350 behaviour and is not
+ * negotiated at all.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short TftpWindowSize = 1;
+static unsigned short TftpWindowSizeOption = TFTP_WINDOWSIZE;
+/* blocks received since we last sent an ACK */
+static unsigned short TftpWindowPos;
+/* a gap in the current window has been reported with an ACK already */
+static int TftpGapAcked;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -200,6 +218,8 @@ static void new_transfer(void)
 	TftpLastBlock = 0;
 	TftpBlockWrap = 0;
 	TftpBlockWrapOffset = 0;
+	TftpWindowPos = 0;
+	TftpGapAcked = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 	TftpFinalBlock = 0;
 #endif
@@ -352,6 +372,10 @@ TftpSend(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, TftpBlkSizeOption, 0);
+		/* and for several blocks per ACK */
+		if (TftpState == STATE_SEND_RRQ && TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!ProhibitMcast) {
@@ -521,6 +545,17 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				debug("Blocksize ack: %s, %d\n",
 					(char *)pkt+i+8, TftpBlkSize);
 			}
+			if (strcmp((char *)pkt+i, "windowsize") == 0) {
+				TftpWindowSize = (unsigned short)
+					simple_strtoul((char *)pkt+i+11, NULL,
+						       10);
+				/* never more than we asked for */
+				if (TftpWindowSize > TftpWindowSizeOption ||
+				    TftpWindowSize == 0)
+					TftpWindowSize = 1;
+				debug("Windowsize ack: %s, %d\n",
+					(char *)pkt+i+11, TftpWindowSize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				TftpTsize = simple_strtoul((char *)pkt+i+6,
@@ -551,6 +586,34 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		len -= 2;
 		TftpBlock = ntohs(*(ushort *)pkt);
 
+		/*
+		 * With a window the server streams blocks without waiting,
+		 * so a gap means something was lost: ACK the last block we
+		 * got in sequence and the server restarts its window after
+		 * it (RFC 7440 section 4). This is done even if that block
+		 * was ACKed already, as when the first block of a window is
+		 * lost. Only do it once per gap so that the rest of the
+		 * stale window doesn't trigger an ACK storm.
+		 */
+		if (TftpWindowSize > 1 &&
+		    (TftpState == STATE_DATA || TftpState == STATE_OACK)) {
+			ulong last = TftpState == STATE_OACK ? 0 : TftpLastBlock;
+
+			if (TftpBlock == ((last + 1) & 0xffff)) {
+				TftpGapAcked = 0;
+			} else if (TftpBlock != last) {
+				debug("Got block %ld, expected %ld\n",
+				      TftpBlock, (last + 1) & 0xffff);
+				TftpBlock = last;
+				TftpWindowPos = 0;
+				if (!TftpGapAcked) {
+					TftpGapAcked = 1;
+					TftpSend();
+				}
+				break;
+			}
+		}
+
 		update_block_number();
 
 		if (TftpState == STATE_SEND_RRQ)
@@ -620,7 +683,10 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			}
 		}
 #endif
-		TftpSend();
+		if (++TftpWindowPos >= TftpWindowSize || len < TftpBlkSize) {
+			TftpWindowPos = 0;
+			TftpSend();
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (Multicast) {
@@ -672,12 +738,30 @@ TftpTimeout(void)
 	} else {
 		puts("T ");
 		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+		/* the server restarts its window after this ACK */
+		TftpWindowPos = 0;
 		if (TftpState != STATE_RECV_WRQ)
 			TftpSend();
 	}
 }
 
 
+/* Pick up the user's choice of timeout; TFTP has a minimum of 1 second */
+static void tftp_timeout_from_env(void)
+{
+	char *ep = getenv("tftptimeout");
+
+	if (ep != NULL)
+		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
+
+	if (TftpTimeoutMSecs < 1000) {
+		printf("TFTP timeout (%ld ms) too low, "
+			"set minimum = 1000 ms\n",
+			TftpTimeoutMSecs);
+		TftpTimeoutMSecs = 1000;
+	}
+}
+
 void TftpStart(enum proto_t protocol)
 {
 	char *ep;             /* Environment pointer */
@@ -690,19 +774,16 @@ void TftpStart(enum proto_t protocol)
 	if (ep != NULL)
 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
 
-	ep = getenv("tftptimeout");
+	ep = getenv("tftpwindowsize");
 	if (ep != NULL)
-		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+	if (TftpWindowSizeOption < 1)
+		TftpWindowSizeOption = 1;
 
-	if (TftpTimeoutMSecs < 1000) {
-		printf("TFTP timeout (%ld ms) too low, "
-			"set minimum = 1000 ms\n",
-			TftpTimeoutMSecs);
-		TftpTimeoutMSecs = 1000;
-	}
+	tftp_timeout_from_env();
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-		TftpBlkSizeOption, TftpTimeoutMSecs);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+		TftpBlkSizeOption, TftpWindowSizeOption, TftpTimeoutMSecs);
 
 	TftpRemoteIP = NetServerIP;
 	if (BootFile[0] == '\0') {
@@ -799,8 +880,10 @@ void TftpStart(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(NetServerEther, 0, 6);
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
+	TftpGapAcked = 0;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -812,6 +895,211 @@ void TftpStart(enum proto_t protocol)
 	TftpSend();
 }
 
+#ifdef CONFIG_CMD_PXE
+/*
+ * Probing: ask the server for several files at once, each RRQ from its own
+ * source port, and note which of them it has. Nothing is loaded; a transfer
+ * the server starts is cancelled as soon as its first packet arrives, and the
+ * caller fetches the file it settles on with a normal TFTPGET.
+ */
+static const char * const *TftpProbeFiles;
+static int *TftpProbeResult;
+static int TftpProbeCount;
+static int TftpProbeSent;	/* RRQs sent so far, from the first file */
+static int TftpProbeHeard;	/* 1 once the server has answered */
+
+/* Send the RRQ for file i, returns 1 if it is waiting for ARP */
+static int tftp_probe_rrq(int i)
+{
+	const char *file = TftpProbeFiles[i];
+	const char *p = strchr(file, ':');
+	uchar *pkt, *xp;
+	ushort *s;
+
+	if (p != NULL)
+		file = p + 1;
+
+	pkt = NetTxPacket + NetEthHdrSize() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	s = (ushort *)pkt;
+	*s++ = htons(TFTP_RRQ);
+	pkt = (uchar *)s;
+	strcpy((char *)pkt, file);
+	pkt += strlen(file) + 1;
+	strcpy((char *)pkt, "octet");
+	pkt += 5 /*strlen("octet")*/ + 1;
+
+	return NetSendUDPPacket(NetServerEther, TftpRemoteIP, WELL_KNOWN_PORT,
+				TftpOurPort + i, pkt - xp);
+}
+
+/*
+ * Send the RRQs not sent yet. Only one packet per destination can wait for
+ * ARP, so stop there; the rest go out with the first reply.
+ */
+static void tftp_probe_send_new(void)
+{
+	while (TftpProbeSent < TftpProbeCount)
+		if (tftp_probe_rrq(TftpProbeSent++))
+			break;
+}
+
+/* Tell the server we don't want the transfer it just started */
+static void tftp_probe_cancel(int i, unsigned src)
+{
+	uchar *pkt, *xp;
+	ushort *s;
+
+	pkt = NetTxPacket + NetEthHdrSize() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	s = (ushort *)pkt;
+	*s++ = htons(TFTP_ERROR);
+	*s++ = htons(TFTP_ERR_UNDEFINED);
+	pkt = (uchar *)s;
+	strcpy((char *)pkt, "Probe only");
+	pkt += 10 /*strlen("Probe only")*/ + 1;
+
+	NetSendUDPPacket(NetServerEther, TftpRemoteIP, src, TftpOurPort + i,
+			 pkt - xp);
+}
+
+/*
+ * We are done once every file is missing, or the first one that isn't
+ * missing is known to be there: that is the one the caller will pick.
+ */
+static int tftp_probe_done(void)
+{
+	int i;
+
+	for (i = 0; i < TftpProbeCount; i++) {
+		if (TftpProbeResult[i] == TFTP_PROBE_UNKNOWN)
+			return 0;
+		if (TftpProbeResult[i] == TFTP_PROBE_FOUND)
+			return 1;
+	}
+
+	return 1;
+}
+
+static void
+tftp_probe_handler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
+		   unsigned len)
+{
+	int i = dest - TftpOurPort;
+
+	/* Only the server we asked may answer, a stray MISSING gets cached */
+	if (sip != TftpRemoteIP)
+		return;
+
+	if (i < 0 || i >= TftpProbeSent || len < 4 ||
+	    TftpProbeResult[i] != TFTP_PROBE_UNKNOWN)
+		return;
+
+	switch (ntohs(*(ushort *)pkt)) {
+	case TFTP_DATA:
+	case TFTP_OACK:
+		TftpProbeResult[i] = TFTP_PROBE_FOUND;
+		tftp_probe_cancel(i, src);
+		break;
+
+	case TFTP_ERROR:
+		switch (ntohs(*(ushort *)(pkt + 2))) {
+		case TFTP_ERR_FILE_NOT_FOUND:
+		case TFTP_ERR_ACCESS_DENIED:
+			TftpProbeResult[i] = TFTP_PROBE_MISSING;
+			break;
+		default:
+			/* leave it to the retry */
+			return;
+		}
+		break;
+
+	default:
+		return;
+	}
+
+	TftpProbeHeard = 1;
+	if (tftp_probe_done()) {
+		net_set_state(NETLOOP_SUCCESS);
+		return;
+	}
+
+	tftp_probe_send_new();
+}
+
+static void tftp_probe_timeout(void)
+{
+	int i;
+
+	if (++TftpTimeoutCount > TftpTimeoutCountMax) {
+		/* what is still unknown stays so */
+		if (TftpProbeHeard)
+			net_set_state(NETLOOP_SUCCESS);
+		else
+			net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	puts("T ");
+	NetSetTimeout(TftpTimeoutMSecs, tftp_probe_timeout);
+	for (i = 0; i < TftpProbeSent; i++)
+		if (TftpProbeResult[i] == TFTP_PROBE_UNKNOWN &&
+		    tftp_probe_rrq(i))
+			return;
+	tftp_probe_send_new();
+}
+
+void TftpStartProbe(void)
+{
+	const char *p = strchr(TftpProbeFiles[0], ':');
+
+	tftp_timeout_from_env();
+
+	TftpRemoteIP = NetServerIP;
+	if (p != NULL)
+		TftpRemoteIP = string_to_ip(TftpProbeFiles[0]);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("TFTP probing %d files on server %pI4\n", TftpProbeCount,
+	       &TftpRemoteIP);
+
+	TftpTimeoutCountMax = TftpRRQTimeoutCountMax;
+	TftpTimeoutCount = 0;
+	NetSetTimeout(TftpTimeoutMSecs, tftp_probe_timeout);
+	net_set_udp_handler(tftp_probe_handler);
+
+	/* Use pseudo-random source ports, one per file */
+	TftpOurPort = 1024 + (get_timer(0) % 3072);
+	TftpProbeSent = 0;
+	TftpProbeHeard = 0;
+
+	/* zero out server ether in case the server ip has changed */
+	memset(NetServerEther, 0, 6);
+
+	tftp_probe_send_new();
+}
+
+int tftp_probe(const char * const files[], int *result, int count)
+{
+	int i;
+
+	if (count <= 0)
+		return 0;
+
+	for (i = 0; i < count; i++)
+		result[i] = TFTP_PROBE_UNKNOWN;
+
+	TftpProbeFiles = files;
+	TftpProbeResult = result;
+	TftpProbeCount = count;
+
+	if (NetLoop(TFTPPROBE) < 0)
+		return -1;
+
+	return 0;
+}
+#endif /* CONFIG_CMD_PXE */
+
 #ifdef CONFIG_CMD_TFTPSRV
 void
 TftpStartServer(void)
@@ -829,8 +1117,10 @@ TftpStartServer(void)
 	TftpTimeoutMSecs = TIMEOUT;
 	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
 
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
+	TftpGapAcked = 0;
 	TftpBlock = 0;
 	TftpOurPort = WELL_KNOWN_PORT;
 
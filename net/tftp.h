@@ -22,6 +22,10 @@ void TftpStart(enum proto_t protocol);	/* Begin TFTP get/put */
 extern void TftpStartServer(void);	/* Wait for incoming TFTP put */
 #endif
 
+#ifdef CONFIG_CMD_PXE
+extern void TftpStartProbe(void);	/* Probe for several files at once */
+#endif
+
 extern ulong TftpRRQTimeoutMSecs;
 extern int TftpRRQTimeoutCountMax;
 
@@ -0,0 +1,618 @@
+/*
+ * Copyright (c) 2012
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Write a generated UBIFS image to a volume on the sandbox NAND chip and
+ * read its files back with ubifsload, one file per compressor.
+ *
+ * The image is what mkfs.ubifs would make of three small files, in the
+ * smallest layout UBIFS accepts: the leaf nodes in one LEB, the index in
+ * the next, and an LPT of one nnode over one written pnode. The file data
+ * repeats with a short period so that the LZO and deflate encoders below
+ * only need a literal run and one long match per block.
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include "../fs/ubifs/ubifs.h"
+#include "../fs/ubifs/crc16.h"
+
+#define UT_VOLUME	"ut_ubifs"
+
+#define UT_LOG_LEBS	UBIFS_MIN_LOG_LEBS
+#define UT_LPT_LEBS	UBIFS_MIN_LPT_LEBS
+#define UT_LPT_LNUM	(UBIFS_LOG_LNUM + UT_LOG_LEBS)
+#define UT_MAIN_LNUM	(UT_LPT_LNUM + UT_LPT_LEBS + UBIFS_MIN_ORPH_LEBS)
+#define UT_LEB_CNT	(UT_MAIN_LNUM + UBIFS_MIN_MAIN_LEBS)
+#define UT_DATA_LNUM	UT_MAIN_LNUM
+#define UT_IDX_LNUM	(UT_MAIN_LNUM + 1)
+#define UT_GC_LNUM	(UT_MAIN_LNUM + 2)
+#define UT_FANOUT	8
+
+#define UT_FILE_SIZE	(2 * UBIFS_BLOCK_SIZE + 1000)
+#define UT_BLOCKS	DIV_ROUND_UP(UT_FILE_SIZE, UBIFS_BLOCK_SIZE)
+#define UT_PERIOD	64
+#define UT_MAX_BRANCHES	32
+
+static const struct {
+	const char *name;
+	int compr_type;
+} ut_files[] = {
+	{ "none.bin", UBIFS_COMPR_NONE },
+	{ "lzo.bin", UBIFS_COMPR_LZO },
+	{ "zlib.bin", UBIFS_COMPR_ZLIB },
+};
+
+struct ut_branch {
+	u32 key[2];
+	int lnum;
+	int offs;
+	int len;
+};
+
+struct ut_image {
+	u8 *buf;
+	int leb_size;
+	int min_io_size;
+	unsigned long long sqnum;
+	int offs[UT_LEB_CNT];		/* first free byte of each LEB */
+	struct ut_branch br[UT_MAX_BRANCHES];
+	int br_cnt;
+};
+
+/* Byte @pos of file @file: printable, so deflate codes it in 8 bits */
+static u8 ut_file_byte(int file, int pos)
+{
+	int block = pos / UBIFS_BLOCK_SIZE;
+
+	return 'A' + (file * 31 + block * 17 + pos % UT_PERIOD * 7) % 58;
+}
+
+static void ut_fill(u8 *buf, int file, int pos, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = ut_file_byte(file, pos + i);
+}
+
+/* LZO1X count: in the instruction byte, or 0s of 255 and the rest */
+static u8 *ut_lzo_count(u8 *op, u8 insn, int t, int bits)
+{
+	if (t <= bits) {
+		*op++ = insn | t;
+		return op;
+	}
+
+	*op++ = insn;
+	for (t -= bits; t > 255; t -= 255)
+		*op++ = 0;
+	*op++ = t;
+
+	return op;
+}
+
+/* @len bytes of period UT_PERIOD as LZO1X: the literals, one M3 match */
+static int ut_lzo(const u8 *in, int len, u8 *out)
+{
+	u8 *op = out;
+
+	op = ut_lzo_count(op, 0, UT_PERIOD - 3, 15);
+	memcpy(op, in, UT_PERIOD);
+	op += UT_PERIOD;
+
+	op = ut_lzo_count(op, 32, len - UT_PERIOD - 2, 31);
+	*op++ = (UT_PERIOD - 1) << 2;
+	*op++ = (UT_PERIOD - 1) >> 6;
+
+	/* end of stream: M4 match with distance 0 */
+	*op++ = 17;
+	*op++ = 0;
+	*op++ = 0;
+
+	return op - out;
+}
+
+struct ut_bits {
+	u8 *p;
+	u32 val;
+	int n;
+};
+
+static void ut_put_bits(struct ut_bits *bw, u32 val, int n)
+{
+	bw->val |= val << bw->n;
+	bw->n += n;
+	while (bw->n >= 8) {
+		*bw->p++ = bw->val;
+		bw->val >>= 8;
+		bw->n -= 8;
+	}
+}
+
+/* Huffman codes go out most significant bit first */
+static void ut_put_code(struct ut_bits *bw, u32 code, int n)
+{
+	while (n--)
+		ut_put_bits(bw, code >> n & 1, 1);
+}
+
+static const u16 ut_len_base[] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const u8 ut_len_extra[] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const u16 ut_dist_base[] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+};
+static const u8 ut_dist_extra[] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+};
+
+static int ut_deflate_sym(const u16 *base, int cnt, int val)
+{
+	int i = cnt - 1;
+
+	while (base[i] > val)
+		i--;
+
+	return i;
+}
+
+/* The same as raw deflate: one block with the fixed Huffman codes */
+static int ut_deflate(const u8 *in, int len, u8 *out)
+{
+	struct ut_bits bw = { .p = out };
+	int i, n, sym, m = len - UT_PERIOD;
+
+	ut_put_bits(&bw, 1, 1);		/* last block */
+	ut_put_bits(&bw, 1, 2);		/* fixed codes */
+	for (i = 0; i < UT_PERIOD; i++)
+		ut_put_code(&bw, 0x30 + in[i], 8);
+
+	for (; m; m -= n) {
+		/* a match is 3 to 258 bytes, do not leave less than 3 */
+		n = min(m, 258);
+		if (m - n && m - n < 3)
+			n = m - 3;
+
+		i = ut_deflate_sym(ut_len_base, ARRAY_SIZE(ut_len_base), n);
+		sym = 257 + i;
+		if (sym < 280)
+			ut_put_code(&bw, sym - 256, 7);
+		else
+			ut_put_code(&bw, 0xc0 + sym - 280, 8);
+		ut_put_bits(&bw, n - ut_len_base[i], ut_len_extra[i]);
+
+		i = ut_deflate_sym(ut_dist_base, ARRAY_SIZE(ut_dist_base),
+				   UT_PERIOD);
+		ut_put_code(&bw, i, 5);
+		ut_put_bits(&bw, UT_PERIOD - ut_dist_base[i], ut_dist_extra[i]);
+	}
+
+	ut_put_code(&bw, 0, 7);		/* end of block */
+	if (bw.n)
+		*bw.p++ = bw.val;
+
+	return bw.p - out;
+}
+
+static void *ut_new_node(struct ut_image *img, int lnum, int len)
+{
+	void *node = img->buf + lnum * img->leb_size + img->offs[lnum];
+
+	memset(node, 0, ALIGN(len, 8));
+	return node;
+}
+
+/* Finish the common header of the node at the LEB's free space */
+static int ut_add_node(struct ut_image *img, int lnum, void *node, int type,
+		       int len)
+{
+	struct ubifs_ch *ch = node;
+	int offs = img->offs[lnum];
+
+	ch->magic = cpu_to_le32(UBIFS_NODE_MAGIC);
+	ch->sqnum = cpu_to_le64(type == UBIFS_PAD_NODE ? 0 : ++img->sqnum);
+	ch->len = cpu_to_le32(len);
+	ch->node_type = type;
+	ch->group_type = UBIFS_NO_NODE_GROUP;
+	ch->crc = cpu_to_le32(crc32(UBIFS_CRC32_INIT, node + 8, len - 8));
+	img->offs[lnum] += ALIGN(len, 8);
+
+	return offs;
+}
+
+/* Pad a LEB which gets scanned up to the next min. I/O unit */
+static void ut_pad(struct ut_image *img, int lnum)
+{
+	int offs = ALIGN(img->offs[lnum], img->min_io_size);
+	int pad = offs - img->offs[lnum];
+	void *p = img->buf + lnum * img->leb_size + img->offs[lnum];
+
+	if (pad >= UBIFS_PAD_NODE_SZ) {
+		struct ubifs_pad_node *pad_node = p;
+
+		memset(p, 0, pad);
+		pad_node->pad_len = cpu_to_le32(pad - UBIFS_PAD_NODE_SZ);
+		ut_add_node(img, lnum, p, UBIFS_PAD_NODE, UBIFS_PAD_NODE_SZ);
+	} else
+		memset(p, UBIFS_PADDING_BYTE, pad);
+	img->offs[lnum] = offs;
+}
+
+static void ut_add_leaf(struct ut_image *img, void *node, int type, int len,
+			u32 inum, int key_type, u32 val)
+{
+	struct ut_branch *br = &img->br[img->br_cnt++];
+	__le32 *key = node + UBIFS_KEY_OFFSET;
+
+	br->key[0] = inum;
+	br->key[1] = val | key_type << UBIFS_S_KEY_BLOCK_BITS;
+	key[0] = cpu_to_le32(br->key[0]);
+	key[1] = cpu_to_le32(br->key[1]);
+	br->lnum = UT_DATA_LNUM;
+	br->len = len;
+	br->offs = ut_add_node(img, UT_DATA_LNUM, node, type, len);
+}
+
+static void ut_add_inode(struct ut_image *img, u32 inum, int mode, int nlink,
+			 long long size, int compr_type)
+{
+	struct ubifs_ino_node *ino;
+
+	ino = ut_new_node(img, UT_DATA_LNUM, UBIFS_INO_NODE_SZ);
+	ino->creat_sqnum = cpu_to_le64(img->sqnum + 1);
+	ino->size = cpu_to_le64(size);
+	ino->nlink = cpu_to_le32(nlink);
+	ino->mode = cpu_to_le32(mode);
+	ino->compr_type = cpu_to_le16(compr_type);
+	ut_add_leaf(img, ino, UBIFS_INO_NODE, UBIFS_INO_NODE_SZ, inum,
+		    UBIFS_INO_KEY, 0);
+}
+
+static void ut_add_file(struct ut_image *img, int file)
+{
+	u32 inum = UBIFS_FIRST_INO + file;
+	int type = ut_files[file].compr_type;
+	struct ubifs_data_node *dn;
+	struct ubifs_dent_node *dent;
+	const char *name = ut_files[file].name;
+	int nlen = strlen(name);
+	u8 data[UBIFS_BLOCK_SIZE];
+	int block, len, clen;
+
+	for (block = 0; block < UT_BLOCKS; block++) {
+		len = min(UT_FILE_SIZE - block * UBIFS_BLOCK_SIZE,
+			  UBIFS_BLOCK_SIZE);
+		ut_fill(data, file, block * UBIFS_BLOCK_SIZE, len);
+
+		dn = ut_new_node(img, UT_DATA_LNUM, UBIFS_MAX_DATA_NODE_SZ);
+		dn->size = cpu_to_le32(len);
+		dn->compr_type = cpu_to_le16(type);
+		if (type == UBIFS_COMPR_LZO)
+			clen = ut_lzo(data, len, dn->data);
+		else if (type == UBIFS_COMPR_ZLIB)
+			clen = ut_deflate(data, len, dn->data);
+		else {
+			memcpy(dn->data, data, len);
+			clen = len;
+		}
+		ut_add_leaf(img, dn, UBIFS_DATA_NODE, UBIFS_DATA_NODE_SZ + clen,
+			    inum, UBIFS_DATA_KEY, block);
+	}
+
+	ut_add_inode(img, inum, S_IFREG | 0644, 1, UT_FILE_SIZE, type);
+
+	dent = ut_new_node(img, UT_DATA_LNUM, UBIFS_DENT_NODE_SZ + nlen + 1);
+	dent->inum = cpu_to_le64(inum);
+	dent->type = UBIFS_ITYPE_REG;
+	dent->nlen = cpu_to_le16(nlen);
+	memcpy(dent->name, name, nlen);
+	ut_add_leaf(img, dent, UBIFS_DENT_NODE, UBIFS_DENT_NODE_SZ + nlen + 1,
+		    UBIFS_ROOT_INO, UBIFS_DENT_KEY, key_r5_hash(name, nlen));
+}
+
+static int ut_branch_cmp(const void *a, const void *b)
+{
+	const struct ut_branch *x = a, *y = b;
+
+	if (x->key[0] != y->key[0])
+		return x->key[0] < y->key[0] ? -1 : 1;
+	if (x->key[1] != y->key[1])
+		return x->key[1] < y->key[1] ? -1 : 1;
+	return 0;
+}
+
+/* Write the index bottom up, the root is the last node */
+static long long ut_add_index(struct ut_image *img, struct ut_branch *root)
+{
+	struct ubifs_idx_node *idx;
+	struct ubifs_branch *br;
+	struct ut_branch *zbr = img->br;
+	int i, j, n, k, len, level = 0, cnt = img->br_cnt;
+	long long idx_sz = 0;
+
+	qsort(zbr, cnt, sizeof(*zbr), ut_branch_cmp);
+
+	do {
+		for (i = 0, k = 0; i < cnt; i += n, k++) {
+			n = min(cnt - i, UT_FANOUT);
+			len = UBIFS_IDX_NODE_SZ +
+			      n * (UBIFS_BRANCH_SZ + UBIFS_SK_LEN);
+			idx = ut_new_node(img, UT_IDX_LNUM, len);
+			idx->child_cnt = cpu_to_le16(n);
+			idx->level = cpu_to_le16(level);
+			for (j = 0; j < n; j++) {
+				br = (void *)idx->branches +
+				     j * (UBIFS_BRANCH_SZ + UBIFS_SK_LEN);
+				br->lnum = cpu_to_le32(zbr[i + j].lnum);
+				br->offs = cpu_to_le32(zbr[i + j].offs);
+				br->len = cpu_to_le32(zbr[i + j].len);
+				((__le32 *)br->key)[0] =
+					cpu_to_le32(zbr[i + j].key[0]);
+				((__le32 *)br->key)[1] =
+					cpu_to_le32(zbr[i + j].key[1]);
+			}
+
+			/* the node is done with zbr[i..], so k <= i is free */
+			zbr[k].key[0] = zbr[i].key[0];
+			zbr[k].key[1] = zbr[i].key[1];
+			zbr[k].lnum = UT_IDX_LNUM;
+			zbr[k].len = len;
+			zbr[k].offs = ut_add_node(img, UT_IDX_LNUM, idx,
+						  UBIFS_IDX_NODE, len);
+			idx_sz += ALIGN(len, 8);
+		}
+		cnt = k;
+		level++;
+	} while (cnt > 1);
+
+	*root = zbr[0];
+	return idx_sz;
+}
+
+static void ut_pack(u8 *buf, int *pos, u32 val, int nrbits)
+{
+	for (; nrbits; nrbits--, val >>= 1, (*pos)++)
+		if (val & 1)
+			buf[*pos / 8] |= 1 << (*pos % 8);
+}
+
+static void ut_lpt_crc(u8 *buf, int len)
+{
+	u16 crc = crc16(-1, buf + UBIFS_LPT_CRC_BYTES,
+			len - UBIFS_LPT_CRC_BYTES);
+
+	buf[0] = crc;
+	buf[1] = crc >> 8;
+}
+
+static int ut_leb_free(struct ut_image *img, int lnum)
+{
+	return img->leb_size - ALIGN(img->offs[lnum], img->min_io_size);
+}
+
+static int ut_leb_dirty(struct ut_image *img, int lnum)
+{
+	return ALIGN(img->offs[lnum], img->min_io_size) - img->offs[lnum];
+}
+
+static void ut_build(struct ut_image *img)
+{
+	struct ubifs_sb_node *sup;
+	struct ubifs_mst_node *mst;
+	struct ubifs_cs_node *cs;
+	struct ut_branch root;
+	int space_bits = fls(img->leb_size) - 3;
+	int lnum_bits = fls(UT_LPT_LEBS);
+	int offs_bits = fls(img->leb_size - 1);
+	int spc_bits = fls(img->leb_size);
+	int pnode_sz, nnode_sz, ltab_sz;
+	int i, pos, lnum, free, dirty, lpt_used, empty = 0;
+	long long dir_size = UBIFS_INO_NODE_SZ, idx_sz;
+	long long total_free = 0, total_dirty = 0, total_used = 0;
+	u8 *lpt;
+
+	sup = ut_new_node(img, UBIFS_SB_LNUM, UBIFS_SB_NODE_SZ);
+	sup->key_hash = UBIFS_KEY_HASH_R5;
+	sup->key_fmt = UBIFS_SIMPLE_KEY_FMT;
+	sup->min_io_size = cpu_to_le32(img->min_io_size);
+	sup->leb_size = cpu_to_le32(img->leb_size);
+	sup->leb_cnt = cpu_to_le32(UT_LEB_CNT);
+	sup->max_leb_cnt = cpu_to_le32(UT_LEB_CNT);
+	sup->max_bud_bytes = cpu_to_le64(4LL * img->leb_size);
+	sup->log_lebs = cpu_to_le32(UT_LOG_LEBS);
+	sup->lpt_lebs = cpu_to_le32(UT_LPT_LEBS);
+	sup->orph_lebs = cpu_to_le32(UBIFS_MIN_ORPH_LEBS);
+	sup->jhead_cnt = cpu_to_le32(1);
+	sup->fanout = cpu_to_le32(UT_FANOUT);
+	sup->lsave_cnt = cpu_to_le32(256);
+	sup->fmt_version = cpu_to_le32(UBIFS_FORMAT_VERSION);
+	sup->default_compr = cpu_to_le16(UBIFS_COMPR_LZO);
+	sup->time_gran = cpu_to_le32(1000000000);
+	memcpy(sup->uuid, "ut_ubifs uuid...", sizeof(sup->uuid));
+	ut_add_node(img, UBIFS_SB_LNUM, sup, UBIFS_SB_NODE, UBIFS_SB_NODE_SZ);
+
+	for (i = 0; i < ARRAY_SIZE(ut_files); i++) {
+		ut_add_file(img, i);
+		dir_size += CALC_DENT_SIZE(strlen(ut_files[i].name));
+	}
+	ut_add_inode(img, UBIFS_ROOT_INO, S_IFDIR | 0755, 2, dir_size,
+		     UBIFS_COMPR_NONE);
+	idx_sz = ut_add_index(img, &root);
+
+	cs = ut_new_node(img, UBIFS_LOG_LNUM, UBIFS_CS_NODE_SZ);
+	ut_add_node(img, UBIFS_LOG_LNUM, cs, UBIFS_CS_NODE, UBIFS_CS_NODE_SZ);
+	ut_pad(img, UBIFS_LOG_LNUM);
+
+	/*
+	 * Nine main LEBs take three pnodes under one nnode. Only the first
+	 * pnode has LEBs in use, the others are left unwritten (empty).
+	 */
+	pnode_sz = DIV_ROUND_UP(UBIFS_LPT_CRC_BITS + UBIFS_LPT_TYPE_BITS +
+				(space_bits * 2 + 1) * UBIFS_LPT_FANOUT, 8);
+	nnode_sz = DIV_ROUND_UP(UBIFS_LPT_CRC_BITS + UBIFS_LPT_TYPE_BITS +
+				(lnum_bits + offs_bits) * UBIFS_LPT_FANOUT, 8);
+	ltab_sz = DIV_ROUND_UP(UBIFS_LPT_CRC_BITS + UBIFS_LPT_TYPE_BITS +
+			       UT_LPT_LEBS * spc_bits * 2, 8);
+	lpt = ut_new_node(img, UT_LPT_LNUM, pnode_sz + nnode_sz + ltab_sz);
+
+	pos = UBIFS_LPT_CRC_BITS;
+	ut_pack(lpt, &pos, UBIFS_LPT_PNODE, UBIFS_LPT_TYPE_BITS);
+	for (lnum = UT_MAIN_LNUM; lnum < UT_LEB_CNT; lnum++) {
+		free = ut_leb_free(img, lnum);
+		dirty = ut_leb_dirty(img, lnum);
+		if (lnum < UT_MAIN_LNUM + UBIFS_LPT_FANOUT) {
+			ut_pack(lpt, &pos, free >> 3, space_bits);
+			ut_pack(lpt, &pos, dirty >> 3, space_bits);
+			ut_pack(lpt, &pos, lnum == UT_IDX_LNUM, 1);
+		}
+		total_free += free;
+		total_dirty += dirty;
+		if (lnum != UT_IDX_LNUM)
+			total_used += img->leb_size - free - dirty;
+		if (free == img->leb_size)
+			empty++;
+	}
+	ut_lpt_crc(lpt, pnode_sz);
+
+	pos = UBIFS_LPT_CRC_BITS;
+	ut_pack(lpt + pnode_sz, &pos, UBIFS_LPT_NNODE, UBIFS_LPT_TYPE_BITS);
+	for (i = 0; i < UBIFS_LPT_FANOUT; i++) {
+		/* one past the last LPT LEB stands for "not written" */
+		ut_pack(lpt + pnode_sz, &pos, i ? UT_LPT_LEBS : 0, lnum_bits);
+		ut_pack(lpt + pnode_sz, &pos, 0, offs_bits);
+	}
+	ut_lpt_crc(lpt + pnode_sz, nnode_sz);
+
+	lpt_used = pnode_sz + nnode_sz + ltab_sz;
+	pos = UBIFS_LPT_CRC_BITS;
+	ut_pack(lpt + pnode_sz + nnode_sz, &pos, UBIFS_LPT_LTAB,
+		UBIFS_LPT_TYPE_BITS);
+	for (i = 0; i < UT_LPT_LEBS; i++) {
+		free = i ? img->leb_size :
+		       img->leb_size - ALIGN(lpt_used, img->min_io_size);
+		ut_pack(lpt + pnode_sz + nnode_sz, &pos, free, spc_bits);
+		ut_pack(lpt + pnode_sz + nnode_sz, &pos, 0, spc_bits);
+	}
+	ut_lpt_crc(lpt + pnode_sz + nnode_sz, ltab_sz);
+
+	mst = ut_new_node(img, UBIFS_MST_LNUM, UBIFS_MST_NODE_SZ);
+	mst->highest_inum = cpu_to_le64(UBIFS_FIRST_INO +
+					ARRAY_SIZE(ut_files) - 1);
+	mst->flags = cpu_to_le32(UBIFS_MST_NO_ORPHS);
+	mst->log_lnum = cpu_to_le32(UBIFS_LOG_LNUM);
+	mst->root_lnum = cpu_to_le32(root.lnum);
+	mst->root_offs = cpu_to_le32(root.offs);
+	mst->root_len = cpu_to_le32(root.len);
+	mst->gc_lnum = cpu_to_le32(UT_GC_LNUM);
+	mst->ihead_lnum = cpu_to_le32(UT_IDX_LNUM);
+	mst->ihead_offs = cpu_to_le32(img->leb_size -
+				      ut_leb_free(img, UT_IDX_LNUM));
+	mst->index_size = cpu_to_le64(idx_sz);
+	mst->total_free = cpu_to_le64(total_free);
+	mst->total_dirty = cpu_to_le64(total_dirty);
+	mst->total_used = cpu_to_le64(total_used);
+	mst->lpt_lnum = cpu_to_le32(UT_LPT_LNUM);
+	mst->lpt_offs = cpu_to_le32(pnode_sz);
+	mst->nhead_lnum = cpu_to_le32(UT_LPT_LNUM);
+	mst->nhead_offs = cpu_to_le32(ALIGN(lpt_used, img->min_io_size));
+	mst->ltab_lnum = cpu_to_le32(UT_LPT_LNUM);
+	mst->ltab_offs = cpu_to_le32(pnode_sz + nnode_sz);
+	mst->lscan_lnum = cpu_to_le32(UT_MAIN_LNUM);
+	mst->empty_lebs = cpu_to_le32(empty);
+	mst->idx_lebs = cpu_to_le32(1);
+	mst->leb_cnt = cpu_to_le32(UT_LEB_CNT);
+	ut_add_node(img, UBIFS_MST_LNUM, mst, UBIFS_MST_NODE, UBIFS_MST_NODE_SZ);
+	ut_pad(img, UBIFS_MST_LNUM);
+
+	/* Both master LEBs hold the same node */
+	memcpy(img->buf + (UBIFS_MST_LNUM + 1) * img->leb_size,
+	       img->buf + UBIFS_MST_LNUM * img->leb_size,
+	       img->offs[UBIFS_MST_LNUM]);
+}
+
+static int do_ut_ubifs(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct ubi_device_info di;
+	struct ut_image img;
+	char cmd[80];
+	u8 *expect, *load;
+	int i, size;
+
+	printf("%s: Testing UBIFS\n", __func__);
+
+	if (!getenv("mtdparts"))
+		run_command("mtdparts default", 0);
+	assert(!run_command("ubi part ubi", 0));
+	assert(!ubi_get_device_info(0, &di));
+	run_command("ubi remove " UT_VOLUME, 0);
+
+	memset(&img, 0, sizeof(img));
+	img.leb_size = di.leb_size;
+	img.min_io_size = di.min_io_size;
+	size = UT_LEB_CNT * img.leb_size;
+	img.buf = malloc(size);
+	expect = malloc(UT_FILE_SIZE);
+	load = malloc(UT_FILE_SIZE);
+	assert(img.buf && expect && load);
+	memset(img.buf, 0xff, size);
+	ut_build(&img);
+
+	sprintf(cmd, "ubi create %s %x", UT_VOLUME, size);
+	assert(!run_command(cmd, 0));
+	sprintf(cmd, "ubi write %lx %s %x", (ulong)img.buf, UT_VOLUME, size);
+	assert(!run_command(cmd, 0));
+	assert(!run_command("ubifsmount " UT_VOLUME, 0));
+
+	for (i = 0; i < ARRAY_SIZE(ut_files); i++) {
+		ut_fill(expect, i, 0, UT_FILE_SIZE);
+		memset(load, 0, UT_FILE_SIZE);
+		sprintf(cmd, "ubifsload %lx /%s", (ulong)load,
+			ut_files[i].name);
+		assert(!run_command(cmd, 0));
+		assert(getenv_ulong("filesize", 16, 0) == UT_FILE_SIZE);
+		assert(!memcmp(load, expect, UT_FILE_SIZE));
+	}
+
+	run_command("ubifsumount", 0);
+	run_command("ubi remove " UT_VOLUME, 0);
+	free(load);
+	free(expect);
+	free(img.buf);
+
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_ubifs,	1,	1,	do_ut_ubifs,
+	"Test ubifsload on a generated image",
+	""
+);
@@ -45,6 +45,7 @@
 #endif
 
 #include "fw_env.h"
+#include "search.h"
 
 #define WHITESPACE(c) ((c == '\t') || (c == ' '))
 
@@ -154,6 +155,29 @@ static char *fw_string_blank(char *s, int noblank)
 	return s;
 }
 
+/*
+ * Ethernet Address and serial# can be set only once: returns -1 and sets
+ * errno to EROFS if "name" is one of them and already has value "oldval"
+ */
+static int fw_env_check_overwrite(const char *name, const char *oldval)
+{
+#ifndef CONFIG_ENV_OVERWRITE
+	if (
+	    (strcmp(name, "serial#") == 0) ||
+	    ((strcmp(name, "ethaddr") == 0)
+#if defined(CONFIG_OVERWRITE_ETHADDR_ONCE) && defined(CONFIG_ETHADDR)
+	    && (strcmp(oldval, __stringify(CONFIG_ETHADDR)) != 0)
+#endif /* CONFIG_OVERWRITE_ETHADDR_ONCE && CONFIG_ETHADDR */
+	   ) ) {
+		fprintf (stderr, "Can't overwrite \"%s\"\n", name);
+		errno = EROFS;
+		return -1;
+	}
+#endif /* CONFIG_ENV_OVERWRITE */
+
+	return 0;
+}
+
 /*
  * Search the environment for a variable.
  * Return the value, if found, or NULL, if not found.
@@ -302,22 +326,8 @@ int fw_env_write(char *name, char *value)
 	 * Delete any existing definition
 	 */
 	if (oldval) {
-#ifndef CONFIG_ENV_OVERWRITE
-		/*
-		 * Ethernet Address and serial# can be set only once
-		 */
-		if (
-		    (strcmp(name, "serial#") == 0) ||
-		    ((strcmp(name, "ethaddr") == 0)
-#if defined(CONFIG_OVERWRITE_ETHADDR_ONCE) && defined(CONFIG_ETHADDR)
-		    && (strcmp(oldval, __stringify(CONFIG_ETHADDR)) != 0)
-#endif /* CONFIG_OVERWRITE_ETHADDR_ONCE && CONFIG_ETHADDR */
-		   ) ) {
-			fprintf (stderr, "Can't overwrite \"%s\"\n", name);
-			errno = EROFS;
+		if (fw_env_check_overwrite(name, oldval))
 			return -1;
-		}
-#endif /* CONFIG_ENV_OVERWRITE */
 
 		if (*++nxt == '\0') {
 			*env = '\0';
@@ -369,6 +379,127 @@ int fw_env_write(char *name, char *value)
 	return 0;
 }
 
+/*
+ * Indexed access to the environment, for programs which look up or change
+ * many variables: the environment is read once into a hash table, lookups
+ * do not scan it, and changes are only written back, once, on commit.
+ */
+static struct hsearch_data env_htab;
+static int env_index_dirty;
+
+/*
+ * Read the environment and build the index. Returns 0 if OK, -1 on error.
+ */
+int fw_env_index_open(void)
+{
+	if (fw_env_open())
+		return -1;
+
+	if (!himport_r(&env_htab, environment.data, ENV_SIZE, '\0', 0,
+		       0, NULL, 0)) {
+		fprintf(stderr, "Error: cannot index environment: %s\n",
+			strerror(errno));
+		fw_env_index_close();
+		return -1;
+	}
+	env_index_dirty = 0;
+
+	return 0;
+}
+
+/*
+ * Look up a variable in the index.
+ * Return the value, if found, or NULL, if not found.
+ */
+char *fw_env_index_get(const char *name)
+{
+	ENTRY e, *ep;
+
+	e.key = name;
+	e.data = NULL;
+	hsearch_r(e, FIND, &ep, &env_htab);
+
+	return ep ? ep->data : NULL;
+}
+
+/*
+ * Set a variable in the index, or delete it if "value" is NULL or empty.
+ * Nothing is written to flash until fw_env_index_commit().
+ * Returns 0 if OK, or -1 and sets errno:
+ * EROFS  - certain variables ("ethaddr", "serial#") cannot be
+ *	    modified or deleted
+ * ENOMEM - the index is full
+ */
+int fw_env_index_set(const char *name, const char *value)
+{
+	char *oldval = fw_env_index_get(name);
+	ENTRY e, *ep;
+
+	if (oldval && fw_env_check_overwrite(name, oldval))
+		return -1;
+
+	if (!value || !*value) {
+		if (oldval) {
+			hdelete_r(name, &env_htab, 0);
+			env_index_dirty = 1;
+		}
+		return 0;
+	}
+
+	e.key = name;
+	e.data = (char *)value;
+	hsearch_r(e, ENTER, &ep, &env_htab);
+	if (!ep) {
+		fprintf(stderr, "Error: cannot set \"%s\": %s\n", name,
+			strerror(errno));
+		return -1;
+	}
+	env_index_dirty = 1;
+
+	return 0;
+}
+
+/*
+ * Write the indexed environment back to flash, if it was changed. With a
+ * redundant environment the other copy is written and becomes the active
+ * one, as with fw_setenv.
+ */
+int fw_env_index_commit(void)
+{
+	char *data = environment.data;
+
+	if (!env_index_dirty)
+		return 0;
+
+	if (hexport_r(&env_htab, '\0', &data, ENV_SIZE, 0, NULL) < 0) {
+		fprintf(stderr, "Error: environment overflow\n");
+		return -1;
+	}
+
+	if (fw_env_close())
+		return -1;
+	env_index_dirty = 0;
+
+	/* the copy just written is the current one for the next commit */
+	if (HaveRedundEnv)
+		dev_current = !dev_current;
+
+	return 0;
+}
+
+/*
+ * Drop the index and the environment read by fw_env_index_open(),
+ * discarding any changes not committed.
+ */
+void fw_env_index_close(void)
+{
+	/* a failed import may have left no table behind */
+	if (env_htab.table)
+		hdestroy_r(&env_htab, 0);
+	free(environment.image);
+	environment.image = NULL;
+}
+
 /*
  * Deletes or sets environment variables. Returns -1 and sets errno error codes:
  * 0	  - OK
@@ -449,7 +580,7 @@ int fw_parse_script(char *fname)
 	int len;
 	int ret = 0;
 
-	if (fw_env_open()) {
+	if (fw_env_index_open()) {
 		fprintf(stderr, "Error: environment not initialized\n");
 		return -1;
 	}
@@ -520,9 +651,9 @@ int fw_parse_script(char *fname)
 		 * If there is an error setting a variable,
 		 * try to save the environment and returns an error
 		 */
-		if (fw_env_write(name, val)) {
+		if (fw_env_index_set(name, val)) {
 			fprintf(stderr,
-			"fw_env_write returns with error : %s\n",
+			"fw_env_index_set returns with error : %s\n",
 				strerror(errno));
 			ret = -1;
 			break;
@@ -534,7 +665,8 @@ int fw_parse_script(char *fname)
 	if (strcmp(fname, "-") != 0)
 		fclose(fp);
 
-	ret |= fw_env_close();
+	ret |= fw_env_index_commit();
+	fw_env_index_close();
 
 	return ret;
 
@@ -76,4 +76,14 @@ extern int fw_env_open(void);
 extern int fw_env_write(char *name, char *value);
 extern int fw_env_close(void);
 
+/*
+ * Indexed access: read the environment once, then look up and change
+ * variables in memory and write them back with a single flash update.
+ */
+extern int fw_env_index_open(void);
+extern char *fw_env_index_get(const char *name);
+extern int fw_env_index_set(const char *name, const char *value);
+extern int fw_env_index_commit(void);
+extern void fw_env_index_close(void);
+
 extern unsigned	long  crc32	 (unsigned long, const unsigned char *, unsigned);